@@ -0,0 +1,133 @@
+#include <cstdlib> // abort, EXIT_SUCCESS
+#include <cstdint>
+#include <array>
+#include <vector>
+#include <iostream> // cout, cerr, endl
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "../src/stopwatch.hpp"
+
+#include <fgl/vulkan.hpp>
+
+/* Allocate/free throughput of MemoryArena against one vkAllocateMemory
+	per buffer (the path every Buffer took before the arena existed).*/
+
+uint32_t first_memory_type(
+	const fgl::vulkan::Context& inst,
+	const uint32_t type_bits,
+	const vk::MemoryPropertyFlags flags )
+{
+	const auto props { inst.physical_device.getMemoryProperties() };
+	for( uint32_t index { 0 }; index < props.memoryTypeCount; ++index )
+	{
+		if( ( type_bits & ( 1u << index ) )
+			&& ( props.memoryTypes[index].propertyFlags & flags ) == flags )
+			return index;
+	}
+	throw std::runtime_error( "No memory type for benchmark." );
+}
+
+int main() try
+{
+	fgl::vulkan::AppInfo info(
+		VK_API_VERSION_1_1,
+		{},
+		{},
+		1,
+		0.0
+	);
+
+	fgl::vulkan::Context inst( info );
+
+	constexpr std::array<vk::DeviceSize, 3> sizes { 256, 4096, 256 * 1024 };
+	constexpr std::size_t iterations { 20000 };
+	// stays well under maxMemoryAllocationCount (4096 on most drivers)
+	constexpr std::size_t live_count { 1000 };
+
+	for( const auto bytesize : sizes )
+	{
+		const vk::BufferCreateInfo ci(
+			{}, bytesize, vk::BufferUsageFlagBits::eStorageBuffer, vk::SharingMode::eExclusive
+		);
+		const vk::raii::Buffer probe( inst.device, ci );
+		const vk::MemoryRequirements requirements { probe.getMemoryRequirements() };
+		const uint32_t type_index {
+			first_memory_type( inst, requirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eHostVisible )
+		};
+
+		std::cout << "\n\tBuffer size: " << bytesize << " bytes";
+
+		{
+			stopwatch::Stopwatch watch( "\tvkAllocateMemory alloc/free" );
+			watch.start();
+			for( std::size_t i { 0 }; i < iterations; ++i )
+			{
+				const vk::raii::DeviceMemory memory {
+					inst.device.allocateMemory( vk::MemoryAllocateInfo( requirements.size, type_index ) )
+				};
+			}
+			watch.stop();
+			std::cout << '\n' << watch;
+		}
+
+		{
+			stopwatch::Stopwatch watch( "\tMemoryArena alloc/free" );
+			watch.start();
+			for( std::size_t i { 0 }; i < iterations; ++i )
+			{
+				const auto allocation { inst.arena->allocate( requirements, type_index ) };
+			}
+			watch.stop();
+			std::cout << '\n' << watch;
+		}
+
+		{
+			stopwatch::Stopwatch watch( "\tvkAllocateMemory live set" );
+			std::vector<vk::raii::DeviceMemory> live;
+			live.reserve( live_count );
+			watch.start();
+			for( std::size_t i { 0 }; i < live_count; ++i )
+			{
+				live.emplace_back(
+					inst.device.allocateMemory( vk::MemoryAllocateInfo( requirements.size, type_index ) )
+				);
+			}
+			live.clear();
+			watch.stop();
+			std::cout << '\n' << watch;
+		}
+
+		{
+			stopwatch::Stopwatch watch( "\tMemoryArena live set" );
+			std::vector<fgl::vulkan::Allocation> live;
+			live.reserve( live_count );
+			watch.start();
+			for( std::size_t i { 0 }; i < live_count; ++i )
+			{
+				live.emplace_back( inst.arena->allocate( requirements, type_index ) );
+			}
+			const auto stats { inst.arena->statistics( type_index ) };
+			live.clear();
+			watch.stop();
+			std::cout
+				<< '\n' << watch
+				<< "\n\t\tblocks: " << stats.block_count
+				<< " reserved: " << stats.reserved
+				<< " used: " << stats.used;
+		}
+		std::cout << std::endl;
+	}
+
+	return EXIT_SUCCESS;
+}
+catch( const vk::SystemError& e )
+{
+	std::cerr << "\n\n Vulkan system error code:\t" << e.code() << "\n\t error:" << e.what() << std::endl;
+	std::abort();
+}
+catch( const std::exception& e )
+{
+	std::cerr << "\n\n Exception caught:\n\t" << e.what() << std::endl;
+	std::abort();
+}
@@ -0,0 +1,63 @@
+#ifndef FGL_VULKAN_BENCH_COMMON_HPP_INCLUDED
+#define FGL_VULKAN_BENCH_COMMON_HPP_INCLUDED
+
+#include <cstdlib> // getenv
+#include <cstdint>
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <span>
+#include <string>
+#include <iostream> // cerr, endl
+
+#include "../src/stopwatch.hpp"
+
+// Helpers shared by the benchmarks, each of which is its own executable.
+
+inline uint64_t environment_or( const char* name, const uint64_t fallback )
+{
+	const char* value { std::getenv( name ) };
+	return value ? std::stoull( value ) : fallback;
+}
+
+// in milliseconds
+template <typename F>
+double time_host_once( F&& function )
+{
+	stopwatch::Stopwatch watch( "host" );
+	watch.start();
+	function();
+	watch.stop();
+	return std::chrono::duration<double, std::milli>( watch.getStop() - watch.getStart() ).count();
+}
+
+// best of rounds, in milliseconds
+template <typename F>
+double time_host( const std::size_t rounds, F&& function )
+{
+	double best { std::numeric_limits<double>::max() };
+	for( std::size_t round { 0 }; round < rounds; ++round )
+		best = std::min( best, time_host_once( function ) );
+	return best;
+}
+
+// out[y * n + x] == in[y] * in[x] for every element of the n x n outer product
+inline bool matches_reference( const std::span<const uint32_t> in, const std::span<const uint32_t> out )
+{
+	const std::size_t n { in.size() };
+	for( std::size_t y { 0 }; y < n; ++y )
+	{
+		for( std::size_t x { 0 }; x < n; ++x )
+		{
+			if( out[y * n + x] != in[y] * in[x] )
+			{
+				std::cerr << "\n\tMismatch at (" << x << ", " << y << "): "
+					<< out[y * n + x] << " != " << in[y] * in[x] << std::endl;
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+#endif /* FGL_VULKAN_BENCH_COMMON_HPP_INCLUDED */
@@ -0,0 +1,193 @@
+#include <cstdlib> // abort, getenv, EXIT_SUCCESS
+#include <cstdint>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <future>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility> // move
+#include <vector>
+#include <iostream> // cout, cerr, endl
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "../src/stopwatch.hpp"
+#include "common.hpp"
+
+#include <fgl/vulkan.hpp>
+
+/* Load generator for the Executor: producer threads submit small
+	OuterProduct jobs as fast as the executor takes them, each into one of
+	a few output buffers of its own, so consecutive jobs of a producer
+	conflict (write after write) and others don't. Every output is checked
+	against the CPU at the end.
+
+	Reports jobs/s, how the jobs coalesced into command buffers and the
+	percentiles of each job's latency from submit() to its completion
+	callback, which includes any wait for the memory budget.
+
+	FGL_EXECUTOR_N sets n of each product (256), FGL_EXECUTOR_PRODUCERS the
+	producer threads (4), FGL_EXECUTOR_JOBS the jobs per producer (5000)
+	and FGL_EXECUTOR_BUDGET_MB the memory budget (16; every job counts its
+	output).*/
+
+using Clock = std::chrono::steady_clock;
+
+// of sorted, in milliseconds
+double percentile( const std::vector<double>& sorted, const double fraction )
+{
+	const auto index { static_cast< std::size_t >( fraction * static_cast< double >( sorted.size() - 1 ) ) };
+	return sorted[index];
+}
+
+int main() try
+{
+	fgl::vulkan::AppInfo info(
+		VK_API_VERSION_1_1,
+		{},
+		{},
+		1,
+		0.0
+	);
+
+	const fgl::vulkan::Context inst( info );
+
+	const uint32_t n { static_cast< uint32_t >( environment_or( "FGL_EXECUTOR_N", 256 ) ) };
+	const std::size_t producers { environment_or( "FGL_EXECUTOR_PRODUCERS", 4 ) };
+	const std::size_t jobs_per_producer { environment_or( "FGL_EXECUTOR_JOBS", 5000 ) };
+	const vk::DeviceSize budget { environment_or( "FGL_EXECUTOR_BUDGET_MB", 16 ) * 1024 * 1024 };
+	constexpr std::size_t outputs_per_producer { 4 };
+	if( producers == 0 || jobs_per_producer == 0 )
+		throw std::invalid_argument( "Nothing to submit" );
+	constexpr fgl::vulkan::Kernel kernel { fgl::vulkan::Kernel::eOuterProduct };
+
+	const vk::DeviceSize input_bytes { vk::DeviceSize( n ) * sizeof( uint32_t ) };
+	const vk::DeviceSize output_bytes { input_bytes * n };
+
+	std::vector<fgl::vulkan::Buffer> buffers;
+	buffers.reserve( 1 + producers * outputs_per_producer );
+	buffers.emplace_back( inst, input_bytes, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst, vk::SharingMode::eConcurrent, 0, vk::MemoryPropertyFlagBits::eDeviceLocal, vk::DescriptorType::eStorageBuffer );
+	for( std::size_t i { 0 }; i < producers * outputs_per_producer; ++i )
+		buffers.emplace_back( inst, output_bytes, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferSrc, vk::SharingMode::eConcurrent, 1, vk::MemoryPropertyFlagBits::eDeviceLocal, vk::DescriptorType::eStorageBuffer );
+	const fgl::vulkan::Buffer& input { buffers.at( 0 ) };
+
+	std::vector<uint32_t> input_data( n );
+	for( uint32_t i { 0 }; auto& element : input_data )
+		element = i++ * 2654435761u;
+
+	fgl::vulkan::TransferEngine transfer( inst );
+	transfer.upload( input, std::span<const uint32_t>( input_data ) );
+	transfer.wait();
+
+	constexpr std::array<fgl::vulkan::BindingSlot, 2> bindings { {
+		{ 0, vk::DescriptorType::eStorageBuffer },
+		{ 1, vk::DescriptorType::eStorageBuffer }
+	} };
+	const fgl::vulkan::Pipeline pipeline { fgl::vulkan::make_pipeline( inst, kernel, bindings ) };
+	const auto groups { fgl::vulkan::kernel_group_count( kernel, { n, n, 1 }, pipeline.specialization ) };
+	const fgl::vulkan::OuterProductParameters parameters { n };
+	const auto parameter_bytes { fgl::vulkan::push_constant_bytes( parameters ) };
+
+	fgl::vulkan::ExecutorOptions options {};
+	options.memory_budget = budget;
+	fgl::vulkan::Executor executor( inst, options );
+
+	std::cout
+		<< "\n\t" << producers << " producers x " << jobs_per_producer << " jobs of a " << n << 'x' << n << " product, "
+		<< budget / ( 1024 * 1024 ) << " MB budget (" << budget / output_bytes << " jobs)";
+
+	// indexed by job, each written by its own completion callback
+	std::vector<double> latencies( producers * jobs_per_producer );
+
+	stopwatch::Stopwatch watch( "executor" );
+	watch.start();
+
+	std::vector<std::future<void>> producing;
+	producing.reserve( producers );
+	for( std::size_t producer { 0 }; producer < producers; ++producer )
+	{
+		producing.emplace_back(
+			std::async(
+				std::launch::async,
+				[&, producer]()
+				{
+					std::vector<std::future<void>> done;
+					done.reserve( jobs_per_producer );
+					for( std::size_t i { 0 }; i < jobs_per_producer; ++i )
+					{
+						const fgl::vulkan::Buffer& output { buffers.at( 1 + producer * outputs_per_producer + i % outputs_per_producer ) };
+						fgl::vulkan::ComputeJob job {
+							&pipeline,
+							{ { &input, fgl::vulkan::Access::eRead }, { &output, fgl::vulkan::Access::eWrite } },
+							groups,
+							{ parameter_bytes.begin(), parameter_bytes.end() },
+							output_bytes
+						};
+
+						const auto submitted { Clock::now() };
+						double& latency { latencies[producer * jobs_per_producer + i] };
+						done.emplace_back(
+							executor.submit(
+								std::move( job ),
+								[submitted, &latency]
+								{
+									latency = std::chrono::duration<double, std::milli>( Clock::now() - submitted ).count();
+								}
+							)
+						);
+					}
+
+					for( auto& job : done )
+						job.get();
+				}
+			)
+		);
+	}
+
+	for( auto& producer : producing )
+		producer.get();
+	// the statistics count a batch once all its callbacks ran
+	executor.wait_idle();
+
+	watch.stop();
+	const double seconds { std::chrono::duration<double>( watch.getStop() - watch.getStart() ).count() };
+
+	bool correct { true };
+	std::vector<uint32_t> result( std::size_t( n ) * n );
+	for( std::size_t i { 1 }; i < buffers.size(); ++i )
+	{
+		transfer.download( buffers.at( i ), std::span( result ) );
+		transfer.wait();
+		correct = matches_reference( input_data, result ) && correct;
+	}
+
+	const auto statistics { executor.statistics() };
+	std::ranges::sort( latencies );
+
+	std::cout
+		<< "\n\t" << static_cast< double >( statistics.jobs ) / seconds << " jobs/s (" << statistics.jobs << " in " << seconds << " s)"
+		<< "\n\t" << statistics.batches << " command buffers, "
+		<< static_cast< double >( statistics.jobs ) / static_cast< double >( std::max<uint64_t>( statistics.batches, 1 ) ) << " jobs each, "
+		<< statistics.barriers << " barriers between jobs"
+		<< "\n\tLatency ms: p50 " << percentile( latencies, 0.5 )
+		<< ", p90 " << percentile( latencies, 0.9 )
+		<< ", p99 " << percentile( latencies, 0.99 )
+		<< ", p99.9 " << percentile( latencies, 0.999 )
+		<< ", max " << latencies.back()
+		<< "\n\t" << ( correct ? "Every output matches" : "Outputs DO NOT MATCH" ) << " the CPU reference"
+		<< std::endl;
+
+	return correct ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+catch( const vk::SystemError& e )
+{
+	std::cerr << "\n\n Vulkan system error code:\t" << e.code() << "\n\t error:" << e.what() << std::endl;
+	std::abort();
+}
+catch( const std::exception& e )
+{
+	std::cerr << "\n\n Exception caught:\n\t" << e.what() << std::endl;
+	std::abort();
+}
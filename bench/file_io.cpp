@@ -0,0 +1,183 @@
+#include <cstdlib> // abort, getenv, EXIT_SUCCESS
+#include <cstdint>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <numeric>
+#include <span>
+#include <string>
+#include <vector>
+#include <iostream> // cout, cerr, endl
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "../src/stopwatch.hpp"
+#include "common.hpp"
+
+#include <fgl/vulkan.hpp>
+
+/* Disk -> GPU -> disk without heap copies: a file of random uint32_t is
+	mapped and loaded into a device local buffer, scanned (inclusive sum)
+	there, and the result stored straight into a mapped output file, which
+	is checked against std::inclusive_scan over the input mapping.
+
+	When the device has VK_EXT_external_memory_host the input mapping is
+	also imported as a buffer and copied on the device, skipping the
+	staging ring entirely; drivers that only import anonymous memory
+	refuse it, which is reported rather than treated as a failure.
+
+	FGL_FILE_N sets the element count (64M, 256 MB, by default).*/
+
+void print_rate( const std::string& name, const std::size_t bytes, const double ms )
+{
+	std::cout << "\n\t" << name << ": " << ms << " ms, " << static_cast< double >( bytes ) / ms / 1e6 << " GB/s";
+}
+
+int main() try
+{
+	fgl::vulkan::AppInfo info(
+		VK_API_VERSION_1_1,
+		{},
+		{},
+		1,
+		0.0
+	);
+
+	const fgl::vulkan::Context inst( info );
+
+	const char* count { std::getenv( "FGL_FILE_N" ) };
+	const uint32_t n { count ? static_cast< uint32_t >( std::stoul( count ) ) : 1u << 26 };
+	const std::size_t bytesize { std::size_t( n ) * sizeof( uint32_t ) };
+	const std::filesystem::path input_path { "file_io.in" };
+	const std::filesystem::path output_path { "file_io.out" };
+
+	{
+		const fgl::vulkan::MappedFile file( input_path, bytesize );
+		uint32_t state { 2463534242u };
+		for( auto& element : file.writable_view<uint32_t>() )
+		{
+			// xorshift32, kept small so the sums stay meaningful
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			element = state & 0xFFFF;
+		}
+		file.flush();
+	}
+
+	constexpr vk::BufferUsageFlags usage {
+		vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc
+	};
+	std::vector<fgl::vulkan::Buffer> buffers;
+	buffers.reserve( 2 );
+	buffers.emplace_back( inst, bytesize, usage, vk::SharingMode::eConcurrent, 0, vk::MemoryPropertyFlagBits::eDeviceLocal, vk::DescriptorType::eStorageBuffer );
+	buffers.emplace_back( inst, bytesize, usage, vk::SharingMode::eConcurrent, 1, vk::MemoryPropertyFlagBits::eDeviceLocal, vk::DescriptorType::eStorageBuffer );
+	const fgl::vulkan::Buffer& input { buffers.at( 0 ) };
+	const fgl::vulkan::Buffer& output { buffers.at( 1 ) };
+
+	fgl::vulkan::TransferEngine transfer( inst );
+	fgl::vulkan::QueueScheduler scheduler( inst );
+	fgl::vulkan::Scan scan( inst, fgl::vulkan::ReduceOperation::eSum, n );
+
+	// the mappings close before the files are removed (Windows won't delete mapped files)
+	bool correct { false };
+	{
+		const fgl::vulkan::MappedFile input_file( input_path );
+		const fgl::vulkan::MappedFile output_file( output_path, bytesize );
+
+		print_rate( "file -> GPU",
+			bytesize,
+			time_host_once(
+				[&]()
+				{
+					fgl::vulkan::load_file( transfer, input_file, input );
+					transfer.wait();
+				}
+			)
+		);
+
+		scan.run( scheduler, input, output, n );
+
+		print_rate( "GPU -> file",
+			bytesize,
+			time_host_once(
+				[&]()
+				{
+					fgl::vulkan::store_file( transfer, output, output_file );
+					transfer.wait();
+					output_file.flush();
+				}
+			)
+		);
+
+		const auto input_values { input_file.view<uint32_t>() };
+		std::vector<uint32_t> expected( n );
+		std::inclusive_scan( input_values.begin(), input_values.end(), expected.begin() );
+		const bool matches { std::ranges::equal( output_file.view<uint32_t>(), expected ) };
+		std::cout << "\n\tScanned file " << ( matches ? "matches" : "DOES NOT MATCH" ) << " std::inclusive_scan";
+
+		correct = matches;
+		if( fgl::vulkan::ImportedBuffer::can_import( inst, input_file.bytes() ) )
+		{
+			try
+			{
+				const fgl::vulkan::ImportedBuffer imported( inst, input_file.bytes(), vk::BufferUsageFlagBits::eTransferSrc, 0 );
+
+				// the file's pages copied on the device, then scanned again from there
+				scheduler.submit(
+					[&]( const vk::raii::CommandBuffer& buffer )
+					{
+						buffer.fillBuffer( *output.buffer, 0, VK_WHOLE_SIZE, 0 );
+					}
+				).wait();
+				print_rate( "imported file -> GPU",
+					bytesize,
+					time_host_once(
+						[&]()
+						{
+							scheduler.submit(
+								[&]( const vk::raii::CommandBuffer& buffer )
+								{
+									buffer.copyBuffer( *imported.buffer, *input.buffer, vk::BufferCopy( 0, 0, bytesize ) );
+								}
+							).wait();
+						}
+					)
+				);
+
+				scan.run( scheduler, input, output, n );
+				std::vector<uint32_t> gpu( n );
+				transfer.download( output, std::span( gpu ) );
+				transfer.wait();
+
+				const bool imported_matches { gpu == expected };
+				correct = correct && imported_matches;
+				std::cout << "\n\tScan of the imported file " << ( imported_matches ? "matches" : "DOES NOT MATCH" );
+			}
+			catch( const vk::SystemError& e )
+			{
+				std::cout << "\n\tThe driver refused to import the file mapping: " << e.what();
+			}
+		}
+		else
+		{
+			std::cout << "\n\tVK_EXT_external_memory_host unavailable or the file isn't aligned for it";
+		}
+		std::cout << std::endl;
+	}
+
+	std::filesystem::remove( input_path );
+	std::filesystem::remove( output_path );
+
+	return correct ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+catch( const vk::SystemError& e )
+{
+	std::cerr << "\n\n Vulkan system error code:\t" << e.code() << "\n\t error:" << e.what() << std::endl;
+	std::abort();
+}
+catch( const std::exception& e )
+{
+	std::cerr << "\n\n Exception caught:\n\t" << e.what() << std::endl;
+	std::abort();
+}
@@ -0,0 +1,136 @@
+#include <cstdlib> // abort, getenv, EXIT_SUCCESS
+#include <cstdint>
+#include <array>
+#include <chrono>
+#include <span>
+#include <string>
+#include <vector>
+#include <iostream> // cout, cerr, endl
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "../src/stopwatch.hpp"
+#include "common.hpp"
+
+#include <fgl/vulkan.hpp>
+
+/* Repeated n x n OuterProducts through a FrameRing, once per depth: every
+	iteration writes a fresh input on the host, and every result is checked
+	against the CPU as it is read back, so host work and GPU work are about
+	the same size. With depth 1 they take turns; deeper rings overlap the
+	host's upload and check of one iteration with the GPU running the next,
+	and the copies of neighbouring iterations with the dispatches between
+	them.
+
+	Reports iterations/s per depth. FGL_RING_N sets n (1024),
+	FGL_RING_ITERATIONS the iterations per depth (64).*/
+
+// iteration k's input
+uint32_t input_element( const uint64_t k, const std::size_t i )
+{
+	return static_cast< uint32_t >( ( i + k ) * 2654435761u );
+}
+
+int main() try
+{
+	fgl::vulkan::AppInfo info(
+		VK_API_VERSION_1_1,
+		{},
+		{},
+		1,
+		0.0
+	);
+
+	const fgl::vulkan::Context inst( info );
+
+	const uint32_t n { static_cast< uint32_t >( environment_or( "FGL_RING_N", 1024 ) ) };
+	const uint64_t iterations { environment_or( "FGL_RING_ITERATIONS", 64 ) };
+	constexpr fgl::vulkan::Kernel kernel { fgl::vulkan::Kernel::eOuterProduct };
+
+	const vk::DeviceSize input_bytes { vk::DeviceSize( n ) * sizeof( uint32_t ) };
+	const std::array<fgl::vulkan::FrameBufferInfo, 2> layout { {
+		{ 0, input_bytes, fgl::vulkan::FrameTransfer::eUpload },
+		{ 1, input_bytes * n, fgl::vulkan::FrameTransfer::eDownload }
+	} };
+
+	constexpr std::array<fgl::vulkan::BindingSlot, 2> bindings { {
+		{ 0, vk::DescriptorType::eStorageBuffer },
+		{ 1, vk::DescriptorType::eStorageBuffer }
+	} };
+	const fgl::vulkan::Pipeline pipeline { fgl::vulkan::make_pipeline( inst, kernel, bindings ) };
+	const auto groups { fgl::vulkan::kernel_group_count( kernel, { n, n, 1 }, pipeline.specialization ) };
+	const fgl::vulkan::OuterProductParameters parameters { n };
+	const auto parameter_bytes { fgl::vulkan::push_constant_bytes( parameters ) };
+
+	std::cout << "\n\t" << iterations << " iterations of a " << n << 'x' << n << " product";
+
+	bool correct { true };
+	for( const std::size_t depth : { std::size_t( 1 ), std::size_t( 2 ), fgl::vulkan::FrameRing::default_depth } )
+	{
+		fgl::vulkan::FrameRing ring( inst, layout, depth );
+
+		uint64_t checked { 0 };
+		std::vector<uint32_t> input( n ); // of the iteration being checked
+		const auto check {
+			[&]( const fgl::vulkan::FrameRing::Frame& frame )
+			{
+				const uint64_t k { *frame.completed_iteration() };
+				for( std::size_t i { 0 }; auto& element : input )
+					element = input_element( k, i++ );
+
+				if( !matches_reference( input, frame.readback_view<uint32_t>( 1 ) ) )
+				{
+					std::cerr << "\tin iteration " << k << std::endl;
+					correct = false;
+				}
+				++checked;
+			}
+		};
+
+		stopwatch::Stopwatch watch( "frame ring" );
+		watch.start();
+
+		for( uint64_t k { 0 }; k < iterations; ++k )
+		{
+			auto& frame { ring.acquire() };
+			if( frame.completed_iteration() )
+				check( frame );
+
+			for( std::size_t i { 0 }; auto& element : frame.upload_view<uint32_t>( 0 ) )
+				element = input_element( k, i++ );
+
+			ring.submit(
+				frame,
+				[&]( const vk::raii::CommandBuffer& buffer, const fgl::vulkan::FrameRing::Frame& current )
+				{
+					fgl::vulkan::record_dispatch( buffer, pipeline, ring.descriptor_set( pipeline, current ), groups[0], groups[1], groups[2], parameter_bytes );
+				}
+			);
+		}
+		ring.drain( check );
+
+		watch.stop();
+		const double seconds { std::chrono::duration<double>( watch.getStop() - watch.getStart() ).count() };
+
+		if( checked != iterations )
+			correct = false;
+
+		std::cout
+			<< "\n\tDepth " << depth << ": " << static_cast< double >( iterations ) / seconds << " iterations/s ("
+			<< seconds * 1e3 << " ms)";
+	}
+
+	std::cout << "\n\t" << ( correct ? "Every iteration matches" : "Iterations DO NOT MATCH" ) << " the CPU reference" << std::endl;
+
+	return correct ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+catch( const vk::SystemError& e )
+{
+	std::cerr << "\n\n Vulkan system error code:\t" << e.code() << "\n\t error:" << e.what() << std::endl;
+	std::abort();
+}
+catch( const std::exception& e )
+{
+	std::cerr << "\n\n Exception caught:\n\t" << e.what() << std::endl;
+	std::abort();
+}
@@ -0,0 +1,152 @@
+#include <cstdlib> // abort, EXIT_SUCCESS
+#include <cstdint>
+#include <array>
+#include <chrono>
+#include <memory>
+#include <span>
+#include <vector>
+#include <iostream> // cout, cerr, endl
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "common.hpp"
+
+#include <fgl/vulkan.hpp>
+
+/* The OuterProduct kernel spread over every compute capable device by a
+	DeviceGroup, each device computing a band of output rows and
+	downloading it into its part of the host result, which is checked
+	against a CPU reference after the last round.
+
+	The shares start even and follow each device's measured rows/s from
+	the second round on. Every round counts what a caller would pay:
+	allocating the band, the dispatch and the download.
+
+	Without several GPUs, set FGL_CONTEXTS_PER_DEVICE to put several
+	Contexts on the one device there is; that runs the same partitioning
+	and gathering on a CPU-only machine with lavapipe.*/
+
+// per device: the input and everything that outlives a round
+struct DeviceState
+{
+	fgl::vulkan::Buffer input;
+	fgl::vulkan::TransferEngine transfer;
+	fgl::vulkan::DescriptorSetCache sets;
+	const fgl::vulkan::Pipeline pipeline;
+
+	[[nodiscard]] explicit DeviceState(
+		const fgl::vulkan::Context& context,
+		const std::span<const uint32_t> data,
+		const std::span<const fgl::vulkan::BindingSlot> bindings )
+		:
+		input( context, data.size_bytes(), vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst, vk::SharingMode::eConcurrent, 0, vk::MemoryPropertyFlagBits::eDeviceLocal, vk::DescriptorType::eStorageBuffer ),
+		transfer( context ),
+		sets( context ),
+		pipeline( fgl::vulkan::make_pipeline( context, fgl::vulkan::Kernel::eOuterProduct, bindings ) )
+	{
+		transfer.upload( input, data );
+		transfer.wait();
+	}
+};
+
+int main() try
+{
+	fgl::vulkan::AppInfo info(
+		VK_API_VERSION_1_1,
+		{},
+		{},
+		1,
+		0.0
+	);
+
+	const char* contexts { std::getenv( "FGL_CONTEXTS_PER_DEVICE" ) };
+	fgl::vulkan::DeviceGroup group( info, 0, contexts ? static_cast< uint32_t >( std::atoi( contexts ) ) : 1 );
+	group.print_devices();
+
+	constexpr uint32_t n { 8191 };
+	constexpr std::size_t rounds { 6 };
+	constexpr fgl::vulkan::Kernel kernel { fgl::vulkan::Kernel::eOuterProduct };
+	constexpr std::array<fgl::vulkan::BindingSlot, 2> bindings { {
+		{ 0, vk::DescriptorType::eStorageBuffer },
+		{ 1, vk::DescriptorType::eStorageBuffer }
+	} };
+
+	// bands in whole tiles, so only the last one has a ragged edge
+	const auto& outer_product { fgl::vulkan::kernel_info( kernel ) };
+	const uint32_t tile_rows { outer_product.workgroup_size[1] * outer_product.outputs_per_invocation[1] };
+
+	std::vector<uint32_t> input( n );
+	for( uint32_t i { 0 }; auto& element : input )
+		element = i++ * 2654435761u; // spread over the whole 32-bit range
+
+	std::vector<std::unique_ptr<DeviceState>> states;
+	for( std::size_t device { 0 }; device < group.size(); ++device )
+		states.emplace_back( std::make_unique<DeviceState>( group.context( device ), std::span<const uint32_t>( input ), bindings ) );
+
+	std::vector<uint32_t> output( vk::DeviceSize( n ) * n );
+
+	const fgl::vulkan::DeviceGroup::SliceJob job {
+		[&]( const fgl::vulkan::DeviceGroup::Slice& slice, const fgl::vulkan::Context& context, fgl::vulkan::QueueScheduler& scheduler )
+		{
+			DeviceState& state { *states.at( slice.device ) };
+			const fgl::vulkan::Buffer band(
+				context,
+				vk::DeviceSize( slice.count ) * n * sizeof( uint32_t ),
+				vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferSrc,
+				vk::SharingMode::eConcurrent,
+				1,
+				vk::MemoryPropertyFlagBits::eDeviceLocal,
+				vk::DescriptorType::eStorageBuffer
+			);
+
+			const std::array<fgl::vulkan::BufferBinding, 2> buffers { {
+				{ 0, vk::DescriptorType::eStorageBuffer, *state.input.buffer },
+				{ 1, vk::DescriptorType::eStorageBuffer, *band.buffer }
+			} };
+			const vk::DescriptorSet set { state.sets.get( state.pipeline, buffers ) };
+
+			const fgl::vulkan::OuterProductParameters parameters { n, slice.first, slice.count };
+			const auto groups { fgl::vulkan::kernel_group_count( kernel, { n, slice.count, 1 }, state.pipeline.specialization ) };
+
+			scheduler.submit(
+				[&]( const vk::raii::CommandBuffer& buffer )
+				{
+					fgl::vulkan::record_dispatch( buffer, state.pipeline, set, groups[0], groups[1], groups[2], fgl::vulkan::push_constant_bytes( parameters ) );
+				}
+			).wait();
+
+			state.transfer.download( band, std::span( output ).subspan( vk::DeviceSize( slice.first ) * n, vk::DeviceSize( slice.count ) * n ) );
+			state.transfer.wait();
+			state.sets.evict( *band.buffer );
+		}
+	};
+
+	for( std::size_t round { 0 }; round < rounds; ++round )
+	{
+		const auto start { std::chrono::steady_clock::now() };
+		const auto slices { group.run( n, job, tile_rows ) };
+		const std::chrono::duration<double, std::milli> elapsed { std::chrono::steady_clock::now() - start };
+
+		std::cout << "\n\tRound " << round << ": " << elapsed.count() << " ms,";
+		for( const auto& slice : slices )
+			std::cout << " [" << slice.device << "]=" << slice.count << " rows";
+	}
+	std::cout << std::endl;
+
+	const bool correct { matches_reference( input, output ) };
+	std::cout << "\n\tOuterProduct over " << group.size() << " device(s): "
+		<< ( correct ? "matches" : "DOES NOT MATCH" ) << " the CPU reference" << std::endl;
+	group.print_devices();
+
+	return correct ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+catch( const vk::SystemError& e )
+{
+	std::cerr << "\n\n Vulkan system error code:\t" << e.code() << "\n\t error:" << e.what() << std::endl;
+	std::abort();
+}
+catch( const std::exception& e )
+{
+	std::cerr << "\n\n Exception caught:\n\t" << e.what() << std::endl;
+	std::abort();
+}
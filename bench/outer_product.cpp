@@ -0,0 +1,126 @@
+#include <cstdlib> // abort, EXIT_SUCCESS
+#include <cstdint>
+#include <array>
+#include <string>
+#include <vector>
+#include <iostream> // cout, cerr, endl
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "../src/stopwatch.hpp"
+#include "common.hpp"
+
+#include <fgl/vulkan.hpp>
+
+/* Throughput of the tiled OuterProduct kernel against Square.comp on the
+	same n x n product, with both outputs checked against a CPU reference.
+
+	GB/s counts the input read once and the output written once; GOPS
+	counts one multiply per output element.*/
+
+int main() try
+{
+	fgl::vulkan::AppInfo info(
+		VK_API_VERSION_1_1,
+		{},
+		{},
+		1,
+		0.0
+	);
+
+	const fgl::vulkan::Context inst( info );
+
+	// not a multiple of any tile so the ragged edges get checked as well
+	constexpr uint32_t n { 4099 };
+	constexpr std::size_t rounds { 20 };
+	constexpr vk::DeviceSize insize { n * sizeof( uint32_t ) };
+	constexpr vk::DeviceSize outsize { vk::DeviceSize( n ) * n * sizeof( uint32_t ) };
+
+	std::vector<fgl::vulkan::Buffer> buffers;
+	buffers.reserve( 2 );
+	buffers.emplace_back( inst, insize, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst, vk::SharingMode::eConcurrent, 0, vk::MemoryPropertyFlagBits::eDeviceLocal, vk::DescriptorType::eStorageBuffer );
+	buffers.emplace_back( inst, outsize, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst, vk::SharingMode::eConcurrent, 1, vk::MemoryPropertyFlagBits::eDeviceLocal, vk::DescriptorType::eStorageBuffer );
+
+	fgl::vulkan::Profiler profiler( inst );
+	fgl::vulkan::TransferEngine transfer( inst );
+	fgl::vulkan::QueueScheduler scheduler( inst );
+
+	std::vector<uint32_t> input( n );
+	for( uint32_t i { 0 }; auto& element : input )
+		element = i++ * 2654435761u; // spread over the whole 32-bit range
+
+	transfer.upload( buffers.at( 0 ), std::span<const uint32_t>( input ) );
+	transfer.wait();
+
+	const fgl::vulkan::OuterProductParameters parameters { n };
+	const auto push_constants { fgl::vulkan::push_constant_bytes( parameters ) };
+
+	constexpr std::array kernels { fgl::vulkan::Kernel::eSquare, fgl::vulkan::Kernel::eOuterProduct };
+	bool correct { true };
+	for( const auto kernel : kernels )
+	{
+		const std::string name { fgl::vulkan::kernel_info( kernel ).name };
+		const fgl::vulkan::Pipeline pipeline { fgl::vulkan::make_pipeline( inst, kernel, buffers ) };
+		const auto groups { fgl::vulkan::kernel_group_count( kernel, { n, n, 1 }, pipeline.specialization ) };
+
+		// zero the output so each kernel is checked on its own results
+		scheduler.submit(
+			[&]( const vk::raii::CommandBuffer& buffer )
+			{
+				buffer.fillBuffer( *buffers.at( 1 ).buffer, 0, VK_WHOLE_SIZE, 0 );
+				const vk::MemoryBarrier barrier(
+					vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderWrite
+				);
+				buffer.pipelineBarrier(
+					vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader,
+					{}, barrier, nullptr, nullptr
+				);
+			}
+		).wait();
+
+		for( std::size_t round { 0 }; round < rounds; ++round )
+		{
+			scheduler.submit(
+				[&]( const vk::raii::CommandBuffer& buffer )
+				{
+					profiler.record_dispatch( buffer, name, pipeline, groups[0], groups[1], groups[2], push_constants );
+				}
+			).wait();
+		}
+
+		std::vector<uint32_t> output( vk::DeviceSize( n ) * n );
+		transfer.download( buffers.at( 1 ), std::span( output ) );
+		transfer.wait();
+
+		const bool matches { matches_reference( input, output ) };
+		correct = correct && matches;
+		std::cout << "\n\t" << name << ": " << ( matches ? "matches" : "DOES NOT MATCH" ) << " the CPU reference";
+	}
+	std::cout << std::endl;
+
+	profiler.resolve();
+	for( const auto& [name, stats] : profiler.kernel_statistics() )
+	{
+		const double seconds { stats.median_ms / 1000.0 };
+		const double bytes { static_cast< double >( insize + outsize ) };
+		const double outputs { static_cast< double >( n ) * n };
+		std::cout
+			<< "\n\t" << name << " (" << n << 'x' << n << ", median of " << stats.runs << "): "
+			<< stats.median_ms << " ms, "
+			<< bytes / seconds / 1e9 << " GB/s, "
+			<< outputs / seconds / 1e9 << " GOPS";
+	}
+	std::cout << std::endl;
+
+	return correct ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+catch( const vk::SystemError& e )
+{
+	std::cerr << "\n\n Vulkan system error code:\t" << e.code() << "\n\t error:" << e.what() << std::endl;
+	std::abort();
+}
+catch( const std::exception& e )
+{
+	std::cerr << "\n\n Exception caught:\n\t" << e.what() << std::endl;
+	std::abort();
+}
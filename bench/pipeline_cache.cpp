@@ -0,0 +1,83 @@
+#include <cstdlib> // abort, EXIT_SUCCESS
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <iostream> // cout, cerr, endl
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "../src/stopwatch.hpp"
+
+#include <fgl/vulkan.hpp>
+
+/* Startup cost of Context creation + first pipeline with an empty
+	pipeline cache (cold) against one loaded from disk (warm).
+
+	Drivers keep their own shader caches which hide the difference;
+	disable them for a fair cold number, e.g.
+	MESA_SHADER_CACHE_DISABLE=true, __GL_SHADER_DISK_CACHE=0 or
+	AMD_VK_PIPELINE_CACHE_FILENAME pointing at an empty directory.*/
+
+void create_pipeline( const std::filesystem::path& cache_path, stopwatch::Stopwatch& watch )
+{
+	fgl::vulkan::AppInfo info(
+		VK_API_VERSION_1_1,
+		{},
+		{},
+		1,
+		0.0,
+		cache_path
+	);
+
+	watch.start();
+	const fgl::vulkan::Context inst( info );
+
+	std::vector<fgl::vulkan::Buffer> buffers;
+	buffers.reserve( 2 );
+	buffers.emplace_back( inst, 1024, vk::BufferUsageFlagBits::eStorageBuffer, vk::SharingMode::eExclusive, 0, vk::MemoryPropertyFlagBits::eDeviceLocal, vk::DescriptorType::eStorageBuffer );
+	buffers.emplace_back( inst, 1024, vk::BufferUsageFlagBits::eStorageBuffer, vk::SharingMode::eExclusive, 1, vk::MemoryPropertyFlagBits::eDeviceLocal, vk::DescriptorType::eStorageBuffer );
+
+	const fgl::vulkan::Pipeline pipeline( inst, std::filesystem::path( "Square.spv" ), std::string( "main" ), buffers, sizeof( uint32_t ) ); // matrixsize
+	watch.stop();
+	// inst saves the cache here, outside of the measurement
+}
+
+int main() try
+{
+	constexpr std::size_t rounds { 5 };
+	const std::filesystem::path cache_path {
+		std::filesystem::temp_directory_path() / "fvulkan_bench_pipeline.cache"
+	};
+
+	for( std::size_t round { 0 }; round < rounds; ++round )
+	{
+		std::filesystem::remove( cache_path );
+
+		stopwatch::Stopwatch cold( "\tcold (no cache file)" );
+		create_pipeline( cache_path, cold );
+
+		stopwatch::Stopwatch warm( "\twarm (cache loaded)" );
+		create_pipeline( cache_path, warm );
+
+		std::cout
+			<< "\n\tRound " << round + 1
+			<< " (" << std::filesystem::file_size( cache_path ) << " byte cache)"
+			<< '\n' << cold
+			<< '\n' << warm
+			<< std::endl;
+	}
+
+	std::filesystem::remove( cache_path );
+	return EXIT_SUCCESS;
+}
+catch( const vk::SystemError& e )
+{
+	std::cerr << "\n\n Vulkan system error code:\t" << e.code() << "\n\t error:" << e.what() << std::endl;
+	std::abort();
+}
+catch( const std::exception& e )
+{
+	std::cerr << "\n\n Exception caught:\n\t" << e.what() << std::endl;
+	std::abort();
+}
@@ -0,0 +1,226 @@
+#include <cstdlib> // abort, getenv, EXIT_SUCCESS
+#include <cstdint>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <future>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <tuple> // ignore
+#include <vector>
+#include <iostream> // cout, cerr, endl
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "../src/stopwatch.hpp"
+#include "common.hpp"
+
+#include <fgl/vulkan.hpp>
+
+/* An n x n OuterProduct split into bands of rows, each band recorded as
+	its own secondary command buffer by a ParallelRecorder, three ways:
+	every band on the main thread through one lease, spread over the
+	recording threads by record_parallel(), and by producer threads that
+	each lease a pool and submit every band on its own through the
+	lock-free queue. Each way is checked against the CPU after its rounds.
+
+	Times run from the first recorded band to the last one completing,
+	best of rounds, so the many small bands keep recording and submission
+	cost visible next to the GPU time; the producers' rounds include
+	starting their threads. FGL_RECORD_N sets n (2048, rounded up to a
+	multiple of 64) and FGL_RECORD_THREADS the recording and producer
+	threads (the hardware concurrency).*/
+
+int main() try
+{
+	fgl::vulkan::AppInfo info(
+		VK_API_VERSION_1_1,
+		{},
+		{},
+		1,
+		0.0
+	);
+
+	const fgl::vulkan::Context inst( info );
+
+	const uint32_t n { static_cast< uint32_t >( ( environment_or( "FGL_RECORD_N", 2048 ) + 63 ) / 64 * 64 ) };
+	constexpr std::size_t rounds { 10 };
+	constexpr fgl::vulkan::Kernel kernel { fgl::vulkan::Kernel::eOuterProduct };
+
+	const auto& outer_product { fgl::vulkan::kernel_info( kernel ) };
+	const uint32_t band_rows { outer_product.workgroup_size[1] * outer_product.outputs_per_invocation[1] };
+	const uint32_t bands { ( n + band_rows - 1 ) / band_rows };
+	const vk::DeviceSize row_bytes { vk::DeviceSize( n ) * sizeof( uint32_t ) };
+	if( ( row_bytes * band_rows ) % inst.properties.limits.minStorageBufferOffsetAlignment != 0 )
+		throw std::runtime_error( "Bands of the output don't meet minStorageBufferOffsetAlignment" );
+
+	std::vector<fgl::vulkan::Buffer> buffers;
+	buffers.reserve( 2 );
+	buffers.emplace_back( inst, row_bytes, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst, vk::SharingMode::eConcurrent, 0, vk::MemoryPropertyFlagBits::eDeviceLocal, vk::DescriptorType::eStorageBuffer );
+	buffers.emplace_back( inst, row_bytes * n, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc, vk::SharingMode::eConcurrent, 1, vk::MemoryPropertyFlagBits::eDeviceLocal, vk::DescriptorType::eStorageBuffer );
+	const fgl::vulkan::Buffer& input { buffers.at( 0 ) };
+	const fgl::vulkan::Buffer& output { buffers.at( 1 ) };
+
+	std::vector<uint32_t> input_data( n );
+	for( uint32_t i { 0 }; auto& element : input_data )
+		element = i++ * 2654435761u;
+
+	fgl::vulkan::TransferEngine transfer( inst );
+	transfer.upload( input, std::span<const uint32_t>( input_data ) );
+	transfer.wait();
+
+	constexpr std::array<fgl::vulkan::BindingSlot, 2> bindings { {
+		{ 0, vk::DescriptorType::eStorageBuffer },
+		{ 1, vk::DescriptorType::eStorageBuffer }
+	} };
+	const fgl::vulkan::Pipeline pipeline { fgl::vulkan::make_pipeline( inst, kernel, bindings ) };
+	fgl::vulkan::DescriptorSetCache sets( inst );
+
+	// one job per band, writing it through a binding that starts at its first row
+	std::vector<fgl::vulkan::ParallelRecorder::Recorder> jobs;
+	jobs.reserve( bands );
+	for( uint32_t first { 0 }; first < n; first += band_rows )
+	{
+		jobs.emplace_back(
+			[&, first]( const vk::raii::CommandBuffer& buffer )
+			{
+				const uint32_t rows { std::min( band_rows, n - first ) };
+				const std::array<fgl::vulkan::BufferBinding, 2> bound { {
+					{ 0, vk::DescriptorType::eStorageBuffer, *input.buffer },
+					{ 1, vk::DescriptorType::eStorageBuffer, *output.buffer, first * row_bytes, rows * row_bytes }
+				} };
+				const fgl::vulkan::OuterProductParameters parameters { n, first, rows };
+				const auto groups { fgl::vulkan::kernel_group_count( kernel, { n, rows, 1 }, pipeline.specialization ) };
+				fgl::vulkan::record_dispatch( buffer, pipeline, sets.get( pipeline, bound ), groups[0], groups[1], groups[2], fgl::vulkan::push_constant_bytes( parameters ) );
+			}
+		);
+	}
+
+	fgl::vulkan::ParallelRecorder recorder( inst, environment_or( "FGL_RECORD_THREADS", 0 ) );
+
+	// records one secondary on the main thread and waits for it
+	const auto run_once {
+		[&]( const fgl::vulkan::ParallelRecorder::Recorder& record )
+		{
+			std::vector<fgl::vulkan::SecondaryCommands> commands;
+			{
+				const auto lease { recorder.lease() };
+				commands.emplace_back( lease.record( record ) );
+			}
+			recorder.submit( std::move( commands ) ).wait();
+		}
+	};
+
+	std::vector<uint32_t> result( std::size_t( n ) * n );
+	const auto measure {
+		[&]( const std::string& name, const auto& round )
+		{
+			run_once(
+				[&]( const vk::raii::CommandBuffer& buffer )
+				{
+					buffer.fillBuffer( *output.buffer, 0, VK_WHOLE_SIZE, 0 );
+					const vk::MemoryBarrier barrier( vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderWrite );
+					buffer.pipelineBarrier( vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, {}, barrier, nullptr, nullptr );
+				}
+			);
+
+			const uint64_t submits { recorder.queue_submissions() };
+			const double ms { time_host( rounds, round ) };
+			const uint64_t round_submits { recorder.queue_submissions() - submits };
+
+			run_once(
+				[&]( const vk::raii::CommandBuffer& buffer )
+				{
+					const vk::MemoryBarrier barrier( vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eTransferRead );
+					buffer.pipelineBarrier( vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eTransfer, {}, barrier, nullptr, nullptr );
+				}
+			);
+			transfer.download( output, std::span( result ) );
+			transfer.wait();
+			const bool matches { matches_reference( input_data, result ) };
+
+			std::cout
+				<< "\n\t" << name << ( matches ? "" : " (DOES NOT MATCH)" ) << ": "
+				<< ms << " ms, " << static_cast< double >( bands ) / ms * 1e3 << " bands/s, "
+				<< static_cast< double >( round_submits ) / static_cast< double >( rounds ) << " vkQueueSubmit per round";
+			return matches;
+		}
+	};
+
+	std::cout
+		<< "\n\t" << n << 'x' << n << " product in " << bands << " bands of " << band_rows << " rows, "
+		<< recorder.recording_threads() << " recording threads";
+
+	bool correct { true };
+
+	correct = measure(
+		"Main thread",
+		[&]()
+		{
+			std::vector<fgl::vulkan::SecondaryCommands> commands;
+			commands.reserve( bands );
+			{
+				const auto lease { recorder.lease() };
+				for( const auto& job : jobs )
+					commands.emplace_back( lease.record( job ) );
+			}
+			recorder.submit( std::move( commands ) ).wait();
+		}
+	) && correct;
+
+	correct = measure(
+		"record_parallel",
+		[&]()
+		{
+			recorder.record_parallel( jobs ).wait();
+		}
+	) && correct;
+
+	correct = measure(
+		"Producer threads",
+		[&]()
+		{
+			const std::size_t producers { recorder.recording_threads() };
+			std::vector<std::future<void>> producing;
+			producing.reserve( producers );
+			for( std::size_t producer { 0 }; producer < producers; ++producer )
+			{
+				producing.emplace_back(
+					std::async(
+						std::launch::async,
+						[&, producer]()
+						{
+							const auto lease { recorder.lease() };
+							for( std::size_t band { jobs.size() * producer / producers }; band < jobs.size() * ( producer + 1 ) / producers; ++band )
+							{
+								std::vector<fgl::vulkan::SecondaryCommands> commands;
+								commands.emplace_back( lease.record( jobs[band] ) );
+								std::ignore = recorder.submit( std::move( commands ) );
+							}
+						}
+					)
+				);
+			}
+
+			for( auto& done : producing )
+				done.get();
+			recorder.wait_idle();
+		}
+	) && correct;
+
+	std::cout << "\n\t" << recorder.pool_count() << " command pools" << std::endl;
+
+	return correct ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+catch( const vk::SystemError& e )
+{
+	std::cerr << "\n\n Vulkan system error code:\t" << e.code() << "\n\t error:" << e.what() << std::endl;
+	std::abort();
+}
+catch( const std::exception& e )
+{
+	std::cerr << "\n\n Exception caught:\n\t" << e.what() << std::endl;
+	std::abort();
+}
@@ -0,0 +1,176 @@
+#include <cstdlib> // abort, EXIT_SUCCESS
+#include <cstdint>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <execution>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+#include <iostream> // cout, cerr, endl
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "../src/stopwatch.hpp"
+#include "common.hpp"
+
+#include <fgl/vulkan.hpp>
+
+/* GPU Reduction (sum/min/max) and Scan (inclusive sum) against
+	std::reduce / std::inclusive_scan with std::execution::par_unseq on the
+	same data, checking that both agree. GB/s counts the input read once.
+
+	libstdc++ only runs par_unseq in parallel when built against TBB (the
+	CMake build links it when found); otherwise the baseline is serial.*/
+
+void print_result( const std::string& name, const uint32_t elements, const double gpu_ms, const double cpu_ms, const bool matches )
+{
+	const double bytes { static_cast< double >( elements ) * sizeof( uint32_t ) };
+	std::cout
+		<< "\n\t" << name << ( matches ? "" : " (DOES NOT MATCH)" )
+		<< "\n\t\tGPU " << gpu_ms << " ms, " << bytes / gpu_ms / 1e6 << " GB/s"
+		<< "\n\t\tCPU " << cpu_ms << " ms, " << bytes / cpu_ms / 1e6 << " GB/s";
+}
+
+int main() try
+{
+	fgl::vulkan::AppInfo info(
+		VK_API_VERSION_1_1,
+		{},
+		{},
+		1,
+		0.0
+	);
+
+	const fgl::vulkan::Context inst( info );
+	std::cout << "\n\tSubgroup arithmetic: " << ( inst.subgroup_arithmetic ? "yes" : "no (shared memory trees)" );
+
+	constexpr uint32_t n { 1u << 24 };
+	constexpr std::size_t rounds { 10 };
+	constexpr vk::DeviceSize bytesize { n * sizeof( uint32_t ) };
+	constexpr vk::BufferUsageFlags usage {
+		vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc
+	};
+
+	std::vector<fgl::vulkan::Buffer> buffers;
+	buffers.reserve( 2 );
+	buffers.emplace_back( inst, bytesize, usage, vk::SharingMode::eConcurrent, 0, vk::MemoryPropertyFlagBits::eDeviceLocal, vk::DescriptorType::eStorageBuffer );
+	buffers.emplace_back( inst, bytesize, usage, vk::SharingMode::eConcurrent, 1, vk::MemoryPropertyFlagBits::eDeviceLocal, vk::DescriptorType::eStorageBuffer );
+	const fgl::vulkan::Buffer& input { buffers.at( 0 ) };
+	const fgl::vulkan::Buffer& output { buffers.at( 1 ) };
+
+	fgl::vulkan::Profiler profiler( inst );
+	fgl::vulkan::TransferEngine transfer( inst );
+	fgl::vulkan::QueueScheduler scheduler( inst );
+
+	std::vector<uint32_t> data( n );
+	uint32_t state { 2463534242u };
+	for( auto& element : data )
+	{
+		// xorshift32
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		element = state;
+	}
+	transfer.upload( input, std::span<const uint32_t>( data ) );
+	transfer.wait();
+
+	bool correct { true };
+
+	constexpr std::array<std::pair<fgl::vulkan::ReduceOperation, const char*>, 3> operations { {
+		{ fgl::vulkan::ReduceOperation::eSum, "reduce sum" },
+		{ fgl::vulkan::ReduceOperation::eMin, "reduce min" },
+		{ fgl::vulkan::ReduceOperation::eMax, "reduce max" }
+	} };
+
+	for( const auto& entry : operations )
+	{
+		const fgl::vulkan::ReduceOperation operation { entry.first };
+		const std::string name { entry.second };
+		fgl::vulkan::Reduction reduction( inst, operation, n );
+
+		for( std::size_t round { 0 }; round < rounds; ++round )
+		{
+			scheduler.submit(
+				[&]( const vk::raii::CommandBuffer& buffer )
+				{
+					const uint32_t span { profiler.begin( buffer, name ) };
+					reduction.record( buffer, input, n );
+					profiler.end( buffer, span );
+				}
+			).wait();
+		}
+		const uint32_t gpu { reduction.result() };
+
+		uint32_t cpu { 0 };
+		const double cpu_ms {
+			time_host( rounds,
+				[&]()
+				{
+					cpu = std::reduce(
+						std::execution::par_unseq, data.cbegin(), data.cend(), fgl::vulkan::identity( operation ),
+						[operation]( const uint32_t a, const uint32_t b ) { return fgl::vulkan::combine( operation, a, b ); }
+					);
+				}
+			)
+		};
+
+		profiler.resolve();
+		const bool matches { gpu == cpu };
+		correct = correct && matches;
+		print_result( name, n, profiler.kernel_statistics().at( name ).min_ms, cpu_ms, matches );
+	}
+
+	{
+		const std::string name { "inclusive scan sum" };
+		fgl::vulkan::Scan scan( inst, fgl::vulkan::ReduceOperation::eSum, n );
+
+		for( std::size_t round { 0 }; round < rounds; ++round )
+		{
+			scheduler.submit(
+				[&]( const vk::raii::CommandBuffer& buffer )
+				{
+					const uint32_t span { profiler.begin( buffer, name ) };
+					scan.record( buffer, input, output, n );
+					profiler.end( buffer, span );
+				}
+			).wait();
+		}
+
+		std::vector<uint32_t> gpu( n );
+		transfer.download( output, std::span( gpu ) );
+		transfer.wait();
+
+		std::vector<uint32_t> cpu( n );
+		const double cpu_ms {
+			time_host( rounds,
+				[&]()
+				{
+					std::inclusive_scan( std::execution::par_unseq, data.cbegin(), data.cend(), cpu.begin() );
+				}
+			)
+		};
+
+		profiler.resolve();
+		const bool matches { gpu == cpu };
+		correct = correct && matches;
+		print_result( name, n, profiler.kernel_statistics().at( name ).min_ms, cpu_ms, matches );
+	}
+	std::cout << std::endl;
+
+	return correct ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+catch( const vk::SystemError& e )
+{
+	std::cerr << "\n\n Vulkan system error code:\t" << e.code() << "\n\t error:" << e.what() << std::endl;
+	std::abort();
+}
+catch( const std::exception& e )
+{
+	std::cerr << "\n\n Exception caught:\n\t" << e.what() << std::endl;
+	std::abort();
+}
@@ -0,0 +1,173 @@
+#include <cstdlib> // abort, EXIT_SUCCESS
+#include <cstdint>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <numeric>
+#include <span>
+#include <string>
+#include <vector>
+#include <iostream> // cout, cerr, endl
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "../src/stopwatch.hpp"
+#include "common.hpp"
+
+#include <fgl/vulkan.hpp>
+
+/* GPU RadixSort of random 32-bit keys, alone and carrying their original
+	index as a value, from 1K to 100M elements. Keys are checked against
+	std::sort and pairs against std::stable_sort by key, which is the order
+	a stable LSD sort must produce.
+
+	Sizes past maxStorageBufferRange are skipped. Keys/s counts the sorted
+	elements over the fastest GPU run; the std::sort time is a single
+	serial run on the same data.*/
+
+void print_result( const std::string& name, const uint32_t elements, const double gpu_ms, const double cpu_ms, const bool matches )
+{
+	std::cout
+		<< "\n\t" << name << ( matches ? "" : " (DOES NOT MATCH)" )
+		<< "\n\t\tGPU " << gpu_ms << " ms, " << elements / gpu_ms / 1e3 << " Mkeys/s"
+		<< "\n\t\tstd::sort " << cpu_ms << " ms, " << elements / cpu_ms / 1e3 << " Mkeys/s";
+}
+
+int main() try
+{
+	fgl::vulkan::AppInfo info(
+		VK_API_VERSION_1_1,
+		{},
+		{},
+		1,
+		0.0
+	);
+
+	const fgl::vulkan::Context inst( info );
+	std::cout << "\n\tSubgroup arithmetic: " << ( inst.subgroup_arithmetic ? "yes" : "no (shared memory trees)" );
+
+	constexpr std::array<uint32_t, 6> sizes { 1'000, 10'000, 100'000, 1'000'000, 10'000'000, 100'000'000 };
+	constexpr std::size_t rounds { 5 };
+	constexpr vk::BufferUsageFlags usage {
+		vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc
+	};
+
+	uint32_t n { 0 };
+	for( const uint32_t size : sizes )
+	{
+		if( vk::DeviceSize( size ) * sizeof( uint32_t ) <= inst.properties.limits.maxStorageBufferRange )
+			n = size;
+		else
+			std::cout << "\n\tSkipping " << size << " keys: past maxStorageBufferRange";
+	}
+
+	std::vector<fgl::vulkan::Buffer> buffers;
+	buffers.reserve( 2 );
+	buffers.emplace_back( inst, n * sizeof( uint32_t ), usage, vk::SharingMode::eConcurrent, 0, vk::MemoryPropertyFlagBits::eDeviceLocal, vk::DescriptorType::eStorageBuffer );
+	buffers.emplace_back( inst, n * sizeof( uint32_t ), usage, vk::SharingMode::eConcurrent, 1, vk::MemoryPropertyFlagBits::eDeviceLocal, vk::DescriptorType::eStorageBuffer );
+	const fgl::vulkan::Buffer& keys_buffer { buffers.at( 0 ) };
+	const fgl::vulkan::Buffer& values_buffer { buffers.at( 1 ) };
+
+	fgl::vulkan::Profiler profiler( inst );
+	fgl::vulkan::TransferEngine transfer( inst );
+	fgl::vulkan::QueueScheduler scheduler( inst );
+	fgl::vulkan::RadixSort sort( inst, n, true );
+
+	std::vector<uint32_t> data( n );
+	uint32_t state { 2463534242u };
+	for( auto& element : data )
+	{
+		// xorshift32
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		element = state;
+	}
+
+	std::vector<uint32_t> indices( n );
+	std::iota( indices.begin(), indices.end(), 0u );
+
+	bool correct { true };
+	for( const uint32_t count : sizes )
+	{
+		if( count > n )
+			break;
+
+		const std::span<const uint32_t> keys( data.data(), count );
+		const std::span<const uint32_t> values( indices.data(), count );
+
+		const std::string keys_name { "sort keys " + std::to_string( count ) };
+		const std::string pairs_name { "sort pairs " + std::to_string( count ) };
+
+		// sorting is in place, so every round starts from the same upload
+		for( std::size_t round { 0 }; round < rounds; ++round )
+		{
+			transfer.upload( keys_buffer, keys );
+			transfer.wait();
+			scheduler.submit(
+				[&]( const vk::raii::CommandBuffer& buffer )
+				{
+					const uint32_t span { profiler.begin( buffer, keys_name ) };
+					sort.record( buffer, keys_buffer, count );
+					profiler.end( buffer, span );
+				}
+			).wait();
+		}
+
+		std::vector<uint32_t> gpu_keys( count );
+		transfer.download( keys_buffer, std::span( gpu_keys ) );
+		transfer.wait();
+
+		std::vector<uint32_t> cpu_keys( keys.begin(), keys.end() );
+		const double cpu_ms { time_host_once( [&]() { std::sort( cpu_keys.begin(), cpu_keys.end() ); } ) };
+
+		profiler.resolve();
+		const bool keys_match { gpu_keys == cpu_keys };
+		correct = correct && keys_match;
+		print_result( keys_name, count, profiler.kernel_statistics().at( keys_name ).min_ms, cpu_ms, keys_match );
+
+		for( std::size_t round { 0 }; round < rounds; ++round )
+		{
+			transfer.upload( keys_buffer, keys );
+			transfer.upload( values_buffer, values );
+			transfer.wait();
+			scheduler.submit(
+				[&]( const vk::raii::CommandBuffer& buffer )
+				{
+					const uint32_t span { profiler.begin( buffer, pairs_name ) };
+					sort.record( buffer, keys_buffer, values_buffer, count );
+					profiler.end( buffer, span );
+				}
+			).wait();
+		}
+
+		std::vector<uint32_t> gpu_values( count );
+		transfer.download( keys_buffer, std::span( gpu_keys ) );
+		transfer.download( values_buffer, std::span( gpu_values ) );
+		transfer.wait();
+
+		std::vector<uint32_t> cpu_values( values.begin(), values.end() );
+		std::stable_sort(
+			cpu_values.begin(), cpu_values.end(),
+			[&keys]( const uint32_t a, const uint32_t b ) { return keys[a] < keys[b]; }
+		);
+
+		profiler.resolve();
+		const bool pairs_match { gpu_keys == cpu_keys && gpu_values == cpu_values };
+		correct = correct && pairs_match;
+		print_result( pairs_name, count, profiler.kernel_statistics().at( pairs_name ).min_ms, cpu_ms, pairs_match );
+	}
+	std::cout << std::endl;
+
+	return correct ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+catch( const vk::SystemError& e )
+{
+	std::cerr << "\n\n Vulkan system error code:\t" << e.code() << "\n\t error:" << e.what() << std::endl;
+	std::abort();
+}
+catch( const std::exception& e )
+{
+	std::cerr << "\n\n Exception caught:\n\t" << e.what() << std::endl;
+	std::abort();
+}
@@ -0,0 +1,141 @@
+#include <cstdlib> // abort, getenv, EXIT_SUCCESS
+#include <cstdint>
+#include <array>
+#include <cstring> // memcpy
+#include <span>
+#include <string>
+#include <vector>
+#include <iostream> // cout, cerr, endl
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "common.hpp"
+
+#include <fgl/vulkan.hpp>
+
+/* An n x n OuterProduct far larger than the device memory it's allowed,
+	streamed through a TileStream in bands of rows. Each band's first and
+	last row are checked against the CPU as they arrive; setting
+	FGL_STREAM_FILE writes the whole product there as well.
+
+	n comes from FGL_STREAM_N (32768, a 4 GiB product, by default) and the
+	device memory budget from FGL_STREAM_BUDGET_MB (256). The wait time
+	printed is how long the host sat on tiles still computing, so with
+	full overlap of compute and readback it stays near the time of the
+	first depth - 1 tiles.*/
+
+// row y of the product, as the band holds it from row first on
+bool row_matches( const std::vector<uint32_t>& in, const std::span<const std::byte> band, const uint64_t first, const uint64_t y )
+{
+	const std::size_t n { in.size() };
+	for( std::size_t x { 0 }; x < n; ++x )
+	{
+		uint32_t value;
+		std::memcpy( &value, band.data() + ( ( y - first ) * n + x ) * sizeof( uint32_t ), sizeof( uint32_t ) );
+		if( value != in[y] * in[x] )
+		{
+			std::cerr << "\n\tMismatch at (" << x << ", " << y << "): " << value << " != " << in[y] * in[x] << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+int main() try
+{
+	fgl::vulkan::AppInfo info(
+		VK_API_VERSION_1_1,
+		{},
+		{},
+		1,
+		0.0
+	);
+
+	const fgl::vulkan::Context inst( info );
+
+	const uint32_t n { static_cast< uint32_t >( environment_or( "FGL_STREAM_N", 32768 ) ) };
+	const vk::DeviceSize budget { environment_or( "FGL_STREAM_BUDGET_MB", 256 ) * 1024 * 1024 };
+	constexpr fgl::vulkan::Kernel kernel { fgl::vulkan::Kernel::eOuterProduct };
+
+	const auto& outer_product { fgl::vulkan::kernel_info( kernel ) };
+	const uint32_t tile_rows { outer_product.workgroup_size[1] * outer_product.outputs_per_invocation[1] };
+	const vk::DeviceSize row_bytes { vk::DeviceSize( n ) * sizeof( uint32_t ) };
+	const uint32_t band_rows { fgl::vulkan::fit_tile_units( inst, row_bytes, budget, tile_rows ) };
+
+	std::vector<fgl::vulkan::Buffer> buffers;
+	buffers.reserve( 1 );
+	buffers.emplace_back( inst, row_bytes, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst, vk::SharingMode::eConcurrent, 0, vk::MemoryPropertyFlagBits::eDeviceLocal, vk::DescriptorType::eStorageBuffer );
+
+	std::vector<uint32_t> input( n );
+	for( uint32_t i { 0 }; auto& element : input )
+		element = i++ * 2654435761u; // spread over the whole 32-bit range
+
+	{
+		fgl::vulkan::TransferEngine transfer( inst );
+		transfer.upload( buffers.at( 0 ), std::span<const uint32_t>( input ) );
+		transfer.wait();
+	}
+
+	constexpr std::array<fgl::vulkan::BindingSlot, 2> bindings { {
+		{ 0, vk::DescriptorType::eStorageBuffer },
+		{ 1, vk::DescriptorType::eStorageBuffer }
+	} };
+	const fgl::vulkan::Pipeline pipeline { fgl::vulkan::make_pipeline( inst, kernel, bindings ) };
+
+	fgl::vulkan::QueueScheduler scheduler( inst );
+	fgl::vulkan::DescriptorSetCache sets( inst );
+	fgl::vulkan::TileStream stream( inst, scheduler, band_rows, row_bytes );
+
+	const fgl::vulkan::TileStream::Recorder record {
+		[&]( const vk::raii::CommandBuffer& buffer, const fgl::vulkan::TileStream::Tile& tile, const fgl::vulkan::Buffer& output )
+		{
+			const std::array<fgl::vulkan::BufferBinding, 2> bound { {
+				{ 0, vk::DescriptorType::eStorageBuffer, *buffers.at( 0 ).buffer },
+				{ 1, vk::DescriptorType::eStorageBuffer, *output.buffer }
+			} };
+			const fgl::vulkan::OuterProductParameters parameters { n, static_cast< uint32_t >( tile.first ), tile.count };
+			const auto groups { fgl::vulkan::kernel_group_count( kernel, { n, tile.count, 1 }, pipeline.specialization ) };
+			fgl::vulkan::record_dispatch( buffer, pipeline, sets.get( pipeline, bound ), groups[0], groups[1], groups[2], fgl::vulkan::push_constant_bytes( parameters ) );
+		}
+	};
+
+	const char* path { std::getenv( "FGL_STREAM_FILE" ) };
+	const fgl::vulkan::TileStream::Sink file { path ? fgl::vulkan::file_sink( path ) : fgl::vulkan::TileStream::Sink {} };
+
+	bool correct { true };
+	const fgl::vulkan::TileStream::Sink sink {
+		[&]( const fgl::vulkan::TileStream::Tile& tile, const std::span<const std::byte> data )
+		{
+			correct = correct
+				&& row_matches( input, data, tile.first, tile.first )
+				&& row_matches( input, data, tile.first, tile.first + tile.count - 1 );
+			if( file )
+				file( tile, data );
+		}
+	};
+
+	std::cout
+		<< "\n\tStreaming a " << n << 'x' << n << " product (" << double( row_bytes ) * n / ( 1024.0 * 1024.0 * 1024.0 ) << " GiB)"
+		<< " in bands of " << band_rows << " rows, " << stream.depth() << " in flight";
+
+	const auto statistics { stream.run( n, record, sink ) };
+
+	std::cout
+		<< "\n\t" << statistics.tiles << " tiles, " << statistics.seconds << " s, "
+		<< double( statistics.bytes ) / statistics.seconds / 1e9 << " GB/s"
+		<< "\n\tHost waiting on tiles: " << statistics.wait_seconds << " s, in the sink: " << statistics.sink_seconds << " s"
+		<< "\n\t" << ( correct ? "Matches" : "DOES NOT MATCH" ) << " the CPU reference"
+		<< std::endl;
+
+	return correct ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+catch( const vk::SystemError& e )
+{
+	std::cerr << "\n\n Vulkan system error code:\t" << e.code() << "\n\t error:" << e.what() << std::endl;
+	std::abort();
+}
+catch( const std::exception& e )
+{
+	std::cerr << "\n\n Exception caught:\n\t" << e.what() << std::endl;
+	std::abort();
+}
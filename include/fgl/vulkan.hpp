@@ -1,9 +1,26 @@
 #ifndef FGL_VULKAN_HPP_INCLUDED
 #define FGL_VULKAN_HPP_INCLUDED
 
+#include "./vulkan/async.hpp"
+#include "./vulkan/autotune.hpp"
+#include "./vulkan/batch.hpp"
 #include "./vulkan/commandqueue.hpp"
 #include "./vulkan/context.hpp"
+#include "./vulkan/descriptors.hpp"
+#include "./vulkan/device_group.hpp"
+#include "./vulkan/executor.hpp"
+#include "./vulkan/frame_ring.hpp"
+#include "./vulkan/kernels.hpp"
+#include "./vulkan/mapped_file.hpp"
 #include "./vulkan/memory.hpp"
 #include "./vulkan/pipeline.hpp"
+#include "./vulkan/primitives.hpp"
+#include "./vulkan/profiler.hpp"
+#include "./vulkan/recording.hpp"
+#include "./vulkan/registry.hpp"
+#include "./vulkan/scheduler.hpp"
+#include "./vulkan/stream.hpp"
+#include "./vulkan/task.hpp"
+#include "./vulkan/transfer.hpp"
 
 #endif /* FGL_VULKAN_HPP_INCLUDED */
@@ -0,0 +1,214 @@
+#ifndef FGL_VULKAN_ARENA_HPP_INCLUDED
+#define FGL_VULKAN_ARENA_HPP_INCLUDED
+
+#include <cstdint>
+#include <array>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include <vulkan/vulkan_raii.hpp>
+
+namespace fgl::vulkan
+{
+	class MemoryArena;
+
+	/* A single vkAllocateMemory owned by the arena.
+		Sub-ranges are handed out first-fit from a free list that is
+		coalesced on free. used is the per-block accounting that replaced
+		the old global Buffer::bytecount.
+		Host-visible blocks are mapped once on creation and stay mapped
+		until the block is freed.*/
+	struct MemoryBlock
+	{
+		vk::raii::DeviceMemory memory;
+		const vk::DeviceSize size;
+		const uint32_t memory_type_index;
+		const vk::MemoryPropertyFlags property_flags;
+		const bool linear;
+		const bool dedicated;
+
+		vk::DeviceSize used { 0 };
+		std::size_t allocation_count { 0 };
+		std::map<vk::DeviceSize, vk::DeviceSize> free_ranges {}; // offset -> size
+		void* mapped { nullptr };
+
+		[[nodiscard]] explicit MemoryBlock(
+			vk::raii::DeviceMemory&& memory_,
+			const vk::DeviceSize size_,
+			const uint32_t memory_type_index_,
+			const vk::MemoryPropertyFlags property_flags_,
+			const bool linear_,
+			const bool dedicated_ );
+
+		// returns the offset of the sub-range or size if nothing fits
+		[[nodiscard]] vk::DeviceSize allocate(
+			const vk::DeviceSize bytesize,
+			const vk::DeviceSize alignment );
+
+		void free( const vk::DeviceSize offset, const vk::DeviceSize bytesize );
+	};
+
+	// A sub-range of a MemoryBlock, returned to the arena on destruction
+	class Allocation
+	{
+		MemoryArena* arena { nullptr };
+		MemoryBlock* block { nullptr };
+
+	public:
+		vk::DeviceSize offset { 0 };
+		vk::DeviceSize size { 0 };
+
+		Allocation() = default;
+		Allocation( const Allocation& ) = delete;
+		Allocation& operator=( const Allocation& ) = delete;
+
+		[[nodiscard]] explicit Allocation(
+			MemoryArena& arena_,
+			MemoryBlock& block_,
+			const vk::DeviceSize offset_,
+			const vk::DeviceSize size_ ) noexcept;
+
+		[[nodiscard]] Allocation( Allocation&& other ) noexcept;
+		Allocation& operator=( Allocation&& other ) noexcept;
+
+		~Allocation();
+
+		[[nodiscard]] vk::DeviceMemory memory() const;
+		[[nodiscard]] uint32_t memory_type_index() const;
+
+		[[nodiscard]] bool host_visible() const;
+		[[nodiscard]] bool host_coherent() const;
+
+		// address of offset in the persistently mapped block
+		[[nodiscard]] void* mapped() const;
+
+		/* Make host writes visible to the device / device writes visible
+			to the host. No-ops on coherent memory. Ranges are relative to
+			the allocation and rounded out to nonCoherentAtomSize.*/
+		void flush(
+			const vk::DeviceSize range_offset = 0,
+			const vk::DeviceSize range_size = VK_WHOLE_SIZE ) const;
+		void invalidate(
+			const vk::DeviceSize range_offset = 0,
+			const vk::DeviceSize range_size = VK_WHOLE_SIZE ) const;
+	};
+
+	/* Grabs large vk::raii::DeviceMemory blocks per memory type and
+		sub-allocates them. Allocations larger than the block size get a
+		dedicated block that is released as soon as it is empty.
+
+		Linear (buffer) and optimal (image) resources never share a block,
+		so neighbouring sub-ranges can not violate bufferImageGranularity.
+		Sub-ranges of non-coherent memory are aligned and sized to
+		nonCoherentAtomSize so flushing one never touches a neighbour.
+
+		Memory types are ranked per request (see rank_memory_types) and new
+		blocks are only created while the owning heap is within budget.
+		The budget comes from VK_EXT_memory_budget when the device has it,
+		otherwise it is 80% of the heap minus what the arena has reserved.*/
+	class MemoryArena
+	{
+		friend class Allocation;
+
+		const vk::raii::Device& device;
+		const vk::raii::PhysicalDevice& physical_device;
+		const vk::PhysicalDeviceMemoryProperties memory_properties;
+		const bool has_memory_budget;
+		const vk::DeviceSize non_coherent_atom_size;
+
+		mutable std::mutex mutex {};
+		std::array<std::vector<std::unique_ptr<MemoryBlock>>, VK_MAX_MEMORY_TYPES> pools {};
+		std::array<vk::DeviceSize, VK_MAX_MEMORY_HEAPS> heap_reserved {};
+
+		// returns nullptr if the heap is over budget
+		[[nodiscard]] MemoryBlock* create_block(
+			const uint32_t memory_type_index,
+			const vk::DeviceSize bytesize,
+			const bool linear,
+			const bool dedicated );
+
+		[[nodiscard]] std::optional<Allocation> try_allocate(
+			const vk::MemoryRequirements& requirements,
+			const uint32_t memory_type_index,
+			const bool linear );
+
+		[[noreturn]] void throw_over_budget(
+			const vk::MemoryRequirements& requirements,
+			const uint32_t memory_type_index ) const;
+
+		void free( MemoryBlock& block, const vk::DeviceSize offset, const vk::DeviceSize bytesize );
+
+		[[nodiscard]] vk::MappedMemoryRange atom_range(
+			const MemoryBlock& block,
+			const vk::DeviceSize offset,
+			const vk::DeviceSize bytesize ) const;
+
+	public:
+		const vk::DeviceSize block_size;
+
+		struct Statistics
+		{
+			std::size_t block_count { 0 };
+			std::size_t allocation_count { 0 };
+			vk::DeviceSize reserved { 0 };
+			vk::DeviceSize used { 0 };
+		};
+
+		struct HeapBudget
+		{
+			vk::DeviceSize size { 0 };
+			vk::DeviceSize budget { 0 }; // what the process may use
+			vk::DeviceSize usage { 0 }; // what the process currently uses
+			vk::DeviceSize reserved { 0 }; // what this arena has allocated
+		};
+
+		static constexpr vk::DeviceSize default_block_size { 64ull * 1024 * 1024 };
+
+		MemoryArena() = delete;
+		MemoryArena( const MemoryArena& ) = delete;
+
+		[[nodiscard]] explicit MemoryArena(
+			const vk::raii::Device& device_,
+			const vk::raii::PhysicalDevice& physical_device_,
+			const bool has_memory_budget_,
+			const vk::DeviceSize block_size_ = default_block_size );
+
+		/* Memory types allowed by type_bits that have every required flag,
+			best first. Preferred flags dominate the score; after that
+			device-local wins (ReBAR for host-visible requests), AMD
+			device-coherent/uncached types are avoided unless asked for, and
+			host-visible types are avoided for device-only requests so the
+			small BAR heap stays free. Ties keep the driver's order.*/
+		[[nodiscard]] std::vector<uint32_t> rank_memory_types(
+			const uint32_t type_bits,
+			const vk::MemoryPropertyFlags required,
+			const vk::MemoryPropertyFlags preferred = {} ) const;
+
+		// tries every ranked type, falling back when a heap is over budget
+		[[nodiscard]] Allocation allocate(
+			const vk::MemoryRequirements& requirements,
+			const vk::MemoryPropertyFlags required,
+			const vk::MemoryPropertyFlags preferred = {},
+			const bool linear = true );
+
+		[[nodiscard]] Allocation allocate(
+			const vk::MemoryRequirements& requirements,
+			const uint32_t memory_type_index,
+			const bool linear = true );
+
+		[[nodiscard]] HeapBudget heap_budget( const uint32_t heap_index ) const;
+
+		[[nodiscard]] Statistics statistics() const;
+		[[nodiscard]] Statistics statistics( const uint32_t memory_type_index ) const;
+
+	private:
+		// heap_budget without taking the lock
+		[[nodiscard]] HeapBudget query_budget( const uint32_t heap_index ) const;
+	};
+
+}
+
+#endif /* FGL_VULKAN_ARENA_HPP_INCLUDED */
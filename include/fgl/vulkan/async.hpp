@@ -0,0 +1,117 @@
+#ifndef FGL_VULKAN_ASYNC_HPP_INCLUDED
+#define FGL_VULKAN_ASYNC_HPP_INCLUDED
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "context.hpp"
+
+namespace fgl::vulkan
+{
+
+	// a value of a timeline semaphore, for submissions to wait on or signal
+	struct TimelinePoint
+	{
+		vk::Semaphore semaphore;
+		uint64_t value;
+	};
+
+	// Recycles fences so steady state submission doesn't create any
+	class FencePool
+	{
+		const vk::raii::Device& device;
+		std::mutex mutex {};
+		std::vector<vk::raii::Fence> free_fences {};
+
+	public:
+		FencePool() = delete;
+		FencePool( const FencePool& ) = delete;
+
+		[[nodiscard]] explicit FencePool( const Context& context );
+
+		// returns an unsignaled fence
+		[[nodiscard]] vk::raii::Fence acquire();
+
+		// the fence must be signaled or never submitted
+		void release( vk::raii::Fence&& fence );
+	};
+
+	/* Submits work to one queue without blocking the caller.
+		Completion is tracked with a timeline semaphore when the device
+		has the feature (Context::features.timeline_semaphore) and with
+		pooled fences otherwise. A completion thread sleeps on the
+		semaphore/fences, runs the callbacks and then fulfills the futures,
+		so callbacks must not block for long.*/
+	class AsyncQueue
+	{
+		struct Pending
+		{
+			uint64_t value;
+			std::optional<vk::raii::Fence> fence;
+			std::promise<void> promise;
+			std::function<void()> on_complete;
+		};
+
+		const Context& context;
+		const vk::raii::Queue queue;
+		const std::optional<vk::raii::Semaphore> timeline;
+		FencePool fences;
+
+		std::mutex submit_mutex {};
+		uint64_t last_value { 0 };
+
+		std::mutex pending_mutex {};
+		std::condition_variable pending_cv {};
+		std::condition_variable idle_cv {};
+		std::deque<Pending> pending {};
+		bool stopping { false };
+
+		std::thread completion_thread;
+
+		void completion_loop();
+		void wait_for( const Pending& work ) const;
+
+	public:
+		AsyncQueue() = delete;
+		AsyncQueue( const AsyncQueue& ) = delete;
+
+		[[nodiscard]] explicit AsyncQueue(
+			const Context& context_,
+			const uint32_t queue_family_index,
+			const uint32_t queue_index = 0 );
+
+		// waits for everything in flight
+		~AsyncQueue();
+
+		[[nodiscard]] std::future<void> submit(
+			const std::span<const vk::CommandBuffer> buffers,
+			std::function<void()> on_complete = {} );
+
+		[[nodiscard]] std::future<void> submit(
+			const vk::raii::CommandBuffer& buffer,
+			std::function<void()> on_complete = {} );
+
+		[[nodiscard]] bool uses_timeline() const noexcept { return timeline.has_value(); }
+
+		// reaches submitted_value() once that submission completed, nullopt without uses_timeline()
+		[[nodiscard]] std::optional<TimelinePoint> submitted_point();
+
+		// last timeline value handed out (0 before the first submit)
+		[[nodiscard]] uint64_t submitted_value();
+
+		void wait_idle();
+	};
+
+}
+
+#endif /* FGL_VULKAN_ASYNC_HPP_INCLUDED */
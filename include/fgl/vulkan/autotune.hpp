@@ -0,0 +1,122 @@
+#ifndef FGL_VULKAN_AUTOTUNE_HPP_INCLUDED
+#define FGL_VULKAN_AUTOTUNE_HPP_INCLUDED
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "context.hpp"
+#include "pipeline.hpp"
+
+namespace fgl::vulkan
+{
+
+	using WorkgroupSize = std::array<uint32_t, 3>;
+
+	// workgroups needed to cover problem_size, rounding up on every axis
+	[[nodiscard]] WorkgroupSize group_count(
+		const WorkgroupSize& problem_size,
+		const WorkgroupSize& workgroup_size );
+
+	/* Picks the fastest workgroup shape for a pipeline and problem size.
+
+		Every candidate shape is compiled as a Pipeline::variant through the
+		Specialization::workgroup_size constants, dispatched a few times
+		and timed with GPU timestamps (or on the host when the queue family
+		has no timestamp support). The kernel really runs on the buffers
+		bound to the pipeline, so tune before the real data is uploaded or
+		use a kernel that is safe to repeat.
+
+		Winners are kept in a text database keyed by kernel name and problem
+		size, under a key for the device and driver version. Entries for
+		other devices are kept as they are, so one file can serve a fleet.
+		The database is written back on destruction.
+
+		Uses queue 0 of the compute family; don't submit to it from
+		elsewhere while tuning.*/
+	class Autotuner
+	{
+	public:
+		struct Result
+		{
+			WorkgroupSize workgroup_size;
+			double milliseconds; // per dispatch
+		};
+
+	private:
+		const Context& context;
+		const vk::raii::Queue queue;
+		const vk::raii::CommandPool pool;
+		const vk::raii::CommandBuffer command_buffer;
+		const vk::raii::QueryPool queries;
+		const vk::raii::Fence fence;
+		const uint32_t timestamp_valid_bits;
+		const std::string device_key;
+
+		std::mutex tuning_mutex {}; // guards the command buffer and query pool
+		mutable std::mutex mutex {};
+		std::map<std::string, Result> database {}; // this device only
+		std::vector<std::string> foreign_entries {}; // other devices, written back untouched
+		bool dirty { false };
+
+		void load();
+
+		[[nodiscard]] double time_dispatches(
+			const Pipeline& pipeline,
+			const Specialization& specialization,
+			const WorkgroupSize& groups,
+			const std::span<const std::byte> push_constants );
+
+	public:
+		const std::filesystem::path database_path;
+		const uint32_t iterations;
+
+		static constexpr uint32_t default_iterations { 8 };
+
+		Autotuner() = delete;
+		Autotuner( const Autotuner& ) = delete;
+
+		// an empty database_path keeps results in memory only
+		[[nodiscard]] explicit Autotuner(
+			const Context& context_,
+			std::filesystem::path database_path_ = {},
+			const uint32_t iterations_ = default_iterations );
+
+		// saves the database
+		~Autotuner();
+
+		/* Power of two shapes from one subgroup up to
+			maxComputeWorkGroupInvocations that fit maxComputeWorkGroupSize.
+			dimensions > 1 splits each size between x and y.*/
+		[[nodiscard]] std::vector<WorkgroupSize> candidate_shapes( const uint32_t dimensions ) const;
+
+		// times every candidate, fastest first
+		[[nodiscard]] std::vector<Result> benchmark(
+			const Pipeline& pipeline,
+			const WorkgroupSize& problem_size,
+			const std::span<const WorkgroupSize> candidates,
+			const std::span<const std::byte> push_constants = {} );
+
+		/* The stored workgroup size for kernel at problem_size, tuning and
+			storing it first if there is none.*/
+		[[nodiscard]] WorkgroupSize tune(
+			const std::string& kernel,
+			const Pipeline& pipeline,
+			const WorkgroupSize& problem_size,
+			const std::span<const std::byte> push_constants = {} );
+
+		// writes the database atomically; does nothing without a path
+		void save() const;
+	};
+
+}
+
+#endif /* FGL_VULKAN_AUTOTUNE_HPP_INCLUDED */
@@ -0,0 +1,104 @@
+#ifndef FGL_VULKAN_BATCH_HPP_INCLUDED
+#define FGL_VULKAN_BATCH_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "commandqueue.hpp"
+#include "memory.hpp"
+#include "pipeline.hpp"
+
+namespace fgl::vulkan
+{
+
+	enum class Access
+	{
+		eRead,
+		eWrite,
+		eReadWrite
+	};
+
+	struct BufferAccess
+	{
+		const Buffer* buffer;
+		Access access;
+	};
+
+	/* Records many dispatches into one command buffer.
+		Each dispatch names the buffers it touches; a compute to compute
+		barrier is only inserted when a buffer written by an earlier
+		dispatch is accessed again, or a buffer read earlier is written
+		(RAW, WAW and WAR). A dispatch with no accesses listed is treated
+		as touching everything.
+
+		begin()/end() of the command buffer stay with the caller.*/
+	class DispatchRecorder
+	{
+		const vk::raii::CommandBuffer& buffer;
+
+		// accesses since the last barrier
+		std::vector<vk::Buffer> pending_writes {};
+		std::vector<vk::Buffer> pending_reads {};
+		bool pending_unknown { false };
+
+		std::size_t dispatch_count { 0 };
+		std::size_t barrier_count { 0 };
+
+		void barrier();
+
+		// barrier() if accesses conflict with what's pending
+		void order( const std::span<const BufferAccess> accesses );
+
+		// adds accesses to what's pending
+		void track( const std::span<const BufferAccess> accesses );
+
+	public:
+		DispatchRecorder() = delete;
+
+		[[nodiscard]] explicit DispatchRecorder( const vk::raii::CommandBuffer& buffer_ );
+
+		void dispatch(
+			const Pipeline& pipeline,
+			const std::span<const BufferAccess> accesses,
+			const uint32_t groupCountX,
+			const uint32_t groupCountY = 1,
+			const uint32_t groupCountZ = 1,
+			const std::span<const std::byte> push_constants = {} );
+
+		// the same with set (e.g. from a DescriptorSetCache) bound instead of pipeline.sets
+		void dispatch(
+			const Pipeline& pipeline,
+			const vk::DescriptorSet set,
+			const std::span<const BufferAccess> accesses,
+			const uint32_t groupCountX,
+			const uint32_t groupCountY = 1,
+			const uint32_t groupCountZ = 1,
+			const std::span<const std::byte> push_constants = {} );
+
+		[[nodiscard]] std::size_t dispatches() const noexcept { return dispatch_count; }
+		[[nodiscard]] std::size_t barriers() const noexcept { return barrier_count; }
+	};
+
+	// Collects command buffers and hands them to the queue in one vkQueueSubmit
+	class SubmitBatch
+	{
+		std::vector<vk::CommandBuffer> buffers {};
+
+	public:
+		void add( const vk::raii::CommandBuffer& buffer );
+		void add( const CommandQueue& queue );
+
+		// submits and clears the batch; the fence (if any) signals when all have completed
+		void submit( const vk::raii::Queue& queue, const vk::Fence fence = {} );
+
+		[[nodiscard]] std::size_t size() const noexcept { return buffers.size(); }
+		[[nodiscard]] bool empty() const noexcept { return buffers.empty(); }
+	};
+
+}
+
+#endif /* FGL_VULKAN_BATCH_HPP_INCLUDED */
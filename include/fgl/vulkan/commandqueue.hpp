@@ -1,19 +1,85 @@
 #ifndef FGL_VULKAN_COMMANDQUEUE_HPP_INCLUDED
 #define FGL_VULKAN_COMMANDQUEUE_HPP_INCLUDED
 
+#include <cstddef>
+#include <span>
+#include <string>
 #include <vector>
 #include <ranges>
 
 #include "./context.hpp"
+#include "./internal/mpsc_queue.hpp"
 #include "./pipeline.hpp"
 
 namespace fgl::vulkan {
 
+class Profiler;
+
+// binds pipeline + sets, pushes constants and dispatches; begin/end are left to the caller
+void record_dispatch(
+	const vk::raii::CommandBuffer& buffer,
+	const fgl::vulkan::Pipeline& pipeline,
+	const uint32_t groupCountX,
+	const uint32_t groupCountY = 1,
+	const uint32_t groupCountZ = 1,
+	const std::span<const std::byte> push_constants = {} );
+
+// the same with pipeline.variant( specialization ) bound instead of pipeline.pipeline
+void record_dispatch(
+	const vk::raii::CommandBuffer& buffer,
+	const fgl::vulkan::Pipeline& pipeline,
+	const fgl::vulkan::Specialization& specialization,
+	const uint32_t groupCountX,
+	const uint32_t groupCountY = 1,
+	const uint32_t groupCountZ = 1,
+	const std::span<const std::byte> push_constants = {} );
+
+/* The same with set (e.g. from a DescriptorSetCache) bound instead of
+	pipeline.sets, to run one pipeline over other buffers.*/
+void record_dispatch(
+	const vk::raii::CommandBuffer& buffer,
+	const fgl::vulkan::Pipeline& pipeline,
+	const vk::DescriptorSet set,
+	const uint32_t groupCountX,
+	const uint32_t groupCountY = 1,
+	const uint32_t groupCountZ = 1,
+	const std::span<const std::byte> push_constants = {} );
+
+// both: pipeline.variant( specialization ) bound with set
+void record_dispatch(
+	const vk::raii::CommandBuffer& buffer,
+	const fgl::vulkan::Pipeline& pipeline,
+	const fgl::vulkan::Specialization& specialization,
+	const vk::DescriptorSet set,
+	const uint32_t groupCountX,
+	const uint32_t groupCountY = 1,
+	const uint32_t groupCountZ = 1,
+	const std::span<const std::byte> push_constants = {} );
+
+/* The same with one offset per dynamic buffer of set, in binding order.
+	Offsets must be multiples of dynamic_offset_alignment() and stay
+	within each buffer less the range set was written with.*/
+void record_dispatch(
+	const vk::raii::CommandBuffer& buffer,
+	const fgl::vulkan::Pipeline& pipeline,
+	const vk::DescriptorSet set,
+	const std::span<const uint32_t> dynamic_offsets,
+	const uint32_t groupCountX,
+	const uint32_t groupCountY = 1,
+	const uint32_t groupCountZ = 1,
+	const std::span<const std::byte> push_constants = {} );
+
+/* A single command buffer that can be re-recorded without reallocating.
+	Record with eOneTimeSubmit for per-job work, or with no flags
+	(eSimultaneousUse if submissions overlap) to pre-record once and
+	resubmit it as often as needed.*/
 struct CommandQueue
 {
 	const vk::raii::CommandPool pool;
 	const vk::raii::CommandBuffer buffer;
 
+	[[nodiscard]] explicit CommandQueue( const fgl::vulkan::Context& context );
+
 	[[nodiscard]] explicit CommandQueue(
 		const fgl::vulkan::Context& context,
 		const fgl::vulkan::Pipeline& pipeline,
@@ -21,6 +87,68 @@ struct CommandQueue
 		const uint32_t groupCountX,
 		const uint32_t groupCountY = 1,
 		const uint32_t groupCountZ = 1);
+
+	// the buffer must not be pending execution
+	void record(
+		const fgl::vulkan::Pipeline& pipeline,
+		const vk::CommandBufferUsageFlags flags,
+		const uint32_t groupCountX,
+		const uint32_t groupCountY = 1,
+		const uint32_t groupCountZ = 1,
+		const std::span<const std::byte> push_constants = {} ) const;
+
+	// record() with the dispatch timed as a span named name; resolve once it has run
+	void record(
+		fgl::vulkan::Profiler& profiler,
+		std::string name,
+		const fgl::vulkan::Pipeline& pipeline,
+		const vk::CommandBufferUsageFlags flags,
+		const uint32_t groupCountX,
+		const uint32_t groupCountY = 1,
+		const uint32_t groupCountZ = 1,
+		const std::span<const std::byte> push_constants = {} ) const;
+};
+
+/* Hands out command buffers of one level from one transient pool and
+	takes them back once the caller knows they finished executing, so
+	steady state job submission never allocates. Not thread safe (use one
+	per recording thread), except for recycle_concurrently().*/
+class CommandBufferPool
+{
+	const vk::raii::Device& device;
+	const vk::raii::CommandPool pool;
+	std::vector<vk::raii::CommandBuffer> free_buffers {};
+	// given back from other threads; declared last so they're freed while pool still exists
+	internal::MpscQueue<vk::raii::CommandBuffer> returned_buffers {};
+
+public:
+	const vk::CommandBufferLevel level;
+
+	static constexpr uint32_t allocation_batch { 8 };
+
+	CommandBufferPool() = delete;
+	CommandBufferPool( const CommandBufferPool& ) = delete;
+
+	[[nodiscard]] explicit CommandBufferPool(
+		const fgl::vulkan::Context& context,
+		const uint32_t queue_family_index,
+		const vk::CommandBufferLevel level_ = vk::CommandBufferLevel::ePrimary );
+
+	// begin() implicitly resets a recycled buffer (eResetCommandBuffer)
+	[[nodiscard]] vk::raii::CommandBuffer acquire();
+
+	void recycle( vk::raii::CommandBuffer&& buffer );
+
+	/* recycle() from any thread (e.g. a completion callback) without
+		locking; the owning thread picks the buffer up in acquire().*/
+	void recycle_concurrently( vk::raii::CommandBuffer&& buffer );
+
+	/* Resets every buffer of the pool at once. Only valid when nothing
+		from the pool is pending execution.*/
+	void reset() const;
+
+	// not counting buffers recycled concurrently that acquire() hasn't picked up yet
+	[[nodiscard]] std::size_t available() const noexcept { return free_buffers.size(); }
 };
 
 } // namespace fgl::vulkan
@@ -2,24 +2,68 @@
 #define FGL_VULKAN_CONTEXT_HPP_INCLUDED
 
 #include <cstdint>
+#include <filesystem>
 #include <iostream>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
 
 #include <vulkan/vulkan_raii.hpp>
 
+#include "./arena.hpp"
 #include "./internal/version.hpp"
 
 
 namespace fgl::vulkan {
 
+	// which physical device a Context is created on
+	struct DeviceSelection
+	{
+		// device types that may be picked, any when empty
+		std::vector<vk::PhysicalDeviceType> types {};
+		// a position in enumeration order, taken as is instead of the best score
+		std::optional<uint32_t> index {};
+	};
+
 	struct AppInfo
 	{
 		uint32_t apiVersion;
 		std::vector<const char*> layer {};
 		std::vector<const char*> extentions {};
-		uint32_t queue_count {};
+		uint32_t queue_count {}; // queues per family, 0 creates every queue a family exposes
 		float queue_priority {};
+		// loaded on Context creation and written back on destruction, empty keeps the cache in memory
+		std::filesystem::path pipeline_cache_path {};
+		// the best scoring device (see device_score) of any type by default
+		DeviceSelection device_selection {};
+	};
+
+	// a compute or transfer capable family and how many of its queues the device was created with
+	struct QueueFamily
+	{
+		uint32_t index;
+		vk::QueueFlags flags;
+		uint32_t queue_count;
 	};
 
+	// optional features, enabled on the device when it supports them
+	struct DeviceFeatures
+	{
+		bool timeline_semaphore { false }; // needs apiVersion 1.2
+		bool pipeline_statistics_query { false };
+		bool host_query_reset { false }; // apiVersion 1.2 or VK_EXT_host_query_reset
+	};
+
+	/* Higher is better: the device type first (discrete, integrated,
+		virtual, CPU), then the size of its largest device local heap.
+		0 for devices without a compute queue, which are never picked.*/
+	[[nodiscard]] uint64_t device_score( const vk::raii::PhysicalDevice& physical_device );
+
+	/* Enumeration indices of the compute capable devices info's selection
+		allows, best score first. Ignores DeviceSelection::index.*/
+	[[nodiscard]] std::vector<uint32_t> rank_physical_devices( const AppInfo& info );
+
 	class Context
 	{
 	public:
@@ -27,15 +71,52 @@ namespace fgl::vulkan {
 		const vk::raii::Instance instance;
 		const vk::raii::PhysicalDevice physical_device;
 		const uint32_t queue_family_index;
+		// a transfer-only family when the device has one, otherwise queue_family_index
+		const uint32_t transfer_queue_family_index;
+		const std::vector<QueueFamily> queue_families;
+		const std::vector<const char*> device_extensions;
+		const DeviceFeatures features;
 		const vk::raii::Device device;
 		const vk::PhysicalDeviceProperties properties;
+		// invocations per subgroup (wave/warp) of the compute stage
+		const uint32_t subgroup_size;
+		// compute shaders may use GL_KHR_shader_subgroup_arithmetic
+		const bool subgroup_arithmetic;
 		const internal::VersionInfo version_info;
+		const std::unique_ptr<MemoryArena> arena;
+		const std::filesystem::path pipeline_cache_path;
+		// shared by every Pipeline created from this context
+		const vk::raii::PipelineCache pipeline_cache;
 
 		[[nodiscard]]
 		uint32_t index_of_first_queue_family( const vk::QueueFlagBits flag ) const;
 
+		[[nodiscard]]
+		uint32_t index_of_transfer_queue_family() const;
+
+		// every distinct family the device was created with (for eConcurrent sharing)
+		[[nodiscard]]
+		std::vector<uint32_t> queue_family_indices() const;
+
+		// number of queues created for a family, 0 if the device has none of it
+		[[nodiscard]]
+		uint32_t queue_count( const uint32_t family_index ) const;
+
+		[[nodiscard]]
+		bool has_device_extension( const std::string_view name ) const;
+
+		/* Merges the cache with whatever is on disk now (another process
+			may have written it since we loaded) and replaces the file
+			atomically. Does nothing without a pipeline_cache_path.*/
+		void save_pipeline_cache() const;
+
 		[[nodiscard]] explicit Context( const AppInfo& info );
 
+		Context( const Context& ) = delete;
+
+		// saves the pipeline cache
+		~Context();
+
 		void print_debug_info() const;
 	};
 
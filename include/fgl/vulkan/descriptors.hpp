@@ -0,0 +1,154 @@
+#ifndef FGL_VULKAN_DESCRIPTORS_HPP_INCLUDED
+#define FGL_VULKAN_DESCRIPTORS_HPP_INCLUDED
+
+#include <array>
+#include <compare>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ranges>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "context.hpp"
+#include "memory.hpp"
+#include "pipeline.hpp"
+
+namespace fgl::vulkan
+{
+
+	/* minStorageBufferOffsetAlignment or minUniformBufferOffsetAlignment
+		for type, which dynamic offsets must be multiples of.*/
+	[[nodiscard]] vk::DeviceSize dynamic_offset_alignment(
+		const Context& context,
+		const vk::DescriptorType type );
+
+	// slice_size rounded up to dynamic_offset_alignment, the distance between slices of one buffer
+	[[nodiscard]] vk::DeviceSize dynamic_slice_stride(
+		const Context& context,
+		const vk::DescriptorType type,
+		const vk::DeviceSize slice_size );
+
+	/* Hands out descriptor sets from a growing list of pools and frees
+		them all at once with reset(), never one by one. Each pool has one
+		DescriptorPoolSize per descriptor type (sized by ratios), so layouts
+		mixing storage and uniform buffers allocate from the same pool.
+		When a pool runs out the next one is twice as large.
+
+		Use one allocator per frame or per job and reset() it once the GPU
+		is done with that frame/job. Not thread safe.*/
+	class DescriptorAllocator
+	{
+	public:
+		struct PoolRatio
+		{
+			vk::DescriptorType type;
+			float per_set; // descriptors of this type per set
+		};
+
+		static constexpr uint32_t default_sets_per_pool { 64 };
+		static constexpr uint32_t max_sets_per_pool { 4096 };
+
+		static constexpr std::array<PoolRatio, 4> default_ratios { {
+			{ vk::DescriptorType::eStorageBuffer, 4.0f },
+			{ vk::DescriptorType::eUniformBuffer, 2.0f },
+			{ vk::DescriptorType::eStorageBufferDynamic, 1.0f },
+			{ vk::DescriptorType::eUniformBufferDynamic, 1.0f }
+		} };
+
+	private:
+		const vk::raii::Device& device;
+		const std::vector<PoolRatio> ratios;
+		std::vector<vk::raii::DescriptorPool> pools {};
+		std::size_t current { 0 };
+		uint32_t next_pool_sets;
+
+		void add_pool();
+
+	public:
+		DescriptorAllocator() = delete;
+		DescriptorAllocator( const DescriptorAllocator& ) = delete;
+
+		[[nodiscard]] explicit DescriptorAllocator(
+			const Context& context,
+			const uint32_t sets_per_pool = default_sets_per_pool,
+			const std::span<const PoolRatio> ratios_ = default_ratios );
+
+		// valid until reset()
+		[[nodiscard]] vk::DescriptorSet allocate( const vk::DescriptorSetLayout layout );
+
+		// returns every set to the pools; nothing allocated may still be in use
+		void reset();
+
+		[[nodiscard]] std::size_t pool_count() const noexcept { return pools.size(); }
+	};
+
+	struct BufferBinding
+	{
+		uint32_t binding;
+		vk::DescriptorType type;
+		vk::Buffer buffer;
+		vk::DeviceSize offset { 0 };
+		vk::DeviceSize range { VK_WHOLE_SIZE };
+
+		auto operator<=>( const BufferBinding& ) const = default;
+	};
+
+	/* Descriptor sets keyed by layout and buffer bindings, written once on
+		first use. Lets one Pipeline run over any number of buffer sets
+		without creating a Pipeline per set.
+
+		The cache can't tell a destroyed buffer from a new one that reuses
+		its handle, so evict() buffers before destroying them (or clear()).
+		Thread safe.*/
+	class DescriptorSetCache
+	{
+		using Key = std::pair<vk::DescriptorSetLayout, std::vector<BufferBinding>>;
+
+		const vk::raii::Device& device;
+		std::mutex mutex {};
+		DescriptorAllocator allocator;
+		std::map<Key, vk::DescriptorSet> sets {};
+
+	public:
+		DescriptorSetCache() = delete;
+		DescriptorSetCache( const DescriptorSetCache& ) = delete;
+
+		[[nodiscard]] explicit DescriptorSetCache(
+			const Context& context,
+			const uint32_t sets_per_pool = DescriptorAllocator::default_sets_per_pool );
+
+		// the set for pipeline's layout with bindings, allocated and written on a miss
+		[[nodiscard]] vk::DescriptorSet get(
+			const Pipeline& pipeline,
+			const std::span<const BufferBinding> bindings );
+
+		// each buffer bound whole at its own binding
+		template <std::ranges::forward_range T>
+			requires std::same_as<std::ranges::range_value_t<T>, fgl::vulkan::Buffer>
+		[[nodiscard]] vk::DescriptorSet get( const Pipeline& pipeline, const T& buffers )
+		{
+			std::vector<BufferBinding> bindings;
+			for( const auto& buffer : buffers )
+				bindings.push_back( { buffer.binding, buffer.buffer_type, *buffer.buffer } );
+
+			return get( pipeline, bindings );
+		}
+
+		// forgets every set that references buffer (its descriptors stay allocated until clear())
+		void evict( const vk::Buffer buffer );
+
+		// drops every set; none may still be in use by the GPU
+		void clear();
+
+		[[nodiscard]] std::size_t size();
+	};
+
+}
+
+#endif /* FGL_VULKAN_DESCRIPTORS_HPP_INCLUDED */
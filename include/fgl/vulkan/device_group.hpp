@@ -0,0 +1,107 @@
+#ifndef FGL_VULKAN_DEVICE_GROUP_HPP_INCLUDED
+#define FGL_VULKAN_DEVICE_GROUP_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "context.hpp"
+#include "scheduler.hpp"
+#include "./internal/thread_pool.hpp"
+
+namespace fgl::vulkan
+{
+
+	/* One Context and QueueScheduler per compute capable physical device,
+		for spreading a problem over every GPU in the machine.
+
+		Work is split along one axis of the grid into contiguous slices
+		sized by each device's throughput. run() times every device's part
+		of a job and folds the rate into its estimate, so the next split
+		follows what the devices actually did. Devices share nothing: the
+		job creates buffers and pipelines per device and gathers its own
+		slice back to the host.
+
+		run() and set_throughput() are not thread safe.*/
+	class DeviceGroup
+	{
+	public:
+		// a contiguous range of the partitioned axis
+		struct Slice
+		{
+			std::size_t device;
+			uint32_t first;
+			uint32_t count;
+		};
+
+		using SliceJob = std::function<void( const Slice&, const Context&, QueueScheduler& )>;
+
+		// weight of a new measurement in a device's throughput estimate
+		static constexpr double smoothing { 0.5 };
+
+	private:
+		struct Member
+		{
+			std::unique_ptr<Context> context;
+			std::unique_ptr<QueueScheduler> scheduler;
+			double throughput { 0.0 }; // units per second, 0 until measured
+		};
+
+		std::vector<Member> members {};
+		internal::ThreadPool pool;
+
+		// throughputs, with the mean of the measured ones (or 1) for devices not yet measured
+		[[nodiscard]] std::vector<double> weights() const;
+
+	public:
+		DeviceGroup() = delete;
+		DeviceGroup( const DeviceGroup& ) = delete;
+
+		/* A Context from info on each device rank_physical_devices(info)
+			returns, best first and up to max_devices (0 for all of them).
+			contexts_per_device above 1 creates several independent Contexts
+			on every device, which exercises the partitioning on machines
+			with a single (software) device.*/
+		[[nodiscard]] explicit DeviceGroup(
+			const AppInfo& info,
+			const uint32_t max_devices = 0,
+			const uint32_t contexts_per_device = 1 );
+
+		[[nodiscard]] std::size_t size() const noexcept { return members.size(); }
+
+		[[nodiscard]] const Context& context( const std::size_t device ) const;
+
+		[[nodiscard]] QueueScheduler& scheduler( const std::size_t device ) const;
+
+		[[nodiscard]] double throughput( const std::size_t device ) const;
+
+		// seeds or overrides the estimate, in the units run() measures
+		void set_throughput( const std::size_t device, const double units_per_second );
+
+		/* Slices covering [0, extent) in device order, sized in proportion
+			to the throughputs (evenly until measured). Every slice is a
+			multiple of granularity but the last; devices whose share rounds
+			to nothing get no slice.*/
+		[[nodiscard]] std::vector<Slice> partition(
+			const uint32_t extent,
+			const uint32_t granularity = 1 ) const;
+
+		/* Runs job for every slice of partition( extent, granularity ), one
+			thread per device, waits for all of them and updates each device's
+			throughput from how long its slice took. Rethrows the first
+			exception a job threw once every job has finished.*/
+		std::vector<Slice> run(
+			const uint32_t extent,
+			const SliceJob& job,
+			const uint32_t granularity = 1 );
+
+		void print_devices() const;
+	};
+
+}
+
+#endif /* FGL_VULKAN_DEVICE_GROUP_HPP_INCLUDED */
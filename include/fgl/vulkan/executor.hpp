@@ -0,0 +1,173 @@
+#ifndef FGL_VULKAN_EXECUTOR_HPP_INCLUDED
+#define FGL_VULKAN_EXECUTOR_HPP_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "async.hpp"
+#include "autotune.hpp"
+#include "batch.hpp"
+#include "commandqueue.hpp"
+#include "context.hpp"
+#include "descriptors.hpp"
+#include "internal/mpsc_queue.hpp"
+#include "pipeline.hpp"
+
+namespace fgl::vulkan
+{
+
+	// one dispatch for the Executor
+	struct ComputeJob
+	{
+		const Pipeline* pipeline;
+
+		/* Bound whole at each Buffer's binding. The accesses also decide the
+			barriers between jobs sharing a command buffer (see
+			DispatchRecorder), so list every buffer the job touches.*/
+		std::vector<BufferAccess> buffers;
+
+		WorkgroupSize groups { 1, 1, 1 };
+		std::vector<std::byte> push_constants {};
+
+		// device memory the job keeps busy until it completes, counted against ExecutorOptions::memory_budget
+		vk::DeviceSize memory_bytes { 0 };
+	};
+
+	struct ExecutorOptions
+	{
+		std::size_t max_jobs_per_batch { 256 };
+		std::size_t max_in_flight { 3 }; // command buffers submitted and not yet complete
+		vk::DeviceSize memory_budget { 0 }; // 0 for no limit
+	};
+
+	/* A long running service executing compute jobs submitted from any
+		number of threads.
+
+		submit() pushes onto a lock-free queue and returns at once (unless
+		over the memory budget). A submitter thread takes everything queued,
+		up to max_jobs_per_batch, and records it into one command buffer in
+		arrival order, with barriers only where a job touches a buffer an
+		earlier job of the batch wrote (or writes one it read). While
+		max_in_flight command buffers are still executing it waits, so jobs
+		pile up and coalesce into larger batches the busier the GPU is.
+
+		Each batch starts with a barrier against the batches before it and
+		ends with one making its writes visible to the host and to transfers,
+		so a job's results can be read once its future is ready.
+
+		Backpressure: memory_bytes of every accepted job that hasn't
+		completed is reserved against memory_budget, and submit() blocks
+		while the job doesn't fit (try_submit() declines instead). A job
+		larger than the whole budget is accepted once nothing else is
+		reserved.
+
+		Buffers are bound through a DescriptorSetCache; evict() a buffer
+		before destroying it. The executor drives one queue of
+		Context::queue_family_index, so don't hand that queue to anything
+		used at the same time.*/
+	class Executor
+	{
+	public:
+		struct Statistics
+		{
+			uint64_t jobs { 0 }; // completed
+			uint64_t batches { 0 }; // command buffers submitted
+			uint64_t barriers { 0 }; // between jobs of the same batch
+			uint64_t declined { 0 }; // try_submit() over the budget
+		};
+
+	private:
+		struct Queued
+		{
+			ComputeJob job;
+			std::function<void()> on_complete;
+			std::promise<void> promise;
+		};
+
+		const std::size_t max_jobs_per_batch;
+		const std::size_t max_in_flight;
+		const vk::DeviceSize memory_budget;
+
+		DescriptorSetCache sets;
+		CommandBufferPool command_buffers; // recorded from the submitter thread only
+		internal::MpscQueue<Queued> queued_jobs {};
+
+		std::atomic<uint64_t> signals { 0 }; // bumped to wake the submitter
+		std::atomic<uint64_t> accepted { 0 };
+		std::atomic<uint64_t> completed { 0 };
+		std::atomic<uint64_t> reserved_bytes { 0 };
+		std::atomic<uint64_t> in_flight { 0 };
+		std::atomic<uint64_t> batch_count { 0 };
+		std::atomic<uint64_t> barrier_count { 0 };
+		std::atomic<uint64_t> declined_count { 0 };
+		std::atomic<bool> stopping { false };
+
+		// declared after everything its completion callbacks touch
+		AsyncQueue queue;
+		std::thread submitter;
+
+		// observed is what was reserved when the job didn't fit
+		[[nodiscard]] bool try_reserve( const vk::DeviceSize bytes, uint64_t& observed );
+		void reserve( const vk::DeviceSize bytes );
+		void release( const vk::DeviceSize bytes );
+
+		[[nodiscard]] std::future<void> enqueue( ComputeJob&& job, std::function<void()>&& on_complete );
+
+		void submit_loop();
+		void flush( std::vector<Queued>& batch );
+		void complete(
+			std::vector<Queued>& finished,
+			vk::raii::CommandBuffer& buffer,
+			const std::exception_ptr& error );
+
+	public:
+		Executor() = delete;
+		Executor( const Executor& ) = delete;
+
+		[[nodiscard]] explicit Executor(
+			const Context& context,
+			const ExecutorOptions& options = {},
+			const uint32_t queue_index = 0 );
+
+		// executes every accepted job before returning
+		~Executor();
+
+		/* Queues job from any thread, blocking while it doesn't fit the
+			memory budget. on_complete runs on the completion thread before
+			the future is fulfilled, with any exception it throws ending up
+			in the future, so keep it short. Throws std::invalid_argument
+			without a pipeline and std::length_error when the push constants
+			don't fit it.*/
+		[[nodiscard]] std::future<void> submit(
+			ComputeJob&& job,
+			std::function<void()> on_complete = {} );
+
+		// the same, but nullopt instead of blocking when over the budget (job is left as it was)
+		[[nodiscard]] std::optional<std::future<void>> try_submit(
+			ComputeJob& job,
+			std::function<void()> on_complete = {} );
+
+		// waits for every job accepted before the call
+		void wait_idle();
+
+		// forgets the descriptor sets of buffer, which no queued job may still use
+		void evict( const Buffer& buffer );
+
+		// memory_bytes of accepted jobs that haven't completed
+		[[nodiscard]] vk::DeviceSize reserved() const noexcept { return reserved_bytes.load( std::memory_order_relaxed ); }
+
+		[[nodiscard]] Statistics statistics() const noexcept;
+	};
+
+}
+
+#endif /* FGL_VULKAN_EXECUTOR_HPP_INCLUDED */
@@ -0,0 +1,213 @@
+#ifndef FGL_VULKAN_FRAME_RING_HPP_INCLUDED
+#define FGL_VULKAN_FRAME_RING_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "async.hpp"
+#include "commandqueue.hpp"
+#include "context.hpp"
+#include "descriptors.hpp"
+#include "memory.hpp"
+#include "pipeline.hpp"
+
+namespace fgl::vulkan
+{
+
+	// how a FrameRing buffer moves between host and device every iteration
+	enum class FrameTransfer
+	{
+		eNone, // device only, e.g. scratch
+		eUpload, // written by the host before the frame is submitted
+		eDownload, // read by the host once the frame completed (what it held before the shaders wrote it is undefined)
+		eUploadDownload
+	};
+
+	struct FrameBufferInfo
+	{
+		uint32_t binding;
+		vk::DeviceSize bytes;
+		FrameTransfer transfer;
+		vk::DescriptorType type { vk::DescriptorType::eStorageBuffer };
+	};
+
+	/* The resources of one iteration of a repeated workload, depth times
+		over, so the host prepares iteration k while the GPU still works
+		through the ones before it, with nothing created per iteration.
+
+		Every slot (Frame) has a device local buffer per FrameBufferInfo,
+		host visible staging buffers for the ones that move (separate for
+		upload and readback), command buffers, two semaphores and a fence.
+		acquire() hands out the slots in ring order, waiting for the
+		iteration a slot ran depth iterations ago; that iteration's results
+		stay readable in readback() until the slot is submitted again, after
+		the host wrote the next inputs to upload().
+
+		submit() splits an iteration in three submissions: the upload copies
+		on the transfer queue (Context::transfer_queue_family_index, queue
+		0, as the TransferEngine's), the caller's dispatches on the compute
+		queue and the readback copies on the transfer queue again, each
+		waiting for the one before it through the slot's semaphores (at
+		TimelinePoint iteration + 1 with Context::features.timeline_semaphore,
+		binary otherwise). Nothing orders one slot's work after another's,
+		and the only barriers are the ownership transfers of the slot's own
+		buffers between the two families, so the copy engine uploads k + 1
+		and reads back k - 1 while the compute queue runs k: with enough
+		depth an iteration costs about the slowest of upload, compute and
+		readback rather than their sum. So that the transfer queue doesn't
+		hold an upload back behind readback copies still waiting for their
+		dispatches, the readback of k goes out with iteration k + 1, after
+		its upload (or from wait() and drain(), if sooner). Not thread safe.*/
+	class FrameRing
+	{
+	public:
+		class Frame
+		{
+			friend class FrameRing;
+
+		public:
+			const std::size_t slot;
+
+			// device local, one per FrameBufferInfo in order, bound at its binding
+			std::vector<Buffer> buffers {};
+
+		private:
+			/* Host visible, apart for uploads and readbacks, so a buffer that
+				does both keeps its results readable while the next inputs are
+				written.*/
+			std::vector<Buffer> staging {};
+			std::vector<std::size_t> upload_index {}; // per buffer, into staging (out of range if it isn't uploaded)
+			std::vector<std::size_t> readback_index {}; // likewise for readbacks
+			vk::raii::CommandBuffer upload_commands; // of the transfer family
+			vk::raii::CommandBuffer command_buffer;
+			vk::raii::CommandBuffer readback_commands; // of the transfer family
+			vk::raii::Semaphore uploaded; // signaled by the upload copies for the dispatches
+			vk::raii::Semaphore computed; // signaled by the dispatches for the readback copies
+			vk::raii::Fence fence; // signaled by the iteration's last submission
+			bool in_flight { false };
+			uint64_t iteration { 0 };
+			std::optional<uint64_t> completed {};
+
+			[[nodiscard]] const Buffer& staging_for( const std::size_t buffer, const bool upload ) const;
+
+		public:
+			[[nodiscard]] explicit Frame(
+				const Context& context,
+				const std::span<const FrameBufferInfo> layout,
+				const std::size_t slot_,
+				vk::raii::CommandBuffer&& upload_commands_,
+				vk::raii::CommandBuffer&& command_buffer_,
+				vk::raii::CommandBuffer&& readback_commands_ );
+
+			// copied into buffers[buffer] when the frame is submitted; throws unless the buffer uploads
+			[[nodiscard]] std::span<std::byte> upload( const std::size_t buffer ) const;
+
+			/* What buffers[buffer] held when the slot's last iteration
+				completed; throws unless the buffer downloads.*/
+			[[nodiscard]] std::span<const std::byte> readback( const std::size_t buffer ) const;
+
+			template <typename T>
+				requires std::is_trivially_copyable_v<T>
+			[[nodiscard]] std::span<T> upload_view( const std::size_t buffer ) const
+			{
+				const auto bytes { upload( buffer ) };
+				return std::span<T>( reinterpret_cast< T* >( bytes.data() ), bytes.size() / sizeof( T ) );
+			}
+
+			template <typename T>
+				requires std::is_trivially_copyable_v<T>
+			[[nodiscard]] std::span<const T> readback_view( const std::size_t buffer ) const
+			{
+				const auto bytes { readback( buffer ) };
+				return std::span<const T>( reinterpret_cast< const T* >( bytes.data() ), bytes.size() / sizeof( T ) );
+			}
+
+			// the iteration readback() holds, if the slot completed one since it was last submitted
+			[[nodiscard]] std::optional<uint64_t> completed_iteration() const noexcept { return completed; }
+		};
+
+		// records the iteration's dispatches, reading and writing frame.buffers
+		using Recorder = std::function<void( const vk::raii::CommandBuffer&, const Frame& )>;
+
+		using Consumer = std::function<void( const Frame& )>;
+
+	private:
+		const vk::raii::Device& device;
+		const vk::raii::Queue queue;
+		const vk::raii::Queue transfer_queue;
+		const uint32_t compute_family;
+		const uint32_t transfer_family;
+		const bool timeline;
+		// declared before the frames, whose buffers they allocated
+		CommandBufferPool command_buffers;
+		CommandBufferPool transfer_command_buffers;
+		DescriptorSetCache sets;
+		std::vector<Frame> frames {};
+		std::size_t next { 0 };
+		uint64_t submitted { 0 };
+		std::optional<std::size_t> pending_readback {}; // the frame whose readback copies wait for the next submit()
+
+		// one stage of an iteration; wait and signal name one of a frame's semaphores
+		void submit_stage(
+			const vk::raii::Queue& target,
+			const vk::CommandBuffer buffer,
+			const std::optional<TimelinePoint>& wait,
+			const vk::PipelineStageFlags wait_stage,
+			const std::optional<TimelinePoint>& signal,
+			const vk::Fence fence ) const;
+
+		void submit_readback();
+
+	public:
+		const std::vector<FrameBufferInfo> layout;
+
+		static constexpr std::size_t default_depth { 3 };
+
+		FrameRing() = delete;
+		FrameRing( const FrameRing& ) = delete;
+
+		[[nodiscard]] explicit FrameRing(
+			const Context& context,
+			const std::span<const FrameBufferInfo> layout_,
+			const std::size_t depth = default_depth,
+			const uint32_t queue_index = 0 );
+
+		// waits for frames still in flight
+		~FrameRing();
+
+		/* The next slot in ring order, once the iteration it last ran has
+			completed; see Frame::completed_iteration().*/
+		[[nodiscard]] Frame& acquire();
+
+		/* Records and submits one iteration on frame: uploads, record (on the
+			compute queue), readbacks. Returns the iteration's number
+			(counting from 0). Throws std::logic_error if frame is still in
+			flight.*/
+		uint64_t submit( Frame& frame, const Recorder& record );
+
+		// blocks until frame's iteration completed, e.g. to read k - 1 right after submitting k
+		void wait( Frame& frame );
+
+		/* Waits for every frame in flight, oldest first, handing each to
+			consume (if any) once it completed.*/
+		void drain( const Consumer& consume = {} );
+
+		// every buffer of frame bound at its binding, in pipeline's layout
+		[[nodiscard]] vk::DescriptorSet descriptor_set( const Pipeline& pipeline, const Frame& frame );
+
+		[[nodiscard]] std::size_t depth() const noexcept { return frames.size(); }
+
+		// iterations submitted so far
+		[[nodiscard]] uint64_t iterations() const noexcept { return submitted; }
+	};
+
+}
+
+#endif /* FGL_VULKAN_FRAME_RING_HPP_INCLUDED */
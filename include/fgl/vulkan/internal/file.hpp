@@ -0,0 +1,17 @@
+#ifndef FGL_VULKAN_INTERNAL_FILE_HPP_INCLUDED
+#define FGL_VULKAN_INTERNAL_FILE_HPP_INCLUDED
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+namespace fgl::vulkan::internal
+{
+
+/* writes data to a sibling temp file and renames it over path, so readers
+never see a partially written file. creates missing parent directories*/
+void write_atomically( const std::filesystem::path& path, const std::span<const std::byte> data );
+
+}
+
+#endif /* FGL_VULKAN_INTERNAL_FILE_HPP_INCLUDED */
@@ -0,0 +1,73 @@
+#ifndef FGL_VULKAN_INTERNAL_MPSC_QUEUE_HPP_INCLUDED
+#define FGL_VULKAN_INTERNAL_MPSC_QUEUE_HPP_INCLUDED
+
+#include <atomic>
+#include <optional>
+#include <utility> // move
+
+namespace fgl::vulkan::internal
+{
+
+/* unbounded lock-free FIFO for many producers and a single consumer
+(Vyukov's node based queue). push() is one atomic exchange plus a store;
+pop() never touches anything a producer writes to except the next link.
+a pop() racing a push() can miss the element until that push() returns.
+push() allocates a node, so it's only lock-free as far as the allocator is*/
+template <typename T>
+class MpscQueue
+{
+	struct Node
+	{
+		std::atomic<Node*> next { nullptr };
+		std::optional<T> value {};
+	};
+
+	// producers append at head, the consumer takes from behind tail (a consumed node, the stub at first)
+	std::atomic<Node*> head;
+	Node* tail;
+
+public:
+	MpscQueue( const MpscQueue& ) = delete;
+
+	MpscQueue()
+		:
+		head( new Node {} ),
+		tail( head.load( std::memory_order_relaxed ) )
+	{}
+
+	// elements still queued are destroyed; nothing may push concurrently
+	~MpscQueue()
+	{
+		while( pop() )
+		{}
+		delete tail;
+	}
+
+	// any thread
+	void push( T value )
+	{
+		Node* const node { new Node {} };
+		node->value.emplace( std::move( value ) );
+
+		Node* const previous { head.exchange( node, std::memory_order_acq_rel ) };
+		previous->next.store( node, std::memory_order_release );
+	}
+
+	// the consumer thread only
+	[[nodiscard]] std::optional<T> pop()
+	{
+		Node* const next { tail->next.load( std::memory_order_acquire ) };
+		if( next == nullptr )
+			return std::nullopt;
+
+		std::optional<T> value { std::move( next->value ) };
+		next->value.reset();
+		delete tail;
+		tail = next;
+		return value;
+	}
+};
+
+}
+
+#endif /* FGL_VULKAN_INTERNAL_MPSC_QUEUE_HPP_INCLUDED */
@@ -0,0 +1,56 @@
+#ifndef FGL_VULKAN_INTERNAL_THREAD_POOL_HPP_INCLUDED
+#define FGL_VULKAN_INTERNAL_THREAD_POOL_HPP_INCLUDED
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace fgl::vulkan::internal
+{
+
+/* fixed set of worker threads draining a FIFO of jobs.
+the destructor finishes every queued job before joining*/
+class ThreadPool
+{
+	std::mutex mutex {};
+	std::condition_variable cv {};
+	std::deque<std::function<void()>> jobs {};
+	bool stopping { false };
+	std::vector<std::thread> workers {};
+
+	void worker_loop();
+	void enqueue( std::function<void()>&& job );
+
+public:
+	ThreadPool( const ThreadPool& ) = delete;
+
+	// 0 uses std::thread::hardware_concurrency()
+	[[nodiscard]] explicit ThreadPool( const std::size_t thread_count = 0 );
+
+	~ThreadPool();
+
+	template <typename F>
+	[[nodiscard]] std::future<std::invoke_result_t<F>> submit( F&& function )
+	{
+		// packaged_task is move-only but std::function needs a copyable callable
+		auto task {
+			std::make_shared<std::packaged_task<std::invoke_result_t<F>()>>( std::forward<F>( function ) )
+		};
+		auto future { task->get_future() };
+		enqueue( [task] { ( *task )(); } );
+		return future;
+	}
+
+	[[nodiscard]] std::size_t size() const noexcept { return workers.size(); }
+};
+
+}
+
+#endif /* FGL_VULKAN_INTERNAL_THREAD_POOL_HPP_INCLUDED */
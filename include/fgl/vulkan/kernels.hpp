@@ -0,0 +1,140 @@
+#ifndef FGL_VULKAN_KERNELS_HPP_INCLUDED
+#define FGL_VULKAN_KERNELS_HPP_INCLUDED
+
+#include <concepts>
+#include <cstdint>
+#include <filesystem>
+#include <ranges>
+#include <string>
+#include <string_view>
+
+#include "autotune.hpp"
+#include "pipeline.hpp"
+
+namespace fgl::vulkan
+{
+
+	/* Compute kernels shipped with the project. Their sources live in
+		src/kernels (Square.comp in src) and the build compiles each to
+		<name>.spv next to the executable.
+
+		Every kernel takes its workgroup size through the
+		Specialization::workgroup_size constants and its parameters as
+		push constants.*/
+	enum class Kernel
+	{
+		// out[y * n + x] = in[y] * in[x], one output per invocation
+		eSquare,
+		// the same product tiled through shared memory, 4 x rows outputs per invocation
+		eOuterProduct,
+		// one partial per block, shared memory tree (see Reduction)
+		eReduce,
+		// the same with subgroup arithmetic
+		eReduceSubgroup,
+		// block scan and block prefix passes, shared memory tree (see Scan)
+		eScan,
+		// the same with subgroup arithmetic
+		eScanSubgroup,
+		// digit count and scatter passes of an LSD radix sort (see RadixSort)
+		eRadixSort,
+		// the same with subgroup arithmetic
+		eRadixSortSubgroup
+	};
+
+	struct KernelInfo
+	{
+		std::string_view name;
+		std::string_view entry_point;
+		uint32_t push_constant_size;
+		WorkgroupSize workgroup_size; // used unless the specialization sets one
+		WorkgroupSize outputs_per_invocation;
+	};
+
+	/* Push constants of both kernels. OuterProduct computes the rows
+		output rows from first_row on, into the start of its output;
+		Square only reads n and always computes all of them.*/
+	struct OuterProductParameters
+	{
+		uint32_t n;
+		uint32_t first_row { 0 };
+		uint32_t rows { n };
+	};
+
+	// push constants of the Reduce kernels, offsets in elements
+	struct ReduceParameters
+	{
+		uint32_t count;
+		uint32_t input_offset;
+		uint32_t output_offset;
+	};
+
+	// push constants of the Scan kernels, offsets in elements
+	struct ScanParameters
+	{
+		uint32_t count;
+		uint32_t input_offset;
+		uint32_t output_offset;
+		uint32_t sums_offset;
+		uint32_t exclusive;
+	};
+
+	// push constants of the RadixSort kernels
+	struct RadixSortParameters
+	{
+		uint32_t count;
+		uint32_t shift;
+		uint32_t block_count;
+		uint32_t first_block;
+	};
+
+	// constant id of the outer product's rows per invocation
+	inline constexpr uint32_t outer_product_rows_id { 3 };
+
+	[[nodiscard]] const KernelInfo& kernel_info( const Kernel kernel );
+
+	// <name>.spv in directory (the working directory by default)
+	[[nodiscard]] std::filesystem::path kernel_path(
+		const Kernel kernel,
+		const std::filesystem::path& directory = {} );
+
+	/* Specialization with the kernel's default workgroup size (and tile
+		shape), overridden by whatever specialization already sets.*/
+	[[nodiscard]] Specialization kernel_specialization(
+		const Kernel kernel,
+		const Specialization& specialization = {} );
+
+	// workgroups covering problem_size with workgroup_size invocations per group
+	[[nodiscard]] WorkgroupSize kernel_group_count(
+		const Kernel kernel,
+		const WorkgroupSize& problem_size,
+		const WorkgroupSize& workgroup_size );
+
+	// the same for the workgroup size pipeline was compiled with
+	[[nodiscard]] WorkgroupSize kernel_group_count(
+		const Kernel kernel,
+		const WorkgroupSize& problem_size,
+		const Specialization& specialization );
+
+	// Pipeline for one of the library's kernels
+	template <PipelineBindings T>
+	[[nodiscard]] Pipeline make_pipeline(
+		const Context& context,
+		const Kernel kernel,
+		const T& buffers,
+		const Specialization& specialization = {},
+		const std::filesystem::path& directory = {} )
+	{
+		const KernelInfo& info { kernel_info( kernel ) };
+		return Pipeline(
+			context,
+			kernel_path( kernel, directory ),
+			std::string( info.entry_point ),
+			buffers,
+			info.push_constant_size,
+			kernel_specialization( kernel, specialization )
+		);
+	}
+
+}
+
+#endif /* FGL_VULKAN_KERNELS_HPP_INCLUDED */
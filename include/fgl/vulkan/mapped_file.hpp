@@ -0,0 +1,153 @@
+#ifndef FGL_VULKAN_MAPPED_FILE_HPP_INCLUDED
+#define FGL_VULKAN_MAPPED_FILE_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <type_traits>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "context.hpp"
+#include "memory.hpp"
+#include "transfer.hpp"
+
+namespace fgl::vulkan
+{
+
+	/* A whole file mapped into the address space (mmap, or a file mapping
+		on Windows), so its contents can be handed to the TransferEngine or
+		copied into host visible Buffers without reading them into a heap
+		copy first. The mapping is page aligned.
+
+		Writes through writable_bytes() reach the file when the pages are
+		written back, at the latest on destruction; flush() forces it.
+		Truncating the file from elsewhere while it is mapped faults on
+		access, as with any mapping.*/
+	class MappedFile
+	{
+	public:
+		enum class Mode
+		{
+			eRead,
+			eReadWrite
+		};
+
+	private:
+		std::byte* data { nullptr };
+		std::size_t bytesize { 0 };
+#ifdef _WIN32
+		void* file_handle { nullptr };
+		void* mapping_handle { nullptr };
+#else
+		int descriptor { -1 };
+#endif
+
+		void map( const bool create, const std::size_t create_size );
+		void unmap() noexcept;
+
+	public:
+		const std::filesystem::path path;
+		const Mode mode;
+
+		MappedFile() = delete;
+		MappedFile( const MappedFile& ) = delete;
+
+		// maps an existing file
+		[[nodiscard]] explicit MappedFile( const std::filesystem::path& path_, const Mode mode_ = Mode::eRead );
+
+		// creates path (or truncates it) at size bytes and maps it for writing
+		[[nodiscard]] explicit MappedFile( const std::filesystem::path& path_, const std::size_t size );
+
+		~MappedFile();
+
+		[[nodiscard]] std::size_t size() const noexcept { return bytesize; }
+
+		[[nodiscard]] std::span<const std::byte> bytes() const noexcept { return { data, bytesize }; }
+
+		// throws unless mapped eReadWrite
+		[[nodiscard]] std::span<std::byte> writable_bytes() const;
+
+		// the file as whole Ts, any trailing partial T left out
+		template <typename T>
+			requires std::is_trivially_copyable_v<T>
+		[[nodiscard]] std::span<const T> view() const noexcept
+		{
+			return std::span<const T>( reinterpret_cast< const T* >( data ), bytesize / sizeof( T ) );
+		}
+
+		template <typename T>
+			requires std::is_trivially_copyable_v<T>
+		[[nodiscard]] std::span<T> writable_view() const
+		{
+			const auto bytes { writable_bytes() };
+			return std::span<T>( reinterpret_cast< T* >( bytes.data() ), bytes.size() / sizeof( T ) );
+		}
+
+		// hints that the file will be read front to back (no-op where unsupported)
+		void advise_sequential() const noexcept;
+
+		// writes dirty pages of the byte range back to the file and waits for it
+		void flush( const std::size_t offset = 0, const std::size_t size = SIZE_MAX ) const;
+	};
+
+	/* Copies file from byte file_offset into destination without a heap
+		copy: memcpy in large chunks into a host visible destination,
+		otherwise through transfer's staging ring (complete after
+		transfer.wait()). The whole rest of the file unless size is given.*/
+	void load_file(
+		TransferEngine& transfer,
+		const MappedFile& file,
+		const Buffer& destination,
+		const vk::DeviceSize destination_offset = 0,
+		const std::size_t file_offset = 0,
+		const std::size_t size = SIZE_MAX );
+
+	/* The reverse, into a file mapped eReadWrite; through the staging ring
+		the bytes land in the file's pages on transfer.wait().*/
+	void store_file(
+		TransferEngine& transfer,
+		const Buffer& source,
+		const MappedFile& file,
+		const vk::DeviceSize source_offset = 0,
+		const std::size_t file_offset = 0,
+		const std::size_t size = SIZE_MAX );
+
+	/* Host memory the device accesses in place through
+		VK_EXT_external_memory_host: a mapped file (or any page aligned
+		range) becomes a storage buffer with no copy at all, which kernels
+		read over the bus or a copy on the device queue pulls into device
+		local memory.
+
+		can_import() says whether the device has the extension and the range
+		meets minImportedHostPointerAlignment in address and size. The host
+		memory has to outlive the buffer.*/
+	class ImportedBuffer
+	{
+	public:
+		const uint32_t binding;
+		const vk::DescriptorType buffer_type;
+		const vk::DeviceSize bytesize;
+		vk::raii::Buffer buffer;
+		vk::raii::DeviceMemory memory; // after buffer, whose requirements pick its type
+
+		ImportedBuffer() = delete;
+		ImportedBuffer( const ImportedBuffer& ) = delete;
+
+		[[nodiscard]] static bool can_import( const Context& context, const std::span<const std::byte> host );
+
+		/* Throws std::invalid_argument when can_import() is false and
+			vk::SystemError when the driver refuses the pointer (some only
+			take anonymous memory, not file mappings).*/
+		[[nodiscard]] explicit ImportedBuffer(
+			const Context& context,
+			const std::span<const std::byte> host,
+			const vk::BufferUsageFlags usageflags,
+			const uint32_t binding_,
+			const vk::DescriptorType type = vk::DescriptorType::eStorageBuffer );
+	};
+
+}
+
+#endif /* FGL_VULKAN_MAPPED_FILE_HPP_INCLUDED */
@@ -2,10 +2,14 @@
 #define FGL_VULKAN_MEMORY_HPP_INCLUDED
 
 #include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
 #include <vector>
 
 #include <vulkan/vulkan_raii.hpp>
 
+#include "arena.hpp"
 #include "context.hpp"
 
 #include <iostream>
@@ -20,10 +24,7 @@ namespace fgl::vulkan
 		const vk::DescriptorType buffer_type;
 		const vk::DeviceSize bytesize;
 		vk::raii::Buffer buffer;
-		vk::raii::DeviceMemory memory;
-
-		//Static memory
-		static size_t bytecount;
+		Allocation memory;
 
 		Buffer() = delete;
 		Buffer( const Buffer& ) = delete;
@@ -32,18 +33,39 @@ namespace fgl::vulkan
 		[[nodiscard]] explicit Buffer(
 			const Context& context,
 			const vk::DeviceSize& size,
-			const vk::BufferUsageFlagBits usageflags,
+			const vk::BufferUsageFlags usageflags,
 			const vk::SharingMode sharingmode,
 			const uint32_t binding_,
 			const vk::MemoryPropertyFlags flags,
-			const vk::DescriptorType type );
+			const vk::DescriptorType type,
+			const vk::MemoryPropertyFlags preferred_flags = {} );
 
-		void* get_memory() const;
+		/* Typed view of the persistently mapped memory.
+			The memory is mapped for the lifetime of the buffer, so the span
+			may be handed to producer threads and written to directly.
+			Throws if the buffer is not host visible.*/
+		template <typename T>
+			requires std::is_trivially_copyable_v<T>
+		[[nodiscard]] std::span<T> view() const
+		{
+			return std::span<T>( static_cast< T* >( memory.mapped() ), bytesize / sizeof( T ) );
+		}
 
-		~Buffer()
+		template <typename T>
+			requires std::is_trivially_copyable_v<T>
+		[[nodiscard]] std::span<T> view( const std::size_t first, const std::size_t count ) const
 		{
-			bytecount -= bytesize;
+			const auto whole { view<T>() };
+			if( first > whole.size() || count > whole.size() - first )
+			{
+				throw std::out_of_range( "Buffer view exceeds the size of the buffer." );
+			}
+			return whole.subspan( first, count );
 		}
+
+		// byte ranges, throwing std::out_of_range past the end; both are no-ops on host coherent memory
+		void flush( const vk::DeviceSize offset = 0, const vk::DeviceSize size = VK_WHOLE_SIZE ) const;
+		void invalidate( const vk::DeviceSize offset = 0, const vk::DeviceSize size = VK_WHOLE_SIZE ) const;
 	};
 
 }
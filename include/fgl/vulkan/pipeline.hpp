@@ -1,13 +1,21 @@
 #ifndef FGL_VULKAN_PIPELINE_HPP_INCLUDE
 #define FGL_VULKAN_PIPELINE_HPP_INCLUDE
 
+#include <array>
+#include <bit>
 #include <string>
 #include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <filesystem>
 #include <iostream>
 #include <ranges>
 #include <concepts>
 #include <cassert>
+#include <cstddef>
+#include <span>
+#include <type_traits>
 
 #include <vulkan/vulkan_raii.hpp>
 #include "context.hpp"
@@ -18,15 +26,98 @@
 namespace fgl::vulkan
 {
 
+	/* Values for a shader's specialization constants, keyed by constant_id.
+		Values are kept as their 32-bit pattern (int, uint, float, or bool
+		as VkBool32); 64-bit constants aren't supported. Ordered so it can
+		key the variant cache.*/
+	class Specialization
+	{
+		std::map<uint32_t, uint32_t> constants {};
+
+	public:
+		// constant ids the kernels use for layout( local_size_x_id = 0, ... ) in
+		static constexpr std::array<uint32_t, 3> workgroup_size_ids { 0, 1, 2 };
+
+		template <typename T>
+			requires std::same_as<T, bool>
+			|| ( sizeof( T ) == sizeof( uint32_t ) && std::is_trivially_copyable_v<T> )
+		Specialization& set( const uint32_t constant_id, const T value )
+		{
+			if constexpr( std::same_as<T, bool> )
+				constants[constant_id] = value ? VK_TRUE : VK_FALSE;
+			else
+				constants[constant_id] = std::bit_cast< uint32_t >( value );
+			return *this;
+		}
+
+		Specialization& workgroup_size(
+			const uint32_t x,
+			const uint32_t y = 1,
+			const uint32_t z = 1 );
+
+		[[nodiscard]] bool empty() const noexcept { return constants.empty(); }
+
+		[[nodiscard]] const std::map<uint32_t, uint32_t>& values() const noexcept { return constants; }
+
+		auto operator<=>( const Specialization& ) const = default;
+	};
+
+	/* Workgroup size that suits the device: x spans one subgroup (capped
+		by the limits) so rows stay contiguous, and a few subgroups per
+		workgroup go to y for 2 dimensions. z is always 1.*/
+	[[nodiscard]] std::array<uint32_t, 3> preferred_workgroup_size(
+		const Context& context,
+		const uint32_t dimensions = 1 );
+
+	/* A binding of a Pipeline created without buffers. Its own sets are
+		left unwritten, so every dispatch binds a set from a
+		DescriptorSetCache instead.*/
+	struct BindingSlot
+	{
+		uint32_t binding;
+		vk::DescriptorType buffer_type;
+	};
+
+	// Buffers or BindingSlots, one per binding of the pipeline's set
+	template <typename T>
+	concept PipelineBindings = std::ranges::forward_range<T>
+		&& ( std::same_as<std::ranges::range_value_t<T>, fgl::vulkan::Buffer>
+			|| std::same_as<std::ranges::range_value_t<T>, BindingSlot> );
+
+	/* A struct mirroring a shader's layout( push_constant ) block. Kept to
+		the 128 bytes every device supports, in whole 32-bit words.*/
+	template <typename T>
+	concept PushConstantBlock = std::is_class_v<T>
+		&& std::is_trivially_copyable_v<T>
+		&& std::is_standard_layout_v<T>
+		&& sizeof( T ) % sizeof( uint32_t ) == 0
+		&& sizeof( T ) <= 128;
+
+	// push_constant_size for a Pipeline taking a T per dispatch
+	template <PushConstantBlock T>
+	inline constexpr uint32_t push_constant_size { sizeof( T ) };
+
+	// block as the push_constants of a dispatch; block must outlive recording
+	template <PushConstantBlock T>
+	[[nodiscard]] std::span<const std::byte> push_constant_bytes( const T& block ) noexcept
+	{
+		return std::as_bytes( std::span<const T, 1>( &block, 1 ) );
+	}
+
 	class Pipeline
 	{
+		const Context& context;
+		const std::string entry_point;
+
+		mutable std::mutex variants_mutex {};
+		mutable std::map<Specialization, std::unique_ptr<vk::raii::Pipeline>> variants {};
+
 		[[nodiscard]] vk::raii::ShaderModule create_shader_module(
 			const Context& cntx,
 			const std::filesystem::path path
 		) const;
 
-		template <std::ranges::forward_range T>
-			requires std::same_as<std::ranges::range_value_t<T>, fgl::vulkan::Buffer>
+		template <PipelineBindings T>
 		[[nodiscard]] vk::raii::DescriptorSetLayout create_descriptor_set_layout(
 			const Context& cntx,
 			const T& buffers )
@@ -50,23 +141,25 @@ namespace fgl::vulkan
 			return vk::raii::DescriptorSetLayout( cntx.device, ci );
 		}
 
-		template <std::ranges::forward_range T>
-			requires std::same_as<std::ranges::range_value_t<T>, fgl::vulkan::Buffer>
+		template <PipelineBindings T>
 		[[nodiscard]] vk::raii::DescriptorPool create_descriptor_pool(
 			const Context& cntx,
 			const T& buffers ) const
 		{
+			// one pool size per descriptor type, so mixed storage/uniform layouts fit
+			std::map<vk::DescriptorType, uint32_t> counts;
+			for( const auto& buffer : buffers )
+				++counts[buffer.buffer_type];
+
+			std::vector<vk::DescriptorPoolSize> poolsizes;
+			for( const auto& [type, count] : counts )
+				poolsizes.emplace_back( type, count );
+
 			constexpr uint32_t max_sets { 1 };
-			constexpr uint32_t pool_size_count { 1 };
-			const vk::DescriptorPoolSize poolsize {
-				std::ranges::begin( buffers )->buffer_type,
-				static_cast< uint32_t >( std::ranges::size( buffers ) )
-			};
 			const vk::DescriptorPoolCreateInfo ci(
 				vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet,
 				max_sets,
-				pool_size_count,
-				&poolsize
+				poolsizes
 			);
 			return vk::raii::DescriptorPool( cntx.device, ci );
 		}
@@ -76,7 +169,8 @@ namespace fgl::vulkan
 
 		[[nodiscard]] vk::raii::Pipeline create_pipeline(
 			const Context& cntx,
-			const std::string init_function_name
+			const std::string& init_function_name,
+			const Specialization& spec
 		) const;
 
 		[[nodiscard]]
@@ -84,6 +178,10 @@ namespace fgl::vulkan
 
 	public:
 
+		// bytes of push constants the compute stage may receive (0 for none)
+		const uint32_t push_constant_size;
+		// what pipeline was compiled with
+		const Specialization specialization;
 		vk::raii::ShaderModule shader_module;
 		vk::raii::DescriptorSetLayout descriptor_set_layouts;
 		vk::raii::DescriptorPool pool;
@@ -93,21 +191,42 @@ namespace fgl::vulkan
 
 		Pipeline() = delete;
 
-		template <std::ranges::forward_range T>
-			requires std::same_as<std::ranges::range_value_t<T>, fgl::vulkan::Buffer>
+		template <PipelineBindings T>
 		[[nodiscard]] explicit
 			Pipeline(
 				const Context& cntx,
 				const std::filesystem::path& shaderpath,
 				const std::string& shader_init_name,
-				const T& buffers )
+				const T& buffers,
+				const uint32_t push_constant_size_ = 0,
+				const Specialization& specialization_ = {} )
 			:
+			context( cntx ),
+			entry_point( shader_init_name ),
+			push_constant_size( push_constant_size_ ),
+			specialization( specialization_ ),
 			shader_module( create_shader_module( cntx, shaderpath ) ),
 			descriptor_set_layouts( create_descriptor_set_layout( cntx, buffers ) ),
 			pool( create_descriptor_pool( cntx, buffers ) ),
 			layout( create_pipeline_layout( cntx ) ),
-			pipeline( create_pipeline( cntx, shader_init_name ) ),
+			pipeline( create_pipeline( cntx, shader_init_name, specialization ) ),
 			sets( create_descriptor_sets( cntx ) )
+		{
+			if constexpr( std::same_as<std::ranges::range_value_t<T>, fgl::vulkan::Buffer> )
+				write_descriptor_sets( cntx, buffers );
+
+			std::cout << "\n\tConstructed Pipeline with " << std::ranges::size( buffers ) << " bindings." << std::endl;
+		}
+
+		/* The same shader, layout and descriptor sets compiled with other
+			specialization constants. Each variant is compiled on first
+			request and cached for the pipeline's lifetime.*/
+		[[nodiscard]] const vk::raii::Pipeline& variant( const Specialization& spec ) const;
+
+	private:
+		template <std::ranges::forward_range T>
+			requires std::same_as<std::ranges::range_value_t<T>, fgl::vulkan::Buffer>
+		void write_descriptor_sets( const Context& cntx, const T& buffers )
 		{
 			std::vector<vk::WriteDescriptorSet> writeset;
 			std::vector<vk::DescriptorBufferInfo> bufferinfo;
@@ -122,6 +241,10 @@ namespace fgl::vulkan
 			constexpr uint32_t array_element { 0 };
 			constexpr uint32_t descriptor_count { 1 };
 
+			/* Dynamic buffers are bound whole here as well, so this set only
+				takes a dynamic offset of 0. Slices come from a set with an
+				explicit range (see DescriptorSetCache).*/
+
 			/* Simultaneously iterate over buffers, bufferinfo, and writeset.
 				Constructs and assigns elements which are associated by order.
 				Both writeset and info are constructed from a buffer.
@@ -145,7 +268,6 @@ namespace fgl::vulkan
 			}
 
 			cntx.device.updateDescriptorSets( writeset, nullptr );
-			std::cout << "\n\tConstructed Pipeline with " << buffers.size() << " buffers." << std::endl;
 		}
 	};
 
@@ -0,0 +1,227 @@
+#ifndef FGL_VULKAN_PRIMITIVES_HPP_INCLUDED
+#define FGL_VULKAN_PRIMITIVES_HPP_INCLUDED
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "context.hpp"
+#include "descriptors.hpp"
+#include "memory.hpp"
+#include "pipeline.hpp"
+#include "scheduler.hpp"
+
+namespace fgl::vulkan
+{
+
+	// OPERATION in src/kernels/primitives.glsl
+	enum class ReduceOperation : uint32_t
+	{
+		eSum = 0,
+		eMin = 1,
+		eMax = 2
+	};
+
+	// the value combining with x to x (0 for sum and max, ~0 for min)
+	[[nodiscard]] uint32_t identity( const ReduceOperation operation ) noexcept;
+
+	// the operation on the host, for references and for combining results
+	[[nodiscard]] uint32_t combine( const ReduceOperation operation, const uint32_t a, const uint32_t b ) noexcept;
+
+	/* Sum, min or max of uint32_t elements of a Buffer on the GPU.
+
+		Every pass reduces each block of workgroup_size * items_per_invocation
+		elements to one partial, repeated over the partials until a single
+		value is left. Passes with more blocks than maxComputeWorkGroupCount
+		are split over several dispatches. Workgroups reduce through subgroup
+		arithmetic when Context::subgroup_arithmetic is set and through a
+		shared memory tree otherwise.
+
+		Buffers are bound through a DescriptorSetCache; evict() a buffer
+		before destroying it. Not thread safe.*/
+	class Reduction
+	{
+	public:
+		const ReduceOperation operation;
+		const uint32_t max_elements;
+		const uint32_t workgroup_size;
+
+		static constexpr uint32_t items_per_invocation { 4 };
+
+	private:
+		const uint32_t block_size;
+		const uint32_t max_groups;
+		Buffer scratch; // partials of every pass but the last
+		Buffer result_buffer; // host visible
+		const Pipeline pipeline;
+		DescriptorSetCache sets;
+
+	public:
+		Reduction() = delete;
+		Reduction( const Reduction& ) = delete;
+
+		// kernel_directory holds the compiled kernels (see kernel_path)
+		[[nodiscard]] explicit Reduction(
+			const Context& context,
+			const ReduceOperation operation_,
+			const uint32_t max_elements_,
+			const std::filesystem::path& kernel_directory = {} );
+
+		/* Records the passes over count elements of input from element
+			first on, and a barrier that makes result() valid on the host
+			once buffer has completed.*/
+		void record(
+			const vk::raii::CommandBuffer& buffer,
+			const Buffer& input,
+			const uint32_t count,
+			const uint32_t first = 0 );
+
+		// the result of the last recorded reduction that completed
+		[[nodiscard]] uint32_t result() const;
+
+		// records on scheduler, waits and returns result()
+		[[nodiscard]] uint32_t run(
+			QueueScheduler& scheduler,
+			const Buffer& input,
+			const uint32_t count,
+			const uint32_t first = 0 );
+
+		void evict( const Buffer& buffer );
+	};
+
+	/* Inclusive or exclusive prefix sum, min or max of uint32_t elements
+		on the GPU, in place or into another Buffer.
+
+		Multi-pass: the first pass scans each block and writes the block
+		totals, which are scanned (exclusively) by the same kernel until a
+		single block is left. A second pass then walks back down, combining
+		every element with the prefix of its block. Workgroups scan through
+		subgroup arithmetic when Context::subgroup_arithmetic is set and
+		through shared memory otherwise.
+
+		Buffers are bound through a DescriptorSetCache; evict() a buffer
+		before destroying it. Not thread safe.*/
+	class Scan
+	{
+	public:
+		const ReduceOperation operation;
+		const uint32_t max_elements;
+		const uint32_t workgroup_size;
+
+		static constexpr uint32_t items_per_invocation { 4 };
+
+	private:
+		const uint32_t block_size;
+		const uint32_t max_groups;
+		Buffer scratch; // block totals of every pass
+		const Pipeline scan_blocks;
+		const Pipeline add_block_prefix;
+		DescriptorSetCache sets;
+
+	public:
+		Scan() = delete;
+		Scan( const Scan& ) = delete;
+
+		[[nodiscard]] explicit Scan(
+			const Context& context,
+			const ReduceOperation operation_,
+			const uint32_t max_elements_,
+			const std::filesystem::path& kernel_directory = {} );
+
+		/* Records the passes scanning count elements of input into output
+			(which may be input), followed by a barrier for compute shader
+			and transfer reads of output.*/
+		void record(
+			const vk::raii::CommandBuffer& buffer,
+			const Buffer& input,
+			const Buffer& output,
+			const uint32_t count,
+			const bool exclusive = false );
+
+		// records on scheduler and waits
+		void run(
+			QueueScheduler& scheduler,
+			const Buffer& input,
+			const Buffer& output,
+			const uint32_t count,
+			const bool exclusive = false );
+
+		void evict( const Buffer& buffer );
+	};
+
+	/* Stable LSD radix sort of uint32_t keys, optionally carrying a
+		uint32_t value per key (an index, say), in place on the GPU.
+
+		Eight passes over 4 bit digits. Each pass counts the digits of every
+		block, scans the counts with Scan, and scatters each block's keys
+		to the scanned offsets in input order. Passes ping-pong with
+		internal buffers, and the eight of them leave the keys in the input buffer.
+
+		Buffers are bound through a DescriptorSetCache; evict() a buffer
+		before destroying it. Not thread safe.*/
+	class RadixSort
+	{
+	public:
+		const uint32_t max_elements;
+		const uint32_t workgroup_size;
+
+		static constexpr uint32_t items_per_invocation { 4 };
+		static constexpr uint32_t radix_bits { 4 };
+		static constexpr uint32_t radix { 1u << radix_bits };
+
+	private:
+		const uint32_t block_size;
+		const uint32_t max_groups;
+		Buffer scratch_keys;
+		std::optional<Buffer> scratch_values;
+		Buffer histogram; // radix counts per block, digit major
+		const Pipeline count_digits;
+		const Pipeline scatter_keys;
+		const Pipeline scatter_pairs;
+		Scan scan;
+		DescriptorSetCache sets;
+
+		void record_passes(
+			const vk::raii::CommandBuffer& buffer,
+			const Buffer& keys,
+			const Buffer* values,
+			const uint32_t count );
+
+	public:
+		RadixSort() = delete;
+		RadixSort( const RadixSort& ) = delete;
+
+		// with_values allocates the scratch space sorting key/value pairs needs
+		[[nodiscard]] explicit RadixSort(
+			const Context& context,
+			const uint32_t max_elements_,
+			const bool with_values = false,
+			const std::filesystem::path& kernel_directory = {} );
+
+		/* Records sorting the first count keys, followed by a barrier for
+			compute shader and transfer reads of keys.*/
+		void record(
+			const vk::raii::CommandBuffer& buffer,
+			const Buffer& keys,
+			const uint32_t count );
+
+		// the same moving values[i] along with keys[i]; needs with_values
+		void record(
+			const vk::raii::CommandBuffer& buffer,
+			const Buffer& keys,
+			const Buffer& values,
+			const uint32_t count );
+
+		// records on scheduler and waits
+		void run( QueueScheduler& scheduler, const Buffer& keys, const uint32_t count );
+
+		void run( QueueScheduler& scheduler, const Buffer& keys, const Buffer& values, const uint32_t count );
+
+		void evict( const Buffer& buffer );
+	};
+
+}
+
+#endif /* FGL_VULKAN_PRIMITIVES_HPP_INCLUDED */
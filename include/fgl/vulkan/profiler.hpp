@@ -0,0 +1,188 @@
+#ifndef FGL_VULKAN_PROFILER_HPP_INCLUDED
+#define FGL_VULKAN_PROFILER_HPP_INCLUDED
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "context.hpp"
+#include "pipeline.hpp"
+
+namespace fgl::vulkan
+{
+
+	/* GPU timings for named spans of command buffer work.
+
+		begin()/end() around commands write a timestamp pair (and, for
+		compute spans on devices with pipelineStatisticsQuery, count the
+		compute shader invocations in between). Once the work has executed,
+		resolve() reads every finished span, adds its duration to the
+		per-name samples and keeps it as a GPU event for the trace. Spans
+		whose work hasn't completed stay pending for a later resolve().
+
+		Freed slots are reset on the host where the device has
+		host_query_reset (Context::features), so spans may be recorded on
+		any queue family with timestamps. Without it begin() records the
+		reset into the span's command buffer, which only compute (and
+		graphics) families accept, and resolve() skips slots still
+		holding results it already read.
+
+		GPU ticks are put on the host clock with a one-off calibration at
+		construction (a lone timestamp bracketed by host time on queue 0 of
+		the compute family), so CPU and GPU events line up in the trace to
+		within one submit latency.*/
+	class Profiler
+	{
+	public:
+		using clock = std::chrono::steady_clock;
+
+		struct KernelStatistics
+		{
+			std::size_t runs { 0 };
+			double min_ms { 0.0 };
+			double median_ms { 0.0 };
+			double p99_ms { 0.0 };
+			std::optional<double> invocations {}; // average, with pipeline statistics only
+		};
+
+	private:
+		struct Span
+		{
+			std::string name;
+			bool statistics;
+			uint32_t queue_family_index; // whose timestampValidBits apply
+		};
+
+		struct Event
+		{
+			std::string name;
+			bool gpu;
+			double start_us; // since origin
+			double duration_us;
+		};
+
+		struct Samples
+		{
+			std::vector<double> milliseconds {};
+			std::vector<uint64_t> invocations {};
+		};
+
+		const Context& context;
+		const std::vector<uint32_t> timestamp_valid_bits; // per queue family
+		const std::vector<vk::QueueFlags> queue_flags; // per queue family
+		const bool host_reset;
+		const double timestamp_period; // nanoseconds per tick
+		const vk::raii::QueryPool timestamps;
+		const std::optional<vk::raii::QueryPool> statistics;
+		const clock::time_point origin;
+
+		// host time of calibration_tick
+		clock::time_point calibration_time {};
+		uint64_t calibration_tick { 0 };
+
+		mutable std::mutex mutex {};
+		std::vector<std::optional<Span>> slots;
+		std::vector<uint32_t> free_slots {};
+		// without host_reset: begin and end ticks resolve() last read per slot, until the slot's reset executes
+		std::vector<std::array<uint64_t, 2>> resolved_ticks;
+		std::map<std::string, Samples> samples {};
+		std::vector<Event> events {};
+
+		void calibrate();
+
+		// back on the free list; with the mutex held
+		void release( const uint32_t slot );
+
+		[[nodiscard]] double host_microseconds( const uint64_t tick ) const;
+
+	public:
+		const uint32_t capacity;
+
+		static constexpr uint32_t default_capacity { 256 };
+
+		Profiler() = delete;
+		Profiler( const Profiler& ) = delete;
+
+		/* capacity is how many spans may be recorded but not yet resolved.
+			Pipeline statistics are collected when the device supports them
+			(Context::features.pipeline_statistics_query) unless disabled.*/
+		[[nodiscard]] explicit Profiler(
+			const Context& context_,
+			const uint32_t capacity_ = default_capacity,
+			const bool pipeline_statistics = true );
+
+		/* false when queue_family_index can't write timestamps, or can't
+			reset queries without host_query_reset.*/
+		[[nodiscard]] bool supports( const uint32_t queue_family_index ) const;
+
+		/* Starts a span in buffer, recorded for queue_family_index
+			(Context::queue_family_index by default), and returns its id for
+			end(). compute enables the invocation count; leave it off for
+			work recorded on transfer-only queues. Throws
+			std::invalid_argument when the family isn't supported() and
+			std::length_error when every slot is waiting for resolve().*/
+		[[nodiscard]] uint32_t begin(
+			const vk::raii::CommandBuffer& buffer,
+			std::string name,
+			const bool compute = true,
+			const std::optional<uint32_t> queue_family_index = std::nullopt );
+
+		void end( const vk::raii::CommandBuffer& buffer, const uint32_t span );
+
+		// frees a span whose command buffer will never be submitted
+		void discard( const uint32_t span );
+
+		// record_dispatch inside a span named name
+		void record_dispatch(
+			const vk::raii::CommandBuffer& buffer,
+			std::string name,
+			const Pipeline& pipeline,
+			const uint32_t groupCountX,
+			const uint32_t groupCountY = 1,
+			const uint32_t groupCountZ = 1,
+			const std::span<const std::byte> push_constants = {} );
+
+		// collects every span whose work finished; returns how many
+		std::size_t resolve();
+
+		void add_cpu_span( std::string name, const clock::time_point start, const clock::time_point stop );
+
+		// a span per lap and one for the whole run of a stopwatch::Stopwatch
+		template <typename Stopwatch>
+		void add_stopwatch( const Stopwatch& watch )
+		{
+			const std::string name { watch.getName() };
+			auto previous { watch.getStart() };
+			std::size_t lap { 1 };
+			for( const auto& time : watch.getLaps() )
+			{
+				add_cpu_span( name + " lap " + std::to_string( lap++ ), previous, time );
+				previous = time;
+			}
+
+			if( watch.getStop() > watch.getStart() )
+				add_cpu_span( name, watch.getStart(), watch.getStop() );
+		}
+
+		// per span name min/median/p99 over every resolved run
+		[[nodiscard]] std::map<std::string, KernelStatistics> kernel_statistics() const;
+
+		void print_statistics() const;
+
+		// chrome://tracing / Perfetto JSON with a CPU and a GPU track
+		void write_chrome_trace( const std::filesystem::path& path ) const;
+	};
+
+}
+
+#endif /* FGL_VULKAN_PROFILER_HPP_INCLUDED */
@@ -0,0 +1,181 @@
+#ifndef FGL_VULKAN_RECORDING_HPP_INCLUDED
+#define FGL_VULKAN_RECORDING_HPP_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "async.hpp"
+#include "commandqueue.hpp"
+#include "context.hpp"
+#include "internal/mpsc_queue.hpp"
+#include "internal/thread_pool.hpp"
+
+namespace fgl::vulkan
+{
+
+	/* A recorded secondary command buffer on its way to
+		ParallelRecorder::submit(). Goes back to the pool it came from when
+		destroyed, from whichever thread that happens on.*/
+	class SecondaryCommands
+	{
+		CommandBufferPool* pool;
+		vk::raii::CommandBuffer command_buffer;
+
+	public:
+		SecondaryCommands() = delete;
+		SecondaryCommands( const SecondaryCommands& ) = delete;
+		SecondaryCommands& operator=( const SecondaryCommands& ) = delete;
+
+		[[nodiscard]] explicit SecondaryCommands( CommandBufferPool& pool_, vk::raii::CommandBuffer&& buffer_ );
+
+		SecondaryCommands( SecondaryCommands&& other ) noexcept;
+
+		~SecondaryCommands();
+
+		[[nodiscard]] const vk::raii::CommandBuffer& buffer() const noexcept { return command_buffer; }
+	};
+
+	/* Command recording from many host threads at once, with a single
+		thread submitting.
+
+		A thread leases one of the recorder's command pools (lease() only
+		locks to take a pool off the idle list, and the Lease puts it back)
+		and records secondary command buffers from it with no further
+		synchronization. submit() pushes them onto a lock-free queue; the
+		submitter thread stitches each submission's secondaries, in order,
+		into a primary buffer and hands everything queued since its last
+		round to one vkQueueSubmit. Buffers go back to their pools from the
+		completion thread without locking.
+
+		Everything runs on one queue of Context::queue_family_index, so
+		submissions are ordered on the device the way they were queued, but
+		the recorder doesn't put barriers between them. Don't hand that
+		queue to a QueueScheduler, AsyncQueue or TransferEngine used at the
+		same time. Leases and SecondaryCommands must not outlive the
+		recorder.*/
+	class ParallelRecorder
+	{
+	public:
+		using Recorder = std::function<void( const vk::raii::CommandBuffer& )>;
+
+		// exclusive use of one of the recorder's pools until destroyed
+		class Lease
+		{
+			ParallelRecorder* recorder;
+			CommandBufferPool* pool;
+
+		public:
+			Lease() = delete;
+			Lease( const Lease& ) = delete;
+			Lease& operator=( const Lease& ) = delete;
+
+			[[nodiscard]] explicit Lease( ParallelRecorder& recorder_ );
+
+			Lease( Lease&& other ) noexcept;
+
+			~Lease();
+
+			// begins a secondary buffer (eOneTimeSubmit), runs record on it and ends it
+			[[nodiscard]] SecondaryCommands record( const Recorder& record ) const;
+		};
+
+	private:
+		struct Submission
+		{
+			std::vector<SecondaryCommands> commands;
+			std::function<void()> on_complete;
+			std::promise<void> promise;
+		};
+
+		const Context& context;
+
+		std::mutex pools_mutex {};
+		std::vector<std::unique_ptr<CommandBufferPool>> pools {};
+		std::vector<CommandBufferPool*> idle_pools {};
+
+		CommandBufferPool primaries; // the submitter thread's
+		internal::MpscQueue<Submission> submissions {};
+
+		std::atomic<uint64_t> signals { 0 }; // bumped to wake the submitter
+		std::atomic<uint64_t> queued { 0 };
+		std::atomic<uint64_t> completed { 0 };
+		std::atomic<uint64_t> queue_submits { 0 };
+		std::atomic<bool> stopping { false };
+
+		// declared after everything its completion callbacks give buffers back to
+		AsyncQueue queue;
+		internal::ThreadPool workers;
+		std::thread submitter;
+
+		[[nodiscard]] CommandBufferPool& take_pool();
+		void return_pool( CommandBufferPool& pool );
+
+		void submit_loop();
+		void flush( std::vector<Submission>& batch );
+		void complete(
+			std::vector<Submission>& finished,
+			std::vector<vk::raii::CommandBuffer>& used_primaries,
+			const std::exception_ptr& error );
+
+	public:
+		// most submissions the submitter stitches into one vkQueueSubmit
+		static constexpr std::size_t max_batch { 64 };
+
+		ParallelRecorder() = delete;
+		ParallelRecorder( const ParallelRecorder& ) = delete;
+
+		/* thread_count sizes the pool record_parallel() uses (0 for
+			std::thread::hardware_concurrency()).*/
+		[[nodiscard]] explicit ParallelRecorder(
+			const Context& context_,
+			const std::size_t thread_count = 0,
+			const uint32_t queue_index = 0 );
+
+		// submits whatever is still queued and waits for all of it
+		~ParallelRecorder();
+
+		[[nodiscard]] Lease lease() { return Lease( *this ); }
+
+		/* Queues commands to run in order in one primary buffer, without
+			locking; any thread. on_complete runs on the completion thread
+			before the future is fulfilled, with any exception it throws
+			ending up in the future.*/
+		[[nodiscard]] std::future<void> submit(
+			std::vector<SecondaryCommands>&& commands,
+			std::function<void()> on_complete = {} );
+
+		/* Records every job into its own secondary buffer, spread over the
+			recording threads in contiguous runs (one lease each), and
+			submits them in job order as one submission. Rethrows the first
+			exception from a job, after every job has finished. Don't call it
+			from a job or a completion callback.*/
+		[[nodiscard]] std::future<void> record_parallel(
+			const std::span<const Recorder> jobs,
+			std::function<void()> on_complete = {} );
+
+		// waits for everything queued before the call
+		void wait_idle();
+
+		// one per recording thread, plus one per lease ever held beyond those at once
+		[[nodiscard]] std::size_t pool_count();
+
+		[[nodiscard]] std::size_t recording_threads() const noexcept { return workers.size(); }
+
+		// vkQueueSubmit calls so far, each carrying up to max_batch submissions
+		[[nodiscard]] uint64_t queue_submissions() const noexcept { return queue_submits.load( std::memory_order_relaxed ); }
+	};
+
+}
+
+#endif /* FGL_VULKAN_RECORDING_HPP_INCLUDED */
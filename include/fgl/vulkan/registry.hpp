@@ -0,0 +1,124 @@
+#ifndef FGL_VULKAN_REGISTRY_HPP_INCLUDED
+#define FGL_VULKAN_REGISTRY_HPP_INCLUDED
+
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "context.hpp"
+#include "memory.hpp"
+#include "pipeline.hpp"
+#include "./internal/thread_pool.hpp"
+
+namespace fgl::vulkan
+{
+
+	/* Named set of pipelines that are compiled off the calling thread.
+
+		add() only records how to build a pipeline. compile_all() builds
+		every one of them in parallel on the registry's thread pool,
+		warm_up() queues a list in the background without waiting, and
+		get() compiles on first use (or waits for a warm-up already
+		running). Each pipeline is built exactly once whoever gets to it
+		first, and the time its construction took is kept for reporting.
+
+		All pipelines go through Context::pipeline_cache, which drivers
+		synchronize internally, so parallel creation is safe.*/
+	class PipelineRegistry
+	{
+		struct Entry
+		{
+			const std::function<std::unique_ptr<Pipeline>()> build;
+			std::once_flag once {};
+			std::unique_ptr<Pipeline> pipeline {};
+			std::chrono::nanoseconds compile_time { 0 };
+
+			[[nodiscard]] explicit Entry( std::function<std::unique_ptr<Pipeline>()>&& build_ );
+		};
+
+		mutable std::mutex mutex {};
+		std::map<std::string, std::unique_ptr<Entry>, std::less<>> entries {};
+		internal::ThreadPool pool;
+
+		void add( std::string&& name, std::function<std::unique_ptr<Pipeline>()>&& build );
+
+		[[nodiscard]] Entry& find( const std::string_view name ) const;
+
+		// builds the entry unless it was already built; blocks while another thread builds it
+		void compile( Entry& entry );
+
+		[[nodiscard]] std::vector<Entry*> lookup( const std::span<const std::string> names ) const;
+
+	public:
+		struct CompileTime
+		{
+			std::string name;
+			std::chrono::nanoseconds duration;
+		};
+
+		PipelineRegistry( const PipelineRegistry& ) = delete;
+
+		// 0 threads uses std::thread::hardware_concurrency()
+		[[nodiscard]] explicit PipelineRegistry( const std::size_t thread_count = 0 );
+
+		// finishes any warm-up still queued
+		~PipelineRegistry() = default;
+
+		/* Registers a pipeline under name. Nothing is compiled yet, so
+			context and buffers must outlive the registry.*/
+		template <std::ranges::forward_range T>
+			requires std::same_as<std::ranges::range_value_t<T>, fgl::vulkan::Buffer>
+		void add(
+			std::string name,
+			const Context& context,
+			std::filesystem::path shaderpath,
+			std::string shader_init_name,
+			const T& buffers,
+			const uint32_t push_constant_size = 0,
+			Specialization specialization = {} )
+		{
+			add(
+				std::move( name ),
+				[&context, shaderpath = std::move( shaderpath ), shader_init_name = std::move( shader_init_name ), &buffers, push_constant_size, specialization = std::move( specialization )]
+				{
+					return std::make_unique<Pipeline>( context, shaderpath, shader_init_name, buffers, push_constant_size, specialization );
+				}
+			);
+		}
+
+		[[nodiscard]] bool contains( const std::string_view name ) const;
+
+		// compiles every registered pipeline in parallel and waits, rethrowing the first failure
+		void compile_all();
+
+		// compiles names in parallel and waits
+		void compile( const std::span<const std::string> names );
+
+		/* Queues names for background compilation in the given order and
+			returns immediately. Failures are reported again by get().*/
+		void warm_up( const std::span<const std::string> names );
+
+		// compiles on first use; throws std::out_of_range for unknown names
+		[[nodiscard]] const Pipeline& get( const std::string_view name );
+
+		// pipelines built so far, slowest first
+		[[nodiscard]] std::vector<CompileTime> compile_times() const;
+
+		void print_compile_times() const;
+	};
+
+}
+
+#endif /* FGL_VULKAN_REGISTRY_HPP_INCLUDED */
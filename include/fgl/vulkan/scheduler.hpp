@@ -0,0 +1,118 @@
+#ifndef FGL_VULKAN_SCHEDULER_HPP_INCLUDED
+#define FGL_VULKAN_SCHEDULER_HPP_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "async.hpp"
+#include "commandqueue.hpp"
+#include "context.hpp"
+
+namespace fgl::vulkan
+{
+
+	/* Spreads independent jobs over every queue in Context::queue_families
+		so devices with several compute engines (async compute families,
+		multiple queues per family) run them concurrently.
+
+		Each queue is a lane with its own AsyncQueue and command buffer pool;
+		a job is recorded into a buffer from the chosen lane's family and the
+		buffer is recycled when the job completes. Jobs on different lanes are
+		not ordered against each other, so anything with a dependency has to
+		go into the same job (see DispatchRecorder).
+
+		The scheduler drives all the queues it was given, so don't hand the
+		same queue to an AsyncQueue or TransferEngine used at the same time.*/
+	class QueueScheduler
+	{
+	public:
+		enum class Policy
+		{
+			eRoundRobin,
+			eLeastLoaded // fewest jobs in flight, round-robin among ties
+		};
+
+		using Recorder = std::function<void( const vk::raii::CommandBuffer& )>;
+
+	private:
+		struct Lane
+		{
+			const uint32_t family_index;
+			const uint32_t queue_index;
+			const vk::QueueFlags flags;
+
+			// recording also needs the pool externally synchronized
+			std::mutex pool_mutex {};
+			CommandBufferPool pool;
+
+			std::atomic<std::size_t> in_flight { 0 };
+			std::atomic<std::size_t> submitted { 0 };
+
+			// declared last so it drains (and recycles into pool) before anything else goes
+			AsyncQueue queue;
+
+			[[nodiscard]] explicit Lane(
+				const Context& context,
+				const QueueFamily& family,
+				const uint32_t queue_index_ );
+		};
+
+		std::vector<std::unique_ptr<Lane>> lanes {};
+		std::atomic<std::size_t> cursor { 0 };
+
+		[[nodiscard]] Lane& select( const vk::QueueFlags required );
+
+	public:
+		const Policy policy;
+
+		QueueScheduler() = delete;
+		QueueScheduler( const QueueScheduler& ) = delete;
+
+		/* One lane per queue of every family that has the required flags.
+			max_queues_per_family of 0 uses every queue the family was created with.*/
+		[[nodiscard]] explicit QueueScheduler(
+			const Context& context,
+			const Policy policy_ = Policy::eLeastLoaded,
+			const vk::QueueFlags required = vk::QueueFlagBits::eCompute,
+			const uint32_t max_queues_per_family = 0 );
+
+		/* Picks a lane that has the required flags, records the job between
+			begin/end (eOneTimeSubmit) and submits it. The recorder runs on
+			the calling thread while holding the lane's pool, so keep it short;
+			on_complete runs on the lane's completion thread.*/
+		[[nodiscard]] std::future<void> submit(
+			const Recorder& record,
+			std::function<void()> on_complete = {},
+			const vk::QueueFlags required = vk::QueueFlagBits::eCompute );
+
+		// a single dispatch of pipeline
+		[[nodiscard]] std::future<void> dispatch(
+			const Pipeline& pipeline,
+			const uint32_t groupCountX,
+			const uint32_t groupCountY = 1,
+			const uint32_t groupCountZ = 1,
+			const std::span<const std::byte> push_constants = {} );
+
+		// waits until every lane is idle
+		void wait_idle();
+
+		[[nodiscard]] std::size_t lane_count() const noexcept { return lanes.size(); }
+
+		// jobs submitted to each lane so far, in lane order
+		[[nodiscard]] std::vector<std::size_t> submissions() const;
+
+		void print_lanes() const;
+	};
+
+}
+
+#endif /* FGL_VULKAN_SCHEDULER_HPP_INCLUDED */
@@ -0,0 +1,134 @@
+#ifndef FGL_VULKAN_STREAM_HPP_INCLUDED
+#define FGL_VULKAN_STREAM_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <iosfwd>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "context.hpp"
+#include "mapped_file.hpp"
+#include "memory.hpp"
+#include "scheduler.hpp"
+
+namespace fgl::vulkan
+{
+
+	/* Out-of-core execution: a grid split into tiles along one axis, each
+		computed into one of a ring of device local output buffers and read
+		back while the following tiles compute, so the whole output never
+		has to fit in device memory (or maxStorageBufferRange).
+
+		A tile's dispatch, the copy of its output into the slot's host
+		visible readback buffer and the barrier making it visible to the
+		host go into one submission. The host only waits for a slot when
+		it comes round again, and hands the tile to the sink then, in tile
+		order; with depth slots, depth - 1 tiles compute while one drains.
+
+		Memory is bounded by depth * ( device + readback ) tile buffers.
+		Not thread safe.*/
+	class TileStream
+	{
+	public:
+		// units [first, first + count) of the streamed axis, bytes of output
+		struct Tile
+		{
+			uint64_t index;
+			uint64_t first;
+			uint32_t count;
+			vk::DeviceSize bytes;
+		};
+
+		// records the tile's dispatches writing output from offset 0
+		using Recorder = std::function<void( const vk::raii::CommandBuffer&, const Tile&, const Buffer& output )>;
+
+		// called in tile order with the tile's output; data is only valid during the call
+		using Sink = std::function<void( const Tile&, std::span<const std::byte> data )>;
+
+		struct Statistics
+		{
+			uint64_t tiles { 0 };
+			uint64_t bytes { 0 };
+			double seconds { 0.0 };
+			double wait_seconds { 0.0 }; // host blocked on a slot that hadn't completed
+			double sink_seconds { 0.0 }; // host inside the sink
+		};
+
+	private:
+		struct Slot
+		{
+			Buffer output; // device local
+			Buffer readback; // host visible
+			std::optional<Tile> tile {};
+			std::future<void> done {};
+
+			[[nodiscard]] explicit Slot( const Context& context, const vk::DeviceSize bytes );
+		};
+
+		QueueScheduler& scheduler;
+		std::vector<Slot> slots {};
+
+		// waits for the slot's tile and hands it to the sink
+		void drain( Slot& slot, const Sink& sink, Statistics& statistics );
+
+	public:
+		const uint32_t units_per_tile;
+		const vk::DeviceSize bytes_per_unit;
+
+		static constexpr std::size_t default_depth { 3 };
+
+		TileStream() = delete;
+		TileStream( const TileStream& ) = delete;
+
+		[[nodiscard]] explicit TileStream(
+			const Context& context,
+			QueueScheduler& scheduler_,
+			const uint32_t units_per_tile_,
+			const vk::DeviceSize bytes_per_unit_,
+			const std::size_t depth = default_depth );
+
+		// waits for tiles still in flight (their sink calls are dropped)
+		~TileStream();
+
+		/* Streams units [0, extent) through record and sink. Rethrows the
+			first exception from either once nothing is in flight.*/
+		Statistics run(
+			const uint64_t extent,
+			const Recorder& record,
+			const Sink& sink );
+
+		[[nodiscard]] std::size_t depth() const noexcept { return slots.size(); }
+	};
+
+	/* The most units per tile that keep depth tiles (output and readback)
+		within budget_bytes and one tile within maxStorageBufferRange,
+		rounded down to a multiple of granularity (at least granularity).*/
+	[[nodiscard]] uint32_t fit_tile_units(
+		const Context& context,
+		const vk::DeviceSize bytes_per_unit,
+		const vk::DeviceSize budget_bytes,
+		const uint32_t granularity = 1,
+		const std::size_t depth = TileStream::default_depth );
+
+	// appends every tile to stream, which has to outlive the sink
+	[[nodiscard]] TileStream::Sink ostream_sink( std::ostream& stream );
+
+	// truncates path and appends every tile to it; throws if it can't be opened
+	[[nodiscard]] TileStream::Sink file_sink( const std::filesystem::path& path );
+
+	/* Copies every tile to its place in file, offset bytes plus tile.first
+		units in, so tiles go straight into the page cache with no write
+		calls. file has to be mapped eReadWrite, large enough for the whole
+		output and outlive the sink.*/
+	[[nodiscard]] TileStream::Sink mapped_file_sink( const MappedFile& file, const std::size_t offset = 0 );
+
+}
+
+#endif /* FGL_VULKAN_STREAM_HPP_INCLUDED */
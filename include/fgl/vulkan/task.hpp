@@ -0,0 +1,245 @@
+#ifndef FGL_VULKAN_TASK_HPP_INCLUDED
+#define FGL_VULKAN_TASK_HPP_INCLUDED
+
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "async.hpp"
+#include "commandqueue.hpp"
+#include "context.hpp"
+
+namespace fgl::vulkan
+{
+	template <typename T>
+	class Task;
+
+	namespace internal
+	{
+		// resumes whoever co_awaited the task, or returns to the event loop
+		struct FinalAwaiter
+		{
+			[[nodiscard]] bool await_ready() const noexcept { return false; }
+
+			template <typename Promise>
+			[[nodiscard]] std::coroutine_handle<> await_suspend( std::coroutine_handle<Promise> handle ) const noexcept
+			{
+				if( const auto continuation { handle.promise().continuation } )
+					return continuation;
+				return std::noop_coroutine();
+			}
+
+			void await_resume() const noexcept {}
+		};
+
+		struct PromiseBase
+		{
+			std::coroutine_handle<> continuation {};
+			std::exception_ptr error {};
+
+			[[nodiscard]] std::suspend_always initial_suspend() const noexcept { return {}; }
+			[[nodiscard]] FinalAwaiter final_suspend() const noexcept { return {}; }
+
+			void unhandled_exception() noexcept { error = std::current_exception(); }
+		};
+
+		template <typename T>
+		struct TaskPromise : PromiseBase
+		{
+			std::optional<T> value {};
+
+			[[nodiscard]] Task<T> get_return_object() noexcept;
+
+			template <typename U>
+			void return_value( U&& result ) { value.emplace( std::forward<U>( result ) ); }
+
+			[[nodiscard]] T result()
+			{
+				if( error )
+					std::rethrow_exception( error );
+				return std::move( *value );
+			}
+		};
+
+		template <>
+		struct TaskPromise<void> : PromiseBase
+		{
+			[[nodiscard]] Task<void> get_return_object() noexcept;
+
+			void return_void() const noexcept {}
+
+			void result() const
+			{
+				if( error )
+					std::rethrow_exception( error );
+			}
+		};
+	} // namespace internal
+
+	/* Lazily started coroutine. co_await-ing a Task starts it and resumes
+		the awaiting coroutine (by symmetric transfer) when it finishes.
+		Top level tasks are handed to an EventLoop with spawn().*/
+	template <typename T = void>
+	class [[nodiscard]] Task
+	{
+	public:
+		using promise_type = internal::TaskPromise<T>;
+
+	private:
+		friend class EventLoop;
+		std::coroutine_handle<promise_type> handle {};
+
+	public:
+		[[nodiscard]] explicit Task( std::coroutine_handle<promise_type> handle_ ) noexcept
+			:
+			handle( handle_ )
+		{}
+
+		Task( const Task& ) = delete;
+		Task& operator=( const Task& ) = delete;
+
+		[[nodiscard]] Task( Task&& other ) noexcept
+			:
+			handle( std::exchange( other.handle, {} ) )
+		{}
+
+		Task& operator=( Task&& other ) noexcept
+		{
+			if( this != &other )
+			{
+				if( handle )
+					handle.destroy();
+				handle = std::exchange( other.handle, {} );
+			}
+			return *this;
+		}
+
+		~Task()
+		{
+			if( handle )
+				handle.destroy();
+		}
+
+		[[nodiscard]] bool done() const noexcept { return !handle || handle.done(); }
+
+		[[nodiscard]] bool await_ready() const noexcept { return done(); }
+
+		[[nodiscard]] std::coroutine_handle<> await_suspend( std::coroutine_handle<> awaiting ) noexcept
+		{
+			handle.promise().continuation = awaiting;
+			return handle;
+		}
+
+		T await_resume() { return handle.promise().result(); }
+	};
+
+	namespace internal
+	{
+		template <typename T>
+		Task<T> TaskPromise<T>::get_return_object() noexcept
+		{
+			return Task<T>( std::coroutine_handle<TaskPromise<T>>::from_promise( *this ) );
+		}
+
+		inline Task<void> TaskPromise<void>::get_return_object() noexcept
+		{
+			return Task<void>( std::coroutine_handle<TaskPromise<void>>::from_promise( *this ) );
+		}
+	} // namespace internal
+
+	/* Single threaded driver for GPU coroutines.
+		Work is submitted as soon as submit()/dispatch() is called, so the
+		host can keep recording before it co_awaits the result. run()
+		resumes ready coroutines and, when every task is waiting on the
+		GPU, blocks in one vkWaitForFences over all outstanding fences.*/
+	class EventLoop
+	{
+		struct Completion
+		{
+			bool done { false };
+			std::vector<std::coroutine_handle<>> waiters {};
+		};
+
+		struct InFlight
+		{
+			vk::raii::Fence fence;
+			std::shared_ptr<Completion> completion;
+		};
+
+		const Context& context;
+		const vk::raii::Queue queue;
+		FencePool fences;
+
+		std::vector<InFlight> in_flight {};
+		std::deque<std::coroutine_handle<>> ready {};
+		std::vector<Task<void>> tasks {};
+
+		// marks every signaled fence complete; waits up to timeout for at least one
+		void poll( const uint64_t timeout );
+		void resume_ready();
+
+	public:
+		/* Awaitable completion of one submission. Copies share it, and any
+			number of coroutines may co_await it: every one of them is resumed,
+			in the order they suspended, once the work completed.*/
+		class [[nodiscard]] Operation
+		{
+			std::shared_ptr<Completion> completion;
+
+		public:
+			[[nodiscard]] explicit Operation( std::shared_ptr<Completion> completion_ ) noexcept
+				:
+				completion( std::move( completion_ ) )
+			{}
+
+			[[nodiscard]] bool await_ready() const noexcept { return completion->done; }
+			void await_suspend( std::coroutine_handle<> handle ) const { completion->waiters.emplace_back( handle ); }
+			void await_resume() const noexcept {}
+		};
+
+		EventLoop() = delete;
+		EventLoop( const EventLoop& ) = delete;
+
+		[[nodiscard]] explicit EventLoop(
+			const Context& context_,
+			const uint32_t queue_family_index,
+			const uint32_t queue_index = 0 );
+
+		// waits for work still on the GPU
+		~EventLoop();
+
+		Operation submit( const std::span<const vk::CommandBuffer> buffers );
+		Operation submit( const vk::raii::CommandBuffer& buffer );
+
+		// submits a recorded CommandQueue
+		Operation dispatch( const CommandQueue& command );
+
+		// re-records command with the given dispatch and submits it
+		Operation dispatch(
+			const CommandQueue& command,
+			const Pipeline& pipeline,
+			const uint32_t groupCountX,
+			const uint32_t groupCountY = 1,
+			const uint32_t groupCountZ = 1,
+			const std::span<const std::byte> push_constants = {} );
+
+		// takes ownership of a top level task; it starts on the next run()
+		void spawn( Task<void>&& task );
+
+		// runs until every spawned task finished, rethrowing the first failure
+		void run();
+
+		[[nodiscard]] std::size_t operations_in_flight() const noexcept { return in_flight.size(); }
+	};
+
+}
+
+#endif /* FGL_VULKAN_TASK_HPP_INCLUDED */
@@ -0,0 +1,152 @@
+#ifndef FGL_VULKAN_TRANSFER_HPP_INCLUDED
+#define FGL_VULKAN_TRANSFER_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "async.hpp"
+#include "context.hpp"
+#include "memory.hpp"
+
+namespace fgl::vulkan
+{
+
+	/* Streams data between the host and device-local Buffers through a
+		ring of host-visible staging buffers with vkCmdCopyBuffer.
+
+		Copies are batched into the current slot until it is full or
+		flush() is called; the host can fill the next slot while the
+		previous one executes. Work is submitted on the transfer-only
+		queue family when the device has one, so buffers that are also
+		used by compute should be created with vk::SharingMode::eConcurrent.
+
+		Downloads land in the host span once their slot completes, which
+		is guaranteed after wait().
+
+		The engine's queue knows nothing of work on other queues. A
+		download() of what a shader wrote, or an upload() into a buffer a
+		shader still reads, has to wait for that work: either on the host
+		(its fence or future) before recording the copy, or on the device
+		through wait_for() with a timeline semaphore. Likewise compute that
+		reads uploaded data either waits for wait() on the host or for a
+		TimelinePoint flush() signals.*/
+	class Profiler;
+
+	class TransferEngine
+	{
+		struct PendingDownload
+		{
+			std::span<std::byte> destination;
+			vk::DeviceSize staging_offset;
+		};
+
+		struct Slot
+		{
+			Buffer staging;
+			vk::raii::CommandBuffer command_buffer;
+			vk::raii::Fence fence;
+			vk::DeviceSize used { 0 };
+			bool recording { false };
+			bool in_flight { false };
+			bool has_downloads { false };
+			bool downloading { false }; // the latest copy recorded into the slot was a download
+			std::vector<PendingDownload> downloads {};
+			std::optional<uint32_t> span {}; // profiler span around the slot's copies
+
+			[[nodiscard]] explicit Slot(
+				const Context& context,
+				const vk::DeviceSize staging_size,
+				vk::raii::CommandBuffer&& command_buffer_ );
+		};
+
+		const Context& context;
+		const vk::raii::Queue queue;
+		const vk::raii::CommandPool pool;
+		std::vector<Slot> slots {};
+		std::size_t current { 0 };
+		Profiler* profiler { nullptr };
+		std::vector<TimelinePoint> waits {}; // until the next flush()
+
+		// waits for the slot, finishes its downloads and begins recording
+		void prepare( Slot& slot );
+		void complete( Slot& slot );
+		void submit( Slot& slot, const std::optional<TimelinePoint>& signal = std::nullopt );
+
+		// buffer and fence may be null, for a submission that only waits and signals
+		void queue_submit( const vk::CommandBuffer buffer, const vk::Fence fence, const std::optional<TimelinePoint>& signal );
+		void check_timeline() const;
+
+		// current slot with room for at least one byte, rotating the ring if needed
+		[[nodiscard]] Slot& acquire();
+
+	public:
+		const vk::DeviceSize staging_size;
+
+		static constexpr vk::DeviceSize default_staging_size { 16ull * 1024 * 1024 };
+		static constexpr std::size_t default_ring_depth { 3 };
+
+		TransferEngine() = delete;
+		TransferEngine( const TransferEngine& ) = delete;
+
+		[[nodiscard]] explicit TransferEngine(
+			const Context& context_,
+			const vk::DeviceSize staging_size_ = default_staging_size,
+			const std::size_t ring_depth = default_ring_depth );
+
+		~TransferEngine();
+
+		void upload(
+			const Buffer& destination,
+			const std::span<const std::byte> data,
+			const vk::DeviceSize destination_offset = 0 );
+
+		void download(
+			const Buffer& source,
+			const std::span<std::byte> data,
+			const vk::DeviceSize source_offset = 0 );
+
+		template <typename T>
+		void upload(
+			const Buffer& destination,
+			const std::span<T> data,
+			const vk::DeviceSize destination_offset = 0 )
+		{
+			upload( destination, std::as_bytes( data ), destination_offset );
+		}
+
+		template <typename T>
+		void download(
+			const Buffer& source,
+			const std::span<T> data,
+			const vk::DeviceSize source_offset = 0 )
+		{
+			download( source, std::as_writable_bytes( data ), source_offset );
+		}
+
+		/* Every submission until the next flush() waits for point before
+			its copies, so they can follow work on other queues (e.g. an
+			AsyncQueue's submitted_point()) without blocking the host.
+			Throws std::logic_error without Context::features.timeline_semaphore.*/
+		void wait_for( const TimelinePoint& point );
+
+		/* Submits everything recorded so far, signaling signal (if any)
+			once it and every earlier copy completed; the same
+			std::logic_error as wait_for().*/
+		void flush( const std::optional<TimelinePoint>& signal = std::nullopt );
+
+		// flushes and blocks until every slot has completed
+		void wait();
+
+		/* Times every submitted slot as a "transfer" span from now on (nullptr
+			stops). Ignored when the transfer family can't write timestamps.*/
+		void set_profiler( Profiler* profiler_ );
+	};
+
+}
+
+#endif /* FGL_VULKAN_TRANSFER_HPP_INCLUDED */
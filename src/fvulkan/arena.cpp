@@ -0,0 +1,536 @@
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include <fgl/vulkan/arena.hpp>
+
+namespace fgl::vulkan
+{
+	namespace internal
+	{
+		constexpr vk::DeviceSize align_up(
+			const vk::DeviceSize value,
+			const vk::DeviceSize alignment ) noexcept
+		{
+			return alignment > 1 ? ( value + alignment - 1 ) / alignment * alignment : value;
+		}
+
+		constexpr vk::DeviceSize align_down(
+			const vk::DeviceSize value,
+			const vk::DeviceSize alignment ) noexcept
+		{
+			return alignment > 1 ? value / alignment * alignment : value;
+		}
+	} // namespace internal
+
+	/// BLOCK
+
+	MemoryBlock::MemoryBlock(
+		vk::raii::DeviceMemory&& memory_,
+		const vk::DeviceSize size_,
+		const uint32_t memory_type_index_,
+		const vk::MemoryPropertyFlags property_flags_,
+		const bool linear_,
+		const bool dedicated_ )
+		:
+		memory( std::move( memory_ ) ),
+		size( size_ ),
+		memory_type_index( memory_type_index_ ),
+		property_flags( property_flags_ ),
+		linear( linear_ ),
+		dedicated( dedicated_ )
+	{
+		constexpr vk::DeviceSize start { 0 };
+		free_ranges.emplace( start, size );
+
+		if( property_flags & vk::MemoryPropertyFlagBits::eHostVisible )
+			mapped = memory.mapMemory( start, VK_WHOLE_SIZE );
+	}
+
+	vk::DeviceSize MemoryBlock::allocate(
+		const vk::DeviceSize bytesize,
+		const vk::DeviceSize alignment )
+	{
+		// first-fit; on a fresh block the only range is the tail, so this is a pointer bump
+		for( auto it { free_ranges.begin() }; it != free_ranges.end(); ++it )
+		{
+			const auto [range_offset, range_size] { *it };
+			const vk::DeviceSize aligned { internal::align_up( range_offset, alignment ) };
+			const vk::DeviceSize padding { aligned - range_offset };
+
+			if( padding + bytesize > range_size )
+				continue;
+
+			free_ranges.erase( it );
+
+			if( padding > 0 )
+				free_ranges.emplace( range_offset, padding );
+
+			if( const vk::DeviceSize tail { range_size - padding - bytesize }; tail > 0 )
+				free_ranges.emplace( aligned + bytesize, tail );
+
+			used += bytesize;
+			++allocation_count;
+			return aligned;
+		}
+		return size;
+	}
+
+	void MemoryBlock::free( const vk::DeviceSize offset, const vk::DeviceSize bytesize )
+	{
+		auto it { free_ranges.emplace( offset, bytesize ).first };
+
+		// coalesce with the following range
+		if( const auto next { std::next( it ) };
+			next != free_ranges.end() && it->first + it->second == next->first )
+		{
+			it->second += next->second;
+			free_ranges.erase( next );
+		}
+
+		// coalesce with the preceding range
+		if( it != free_ranges.begin() )
+		{
+			if( const auto prev { std::prev( it ) }; prev->first + prev->second == it->first )
+			{
+				prev->second += it->second;
+				free_ranges.erase( it );
+			}
+		}
+
+		used -= bytesize;
+		--allocation_count;
+	}
+
+	/// ALLOCATION
+
+	Allocation::Allocation(
+		MemoryArena& arena_,
+		MemoryBlock& block_,
+		const vk::DeviceSize offset_,
+		const vk::DeviceSize size_ ) noexcept
+		:
+		arena( &arena_ ),
+		block( &block_ ),
+		offset( offset_ ),
+		size( size_ )
+	{}
+
+	Allocation::Allocation( Allocation&& other ) noexcept
+		:
+		arena( std::exchange( other.arena, nullptr ) ),
+		block( std::exchange( other.block, nullptr ) ),
+		offset( std::exchange( other.offset, 0 ) ),
+		size( std::exchange( other.size, 0 ) )
+	{}
+
+	Allocation& Allocation::operator=( Allocation&& other ) noexcept
+	{
+		if( this != &other )
+		{
+			if( block != nullptr )
+				arena->free( *block, offset, size );
+
+			arena = std::exchange( other.arena, nullptr );
+			block = std::exchange( other.block, nullptr );
+			offset = std::exchange( other.offset, 0 );
+			size = std::exchange( other.size, 0 );
+		}
+		return *this;
+	}
+
+	Allocation::~Allocation()
+	{
+		if( block != nullptr )
+			arena->free( *block, offset, size );
+	}
+
+	vk::DeviceMemory Allocation::memory() const
+	{
+		return *block->memory;
+	}
+
+	uint32_t Allocation::memory_type_index() const
+	{
+		return block->memory_type_index;
+	}
+
+	bool Allocation::host_visible() const
+	{
+		return static_cast< bool >( block->property_flags & vk::MemoryPropertyFlagBits::eHostVisible );
+	}
+
+	bool Allocation::host_coherent() const
+	{
+		return static_cast< bool >( block->property_flags & vk::MemoryPropertyFlagBits::eHostCoherent );
+	}
+
+	void* Allocation::mapped() const
+	{
+		if( block->mapped == nullptr )
+		{
+			throw std::runtime_error( "Attempting to map memory that is not host visible." );
+		}
+		return static_cast< std::byte* >( block->mapped ) + offset;
+	}
+
+	void Allocation::flush(
+		const vk::DeviceSize range_offset,
+		const vk::DeviceSize range_size ) const
+	{
+		if( host_coherent() )
+			return;
+
+		const vk::DeviceSize bytesize { range_size == VK_WHOLE_SIZE ? size - range_offset : range_size };
+		arena->device.flushMappedMemoryRanges( arena->atom_range( *block, offset + range_offset, bytesize ) );
+	}
+
+	void Allocation::invalidate(
+		const vk::DeviceSize range_offset,
+		const vk::DeviceSize range_size ) const
+	{
+		if( host_coherent() )
+			return;
+
+		const vk::DeviceSize bytesize { range_size == VK_WHOLE_SIZE ? size - range_offset : range_size };
+		arena->device.invalidateMappedMemoryRanges( arena->atom_range( *block, offset + range_offset, bytesize ) );
+	}
+
+	/// ARENA
+
+	MemoryArena::MemoryArena(
+		const vk::raii::Device& device_,
+		const vk::raii::PhysicalDevice& physical_device_,
+		const bool has_memory_budget_,
+		const vk::DeviceSize block_size_ )
+		:
+		device( device_ ),
+		physical_device( physical_device_ ),
+		memory_properties( physical_device.getMemoryProperties() ),
+		has_memory_budget( has_memory_budget_ ),
+		non_coherent_atom_size( physical_device.getProperties().limits.nonCoherentAtomSize ),
+		block_size( block_size_ )
+	{}
+
+	std::vector<uint32_t> MemoryArena::rank_memory_types(
+		const uint32_t type_bits,
+		const vk::MemoryPropertyFlags required,
+		const vk::MemoryPropertyFlags preferred ) const
+	{
+		using enum vk::MemoryPropertyFlagBits;
+
+		// only usable by resources created specifically for them
+		constexpr vk::MemoryPropertyFlags special { eProtected | eLazilyAllocated };
+		constexpr vk::MemoryPropertyFlags slow_amd { eDeviceCoherentAMD | eDeviceUncachedAMD };
+		const vk::MemoryPropertyFlags requested { required | preferred };
+
+		std::vector<std::pair<int, uint32_t>> scored {};
+		for( uint32_t index { 0 }; index < memory_properties.memoryTypeCount; ++index )
+		{
+			const vk::MemoryPropertyFlags flags { memory_properties.memoryTypes[index].propertyFlags };
+
+			if( !( type_bits & ( 1u << index ) )
+				|| ( flags & required ) != required
+				|| ( flags & special & ~required ) )
+				continue;
+
+			int score { 4 * std::popcount( static_cast< uint32_t >( flags & preferred ) ) };
+
+			if( flags & eDeviceLocal )
+				score += 2;
+
+			if( ( flags & eHostVisible ) && !( requested & eHostVisible ) )
+				score -= 1;
+
+			if( flags & slow_amd & ~requested )
+				score -= 8;
+
+			scored.emplace_back( score, index );
+		}
+
+		std::ranges::stable_sort( scored,
+			[]( const auto& lhs, const auto& rhs ) { return lhs.first > rhs.first; }
+		);
+
+		std::vector<uint32_t> ranked {};
+		ranked.reserve( scored.size() );
+		for( const auto& [score, index] : scored )
+			ranked.emplace_back( index );
+
+		return ranked;
+	}
+
+	MemoryArena::HeapBudget MemoryArena::query_budget( const uint32_t heap_index ) const
+	{
+		HeapBudget heap {};
+		heap.size = memory_properties.memoryHeaps[heap_index].size;
+		heap.reserved = heap_reserved[heap_index];
+
+		if( has_memory_budget )
+		{
+			const auto chain {
+				physical_device.getMemoryProperties2
+				<
+					vk::PhysicalDeviceMemoryProperties2,
+					vk::PhysicalDeviceMemoryBudgetPropertiesEXT
+				>()
+			};
+			const auto& budget { chain.get<vk::PhysicalDeviceMemoryBudgetPropertiesEXT>() };
+			heap.budget = budget.heapBudget[heap_index];
+			heap.usage = budget.heapUsage[heap_index];
+		}
+		else
+		{
+			// same heuristic VMA uses without the extension
+			heap.budget = heap.size / 10 * 8;
+			heap.usage = heap.reserved;
+		}
+		return heap;
+	}
+
+	MemoryArena::HeapBudget MemoryArena::heap_budget( const uint32_t heap_index ) const
+	{
+		std::scoped_lock lock( mutex );
+		return query_budget( heap_index );
+	}
+
+	MemoryBlock* MemoryArena::create_block(
+		const uint32_t memory_type_index,
+		const vk::DeviceSize bytesize,
+		const bool linear,
+		const bool dedicated )
+	{
+		const uint32_t heap_index { memory_properties.memoryTypes[memory_type_index].heapIndex };
+
+		if( const auto heap { query_budget( heap_index ) };
+			heap.usage + bytesize > heap.budget )
+		{
+			return nullptr;
+		}
+
+		const vk::MemoryAllocateInfo alloc_info( bytesize, memory_type_index );
+		auto& pool { pools[memory_type_index] };
+
+		try
+		{
+			pool.emplace_back(
+				std::make_unique<MemoryBlock>(
+					device.allocateMemory( alloc_info ),
+					bytesize,
+					memory_type_index,
+					memory_properties.memoryTypes[memory_type_index].propertyFlags,
+					linear,
+					dedicated
+				)
+			);
+		}
+		catch( const vk::OutOfDeviceMemoryError& )
+		{
+			return nullptr;
+		}
+		heap_reserved[heap_index] += bytesize;
+
+		return pool.back().get();
+	}
+
+	std::optional<Allocation> MemoryArena::try_allocate(
+		const vk::MemoryRequirements& requirements,
+		const uint32_t memory_type_index,
+		const bool linear )
+	{
+		using enum vk::MemoryPropertyFlagBits;
+
+		vk::DeviceSize bytesize { requirements.size };
+		vk::DeviceSize alignment { requirements.alignment };
+
+		const vk::MemoryPropertyFlags flags { memory_properties.memoryTypes[memory_type_index].propertyFlags };
+		if( ( flags & eHostVisible ) && !( flags & eHostCoherent ) )
+		{
+			alignment = std::max( alignment, non_coherent_atom_size );
+			bytesize = internal::align_up( bytesize, non_coherent_atom_size );
+		}
+
+		if( bytesize > block_size )
+		{
+			if( auto* const block { create_block( memory_type_index, bytesize, linear, true ) } )
+				return Allocation( *this, *block, block->allocate( bytesize, alignment ), bytesize );
+
+			return std::nullopt;
+		}
+
+		auto& pool { pools[memory_type_index] };
+
+		// newest blocks are the least fragmented, so search from the back
+		for( auto it { pool.rbegin() }; it != pool.rend(); ++it )
+		{
+			auto& block { **it };
+			if( block.dedicated || block.linear != linear )
+				continue;
+
+			if( const auto offset { block.allocate( bytesize, alignment ) };
+				offset != block.size )
+			{
+				return Allocation( *this, block, offset, bytesize );
+			}
+		}
+
+		// short of a whole block's budget, halve it down to the request before giving up
+		for( vk::DeviceSize size { block_size }; ; size /= 2 )
+		{
+			const vk::DeviceSize attempt { std::max( size, bytesize ) };
+			if( auto* const block { create_block( memory_type_index, attempt, linear, false ) } )
+				return Allocation( *this, *block, block->allocate( bytesize, alignment ), bytesize );
+
+			if( attempt == bytesize )
+				return std::nullopt;
+		}
+	}
+
+	void MemoryArena::throw_over_budget(
+		const vk::MemoryRequirements& requirements,
+		const uint32_t memory_type_index ) const
+	{
+		const uint32_t heap_index { memory_properties.memoryTypes[memory_type_index].heapIndex };
+		const auto heap { query_budget( heap_index ) };
+
+		std::stringstream ss;
+		ss
+			<< "Attempting to allocate too much memory (in Byte)\n"
+			<< "\tMemory heap: " << heap_index << "\n"
+			<< "\tMemory requested: " << requirements.size << "\n"
+			<< "\tMemory reserved: " << heap.reserved << "\n"
+			<< "\tMemory used: " << heap.usage << "\n"
+			<< "\tMemory budget: " << heap.budget << "\n"
+			<< "\tMaximum Memory: " << heap.size << "\n";
+
+		throw std::runtime_error( ss.str() );
+	}
+
+	Allocation MemoryArena::allocate(
+		const vk::MemoryRequirements& requirements,
+		const vk::MemoryPropertyFlags required,
+		const vk::MemoryPropertyFlags preferred,
+		const bool linear )
+	{
+		const auto candidates {
+			rank_memory_types( requirements.memoryTypeBits, required, preferred )
+		};
+
+		if( candidates.empty() )
+		{
+			throw std::runtime_error(
+				"Failed to get memory type with " + vk::to_string( required )
+			);
+		}
+
+		std::scoped_lock lock( mutex );
+
+		for( const uint32_t memory_type_index : candidates )
+		{
+			if( auto allocation { try_allocate( requirements, memory_type_index, linear ) } )
+				return std::move( *allocation );
+		}
+
+		throw_over_budget( requirements, candidates.front() );
+	}
+
+	Allocation MemoryArena::allocate(
+		const vk::MemoryRequirements& requirements,
+		const uint32_t memory_type_index,
+		const bool linear )
+	{
+		std::scoped_lock lock( mutex );
+
+		if( auto allocation { try_allocate( requirements, memory_type_index, linear ) } )
+			return std::move( *allocation );
+
+		throw_over_budget( requirements, memory_type_index );
+	}
+
+	void MemoryArena::free(
+		MemoryBlock& block,
+		const vk::DeviceSize offset,
+		const vk::DeviceSize bytesize )
+	{
+		std::scoped_lock lock( mutex );
+
+		block.free( offset, bytesize );
+		if( block.allocation_count > 0 )
+			return;
+
+		auto& pool { pools[block.memory_type_index] };
+
+		// keep one empty block per memory type around so alloc/free loops don't thrash the driver
+		const auto is_spare {
+			[&block]( const std::unique_ptr<MemoryBlock>& other )
+			{
+				return other.get() != &block
+					&& !other->dedicated
+					&& other->linear == block.linear
+					&& other->allocation_count == 0;
+			}
+		};
+
+		if( !block.dedicated && std::ranges::none_of( pool, is_spare ) )
+			return;
+
+		const uint32_t heap_index { memory_properties.memoryTypes[block.memory_type_index].heapIndex };
+		heap_reserved[heap_index] -= block.size;
+
+		std::erase_if( pool,
+			[&block]( const std::unique_ptr<MemoryBlock>& other )
+			{
+				return other.get() == &block;
+			}
+		);
+	}
+
+	vk::MappedMemoryRange MemoryArena::atom_range(
+		const MemoryBlock& block,
+		const vk::DeviceSize offset,
+		const vk::DeviceSize bytesize ) const
+	{
+		const vk::DeviceSize begin { internal::align_down( offset, non_coherent_atom_size ) };
+		const vk::DeviceSize end {
+			std::min( internal::align_up( offset + bytesize, non_coherent_atom_size ), block.size )
+		};
+		return vk::MappedMemoryRange( *block.memory, begin, end - begin );
+	}
+
+	MemoryArena::Statistics MemoryArena::statistics() const
+	{
+		Statistics stats;
+		for( uint32_t index { 0 }; index < memory_properties.memoryTypeCount; ++index )
+		{
+			const auto type_stats { statistics( index ) };
+			stats.block_count += type_stats.block_count;
+			stats.allocation_count += type_stats.allocation_count;
+			stats.reserved += type_stats.reserved;
+			stats.used += type_stats.used;
+		}
+		return stats;
+	}
+
+	MemoryArena::Statistics MemoryArena::statistics( const uint32_t memory_type_index ) const
+	{
+		std::scoped_lock lock( mutex );
+
+		Statistics stats;
+		for( const auto& block : pools.at( memory_type_index ) )
+		{
+			++stats.block_count;
+			stats.allocation_count += block->allocation_count;
+			stats.reserved += block->size;
+			stats.used += block->used;
+		}
+		return stats;
+	}
+
+}
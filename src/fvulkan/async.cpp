@@ -0,0 +1,216 @@
+#include <exception>
+#include <limits>
+#include <tuple> // ignore
+#include <utility> // move
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include <fgl/vulkan/async.hpp>
+
+namespace fgl::vulkan
+{
+	namespace internal
+	{
+		constexpr uint64_t no_timeout { std::numeric_limits<uint64_t>::max() };
+
+		std::optional<vk::raii::Semaphore> create_timeline( const Context& context )
+		{
+			if( !context.features.timeline_semaphore )
+				return std::nullopt;
+
+			constexpr uint64_t initial_value { 0 };
+			const vk::StructureChain<vk::SemaphoreCreateInfo, vk::SemaphoreTypeCreateInfo> ci(
+				vk::SemaphoreCreateInfo(),
+				vk::SemaphoreTypeCreateInfo( vk::SemaphoreType::eTimeline, initial_value )
+			);
+			return vk::raii::Semaphore( context.device, ci.get<vk::SemaphoreCreateInfo>() );
+		}
+	} // namespace internal
+
+	/// FENCE POOL
+
+	FencePool::FencePool( const Context& context )
+		:
+		device( context.device )
+	{}
+
+	vk::raii::Fence FencePool::acquire()
+	{
+		{
+			std::scoped_lock lock( mutex );
+			if( !free_fences.empty() )
+			{
+				vk::raii::Fence fence { std::move( free_fences.back() ) };
+				free_fences.pop_back();
+				return fence;
+			}
+		}
+		return vk::raii::Fence( device, vk::FenceCreateInfo() );
+	}
+
+	void FencePool::release( vk::raii::Fence&& fence )
+	{
+		device.resetFences( { *fence } );
+
+		std::scoped_lock lock( mutex );
+		free_fences.emplace_back( std::move( fence ) );
+	}
+
+	/// ASYNC QUEUE
+
+	AsyncQueue::AsyncQueue(
+		const Context& context_,
+		const uint32_t queue_family_index,
+		const uint32_t queue_index )
+		:
+		context( context_ ),
+		queue( context.device, queue_family_index, queue_index ),
+		timeline( internal::create_timeline( context ) ),
+		fences( context ),
+		completion_thread( &AsyncQueue::completion_loop, this )
+	{}
+
+	AsyncQueue::~AsyncQueue()
+	{
+		{
+			std::scoped_lock lock( pending_mutex );
+			stopping = true;
+		}
+		pending_cv.notify_all();
+		completion_thread.join();
+	}
+
+	std::future<void> AsyncQueue::submit(
+		const std::span<const vk::CommandBuffer> buffers,
+		std::function<void()> on_complete )
+	{
+		Pending work { 0, std::nullopt, {}, std::move( on_complete ) };
+		auto future { work.promise.get_future() };
+
+		{
+			// vkQueueSubmit needs the queue externally synchronized
+			std::scoped_lock lock( submit_mutex );
+
+			const vk::ArrayProxyNoTemporaries<const vk::CommandBuffer> command_buffers(
+				static_cast< uint32_t >( buffers.size() ), buffers.data()
+			);
+
+			if( timeline )
+			{
+				// published only once submitted, so a throwing submit leaves no value that never signals
+				work.value = last_value + 1;
+				const vk::TimelineSemaphoreSubmitInfo timeline_info( nullptr, work.value );
+				const vk::SubmitInfo submit_info(
+					nullptr, nullptr, command_buffers, **timeline, &timeline_info
+				);
+				queue.submit( submit_info );
+				last_value = work.value;
+			}
+			else
+			{
+				work.fence = fences.acquire();
+				const vk::SubmitInfo submit_info( nullptr, nullptr, command_buffers, nullptr );
+				try
+				{
+					queue.submit( submit_info, **work.fence );
+				}
+				catch( ... )
+				{
+					// never submitted, so it can go straight back
+					fences.release( std::move( *work.fence ) );
+					throw;
+				}
+			}
+
+			// pushed under submit_mutex so pending stays in submission order
+			std::scoped_lock pending_lock( pending_mutex );
+			pending.emplace_back( std::move( work ) );
+		}
+		pending_cv.notify_one();
+
+		return future;
+	}
+
+	std::future<void> AsyncQueue::submit(
+		const vk::raii::CommandBuffer& buffer,
+		std::function<void()> on_complete )
+	{
+		const vk::CommandBuffer handle { *buffer };
+		return submit( std::span<const vk::CommandBuffer>( &handle, 1 ), std::move( on_complete ) );
+	}
+
+	uint64_t AsyncQueue::submitted_value()
+	{
+		std::scoped_lock lock( submit_mutex );
+		return last_value;
+	}
+
+	std::optional<TimelinePoint> AsyncQueue::submitted_point()
+	{
+		if( !timeline )
+			return std::nullopt;
+
+		return TimelinePoint { **timeline, submitted_value() };
+	}
+
+	void AsyncQueue::wait_idle()
+	{
+		std::unique_lock lock( pending_mutex );
+		idle_cv.wait( lock, [this] { return pending.empty(); } );
+	}
+
+	void AsyncQueue::wait_for( const Pending& work ) const
+	{
+		if( timeline )
+		{
+			const vk::Semaphore semaphore { **timeline };
+			const vk::SemaphoreWaitInfo wait_info( {}, semaphore, work.value );
+			std::ignore = context.device.waitSemaphores( wait_info, internal::no_timeout );
+		}
+		else
+		{
+			std::ignore = context.device.waitForFences( { **work.fence }, VK_TRUE, internal::no_timeout );
+		}
+	}
+
+	void AsyncQueue::completion_loop()
+	{
+		std::unique_lock lock( pending_mutex );
+		while( true )
+		{
+			pending_cv.wait( lock, [this] { return stopping || !pending.empty(); } );
+			if( pending.empty() )
+				return; // stopping and drained
+
+			// a single queue completes in submission order, so only the oldest needs a wait
+			Pending& oldest { pending.front() };
+			lock.unlock();
+
+			std::exception_ptr error {};
+			try
+			{
+				wait_for( oldest );
+				if( oldest.on_complete )
+					oldest.on_complete();
+			}
+			catch( ... )
+			{
+				error = std::current_exception();
+			}
+
+			if( oldest.fence )
+				fences.release( std::move( *oldest.fence ) );
+
+			if( error )
+				oldest.promise.set_exception( error );
+			else
+				oldest.promise.set_value();
+
+			lock.lock();
+			pending.pop_front();
+			if( pending.empty() )
+				idle_cv.notify_all();
+		}
+	}
+
+}
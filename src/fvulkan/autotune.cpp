@@ -0,0 +1,308 @@
+#include <algorithm>
+#include <cctype> // isspace
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <tuple> // ignore
+#include <utility>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include <fgl/vulkan/autotune.hpp>
+#include <fgl/vulkan/commandqueue.hpp>
+#include <fgl/vulkan/internal/file.hpp>
+
+namespace fgl::vulkan
+{
+	namespace internal
+	{
+		// a driver update changes the generated code, so it is part of the key
+		std::string device_key( const vk::PhysicalDeviceProperties& properties )
+		{
+			std::stringstream ss;
+			ss << std::hex << properties.vendorID << ':' << properties.deviceID << ':' << properties.driverVersion;
+			return ss.str();
+		}
+
+		std::string entry_key( const std::string_view kernel, const WorkgroupSize& problem_size )
+		{
+			std::stringstream ss;
+			ss << kernel << ' ' << problem_size[0] << ' ' << problem_size[1] << ' ' << problem_size[2];
+			return ss.str();
+		}
+
+		vk::raii::CommandBuffer create_tuning_command_buffer(
+			const vk::raii::Device& device,
+			const vk::raii::CommandPool& pool )
+		{
+			const vk::CommandBufferAllocateInfo alloc_info( *pool, vk::CommandBufferLevel::ePrimary, 1 );
+			return std::move( vk::raii::CommandBuffers( device, alloc_info ).front() );
+		}
+
+		uint32_t timestamp_valid_bits( const Context& context )
+		{
+			return context.physical_device.getQueueFamilyProperties().at( context.queue_family_index ).timestampValidBits;
+		}
+	} // namespace internal
+
+	WorkgroupSize group_count(
+		const WorkgroupSize& problem_size,
+		const WorkgroupSize& workgroup_size )
+	{
+		WorkgroupSize groups {};
+		for( std::size_t axis { 0 }; axis < groups.size(); ++axis )
+			groups[axis] = ( problem_size[axis] + workgroup_size[axis] - 1 ) / workgroup_size[axis];
+
+		return groups;
+	}
+
+	Autotuner::Autotuner(
+		const Context& context_,
+		std::filesystem::path database_path_,
+		const uint32_t iterations_ )
+		:
+		context( context_ ),
+		queue( context.device, context.queue_family_index, 0 ),
+		pool(
+			context.device,
+			vk::CommandPoolCreateInfo( vk::CommandPoolCreateFlagBits::eResetCommandBuffer, context.queue_family_index )
+		),
+		command_buffer( internal::create_tuning_command_buffer( context.device, pool ) ),
+		queries( context.device, vk::QueryPoolCreateInfo( {}, vk::QueryType::eTimestamp, 2 ) ),
+		fence( context.device, vk::FenceCreateInfo() ),
+		timestamp_valid_bits( internal::timestamp_valid_bits( context ) ),
+		device_key( internal::device_key( context.properties ) ),
+		database_path( std::move( database_path_ ) ),
+		iterations( std::max( iterations_, 1u ) )
+	{
+		load();
+	}
+
+	Autotuner::~Autotuner()
+	{
+		try
+		{
+			save();
+		}
+		catch( const std::exception& e )
+		{
+			std::cerr << "\n\tFailed to save the tuning database: " << e.what() << std::endl;
+		}
+	}
+
+	void Autotuner::load()
+	{
+		if( database_path.empty() )
+			return;
+
+		std::ifstream file( database_path );
+		for( std::string line; std::getline( file, line ); )
+		{
+			if( line.empty() )
+				continue;
+
+			// <device> <kernel> <problem x y z> <workgroup x y z> <milliseconds>
+			std::istringstream fields( line );
+			std::string device, kernel;
+			WorkgroupSize problem_size {};
+			Result result {};
+			fields
+				>> device >> kernel
+				>> problem_size[0] >> problem_size[1] >> problem_size[2]
+				>> result.workgroup_size[0] >> result.workgroup_size[1] >> result.workgroup_size[2]
+				>> result.milliseconds;
+
+			if( device != device_key )
+				foreign_entries.emplace_back( std::move( line ) );
+			else if( fields )
+				database[internal::entry_key( kernel, problem_size )] = result;
+		}
+	}
+
+	void Autotuner::save() const
+	{
+		std::scoped_lock lock( mutex );
+		if( database_path.empty() || !dirty )
+			return;
+
+		std::stringstream ss;
+		for( const auto& line : foreign_entries )
+			ss << line << '\n';
+
+		for( const auto& [key, result] : database )
+		{
+			const auto& [x, y, z] { result.workgroup_size };
+			ss << device_key << ' ' << key << ' ' << x << ' ' << y << ' ' << z << ' ' << result.milliseconds << '\n';
+		}
+
+		const std::string text { ss.str() };
+		internal::write_atomically( database_path, std::as_bytes( std::span( text ) ) );
+	}
+
+	std::vector<WorkgroupSize> Autotuner::candidate_shapes( const uint32_t dimensions ) const
+	{
+		const auto& limits { context.properties.limits };
+
+		std::vector<WorkgroupSize> shapes;
+		for( uint32_t total { std::max( context.subgroup_size, 1u ) };
+			total <= limits.maxComputeWorkGroupInvocations;
+			total *= 2 )
+		{
+			if( dimensions <= 1 )
+			{
+				if( total <= limits.maxComputeWorkGroupSize[0] )
+					shapes.push_back( { total, 1, 1 } );
+				continue;
+			}
+
+			// rows narrower than 8 leave most of a subgroup idle at the row ends
+			constexpr uint32_t min_width { 8 };
+			for( uint32_t x { min_width }; x <= total; x *= 2 )
+			{
+				const uint32_t y { total / x };
+				if( x <= limits.maxComputeWorkGroupSize[0] && y <= limits.maxComputeWorkGroupSize[1] )
+					shapes.push_back( { x, y, 1 } );
+			}
+		}
+		return shapes;
+	}
+
+	double Autotuner::time_dispatches(
+		const Pipeline& pipeline,
+		const Specialization& specialization,
+		const WorkgroupSize& groups,
+		const std::span<const std::byte> push_constants )
+	{
+		using enum vk::PipelineStageFlagBits;
+
+		const auto& [x, y, z] { groups };
+
+		// back to back repetitions must not overlap or they'd hide each other's cost
+		const vk::MemoryBarrier serialize(
+			vk::AccessFlagBits::eShaderWrite,
+			vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite
+		);
+
+		command_buffer.begin( vk::CommandBufferBeginInfo( vk::CommandBufferUsageFlagBits::eOneTimeSubmit ) );
+		command_buffer.resetQueryPool( *queries, 0, 2 );
+
+		// one untimed dispatch warms up caches and clocks
+		record_dispatch( command_buffer, pipeline, specialization, x, y, z, push_constants );
+		command_buffer.pipelineBarrier( eComputeShader, eComputeShader, {}, serialize, nullptr, nullptr );
+
+		command_buffer.writeTimestamp( eTopOfPipe, *queries, 0 );
+		for( uint32_t i { 0 }; i < iterations; ++i )
+		{
+			record_dispatch( command_buffer, pipeline, specialization, x, y, z, push_constants );
+			command_buffer.pipelineBarrier( eComputeShader, eComputeShader, {}, serialize, nullptr, nullptr );
+		}
+		command_buffer.writeTimestamp( eBottomOfPipe, *queries, 1 );
+		command_buffer.end();
+
+		const vk::CommandBuffer handle { *command_buffer };
+		const auto host_start { std::chrono::steady_clock::now() };
+		queue.submit( vk::SubmitInfo( nullptr, nullptr, handle ), *fence );
+		std::ignore = context.device.waitForFences( { *fence }, VK_TRUE, std::numeric_limits<uint64_t>::max() );
+		const auto host_time { std::chrono::steady_clock::now() - host_start };
+		context.device.resetFences( { *fence } );
+
+		if( timestamp_valid_bits == 0 )
+		{
+			// includes the warm-up dispatch and the submit overhead, but ranks shapes all the same
+			const std::chrono::duration<double, std::milli> milliseconds { host_time };
+			return milliseconds.count() / ( iterations + 1 );
+		}
+
+		const auto [result, stamps] {
+			queries.getResults<uint64_t>(
+				0, 2, 2 * sizeof( uint64_t ), sizeof( uint64_t ),
+				vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait
+			)
+		};
+
+		const uint64_t mask {
+			timestamp_valid_bits >= 64 ? ~uint64_t { 0 } : ( uint64_t { 1 } << timestamp_valid_bits ) - 1
+		};
+		const uint64_t ticks { ( stamps[1] - stamps[0] ) & mask };
+		const double nanoseconds { static_cast< double >( ticks ) * static_cast< double >( context.properties.limits.timestampPeriod ) };
+		return nanoseconds / 1e6 / iterations;
+	}
+
+	std::vector<Autotuner::Result> Autotuner::benchmark(
+		const Pipeline& pipeline,
+		const WorkgroupSize& problem_size,
+		const std::span<const WorkgroupSize> candidates,
+		const std::span<const std::byte> push_constants )
+	{
+		const auto& max_groups { context.properties.limits.maxComputeWorkGroupCount };
+
+		// one command buffer and query pool, so one benchmark at a time
+		std::scoped_lock lock( tuning_mutex );
+
+		std::vector<Result> results;
+		results.reserve( candidates.size() );
+		for( const auto& candidate : candidates )
+		{
+			const WorkgroupSize groups { group_count( problem_size, candidate ) };
+			if( groups[0] > max_groups[0] || groups[1] > max_groups[1] || groups[2] > max_groups[2] )
+				continue;
+
+			Specialization specialization { pipeline.specialization };
+			specialization.workgroup_size( candidate[0], candidate[1], candidate[2] );
+
+			// compile outside of the measurement
+			std::ignore = pipeline.variant( specialization );
+
+			results.push_back( { candidate, time_dispatches( pipeline, specialization, groups, push_constants ) } );
+		}
+
+		std::ranges::sort( results, {}, &Result::milliseconds );
+		return results;
+	}
+
+	WorkgroupSize Autotuner::tune(
+		const std::string& kernel,
+		const Pipeline& pipeline,
+		const WorkgroupSize& problem_size,
+		const std::span<const std::byte> push_constants )
+	{
+		if( kernel.empty() || std::ranges::any_of( kernel, []( const char c ) { return std::isspace( static_cast< unsigned char >( c ) ) != 0; } ) )
+			throw std::invalid_argument( "Autotuner: kernel names must be non-empty and free of whitespace." );
+
+		const std::string key { internal::entry_key( kernel, problem_size ) };
+		{
+			std::scoped_lock lock( mutex );
+			if( const auto it { database.find( key ) }; it != database.cend() )
+				return it->second.workgroup_size;
+		}
+
+		const uint32_t dimensions { problem_size[2] > 1 ? 3u : problem_size[1] > 1 ? 2u : 1u };
+		const std::vector<WorkgroupSize> candidates { candidate_shapes( dimensions ) };
+
+		const std::vector<Result> results { benchmark( pipeline, problem_size, candidates, push_constants ) };
+
+		if( results.empty() )
+		{
+			std::stringstream ss;
+			ss << "Autotuner: no workgroup shape fits " << kernel << " on this device.";
+			throw std::runtime_error( ss.str() );
+		}
+
+		const Result& best { results.front() };
+		std::cout
+			<< "\n\tTuned " << kernel << ": "
+			<< best.workgroup_size[0] << 'x' << best.workgroup_size[1] << 'x' << best.workgroup_size[2]
+			<< " (" << best.milliseconds << " ms per dispatch, " << results.size() << " shapes tried)"
+			<< std::endl;
+
+		std::scoped_lock lock( mutex );
+		database[key] = best;
+		dirty = true;
+		return best.workgroup_size;
+	}
+
+}
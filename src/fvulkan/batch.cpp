@@ -0,0 +1,176 @@
+#include <algorithm>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include <fgl/vulkan/batch.hpp>
+
+namespace fgl::vulkan
+{
+	namespace internal
+	{
+		bool contains( const std::vector<vk::Buffer>& buffers, const vk::Buffer buffer )
+		{
+			return std::ranges::find( buffers, buffer ) != buffers.end();
+		}
+
+		bool reads( const Access access ) noexcept
+		{
+			return access != Access::eWrite;
+		}
+
+		bool writes( const Access access ) noexcept
+		{
+			return access != Access::eRead;
+		}
+	} // namespace internal
+
+	DispatchRecorder::DispatchRecorder( const vk::raii::CommandBuffer& buffer_ )
+		:
+		buffer( buffer_ )
+	{}
+
+	void DispatchRecorder::barrier()
+	{
+		constexpr vk::AccessFlags dst_access {
+			vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite
+		};
+
+		if( pending_unknown )
+		{
+			const vk::MemoryBarrier memory_barrier( vk::AccessFlagBits::eShaderWrite, dst_access );
+			buffer.pipelineBarrier(
+				vk::PipelineStageFlagBits::eComputeShader,
+				vk::PipelineStageFlagBits::eComputeShader,
+				{},
+				memory_barrier,
+				nullptr,
+				nullptr
+			);
+		}
+		else
+		{
+			// every pending write is made visible, not only the conflicting ones
+			std::vector<vk::BufferMemoryBarrier> buffer_barriers {};
+			buffer_barriers.reserve( pending_writes.size() );
+			for( const vk::Buffer written : pending_writes )
+			{
+				buffer_barriers.emplace_back(
+					vk::AccessFlagBits::eShaderWrite,
+					dst_access,
+					VK_QUEUE_FAMILY_IGNORED,
+					VK_QUEUE_FAMILY_IGNORED,
+					written,
+					0,
+					VK_WHOLE_SIZE
+				);
+			}
+
+			// a pure WAR hazard only needs the execution dependency
+			buffer.pipelineBarrier(
+				vk::PipelineStageFlagBits::eComputeShader,
+				vk::PipelineStageFlagBits::eComputeShader,
+				{},
+				nullptr,
+				buffer_barriers,
+				nullptr
+			);
+		}
+
+		pending_writes.clear();
+		pending_reads.clear();
+		pending_unknown = false;
+		++barrier_count;
+	}
+
+	void DispatchRecorder::order( const std::span<const BufferAccess> accesses )
+	{
+		const bool anything_pending {
+			pending_unknown || !pending_writes.empty() || !pending_reads.empty()
+		};
+
+		bool hazard { accesses.empty() ? anything_pending : pending_unknown };
+		for( const auto& [accessed, access] : accesses )
+		{
+			const vk::Buffer handle { *accessed->buffer };
+			if( internal::contains( pending_writes, handle )
+				|| ( internal::writes( access ) && internal::contains( pending_reads, handle ) ) )
+			{
+				hazard = true;
+				break;
+			}
+		}
+
+		if( hazard )
+			barrier();
+	}
+
+	void DispatchRecorder::track( const std::span<const BufferAccess> accesses )
+	{
+		++dispatch_count;
+
+		if( accesses.empty() )
+		{
+			pending_unknown = true;
+			return;
+		}
+
+		for( const auto& [accessed, access] : accesses )
+		{
+			const vk::Buffer handle { *accessed->buffer };
+			if( internal::writes( access ) && !internal::contains( pending_writes, handle ) )
+				pending_writes.emplace_back( handle );
+			if( internal::reads( access ) && !internal::contains( pending_reads, handle ) )
+				pending_reads.emplace_back( handle );
+		}
+	}
+
+	void DispatchRecorder::dispatch(
+		const Pipeline& pipeline,
+		const std::span<const BufferAccess> accesses,
+		const uint32_t groupCountX,
+		const uint32_t groupCountY,
+		const uint32_t groupCountZ,
+		const std::span<const std::byte> push_constants )
+	{
+		order( accesses );
+		record_dispatch( buffer, pipeline, groupCountX, groupCountY, groupCountZ, push_constants );
+		track( accesses );
+	}
+
+	void DispatchRecorder::dispatch(
+		const Pipeline& pipeline,
+		const vk::DescriptorSet set,
+		const std::span<const BufferAccess> accesses,
+		const uint32_t groupCountX,
+		const uint32_t groupCountY,
+		const uint32_t groupCountZ,
+		const std::span<const std::byte> push_constants )
+	{
+		order( accesses );
+		record_dispatch( buffer, pipeline, set, groupCountX, groupCountY, groupCountZ, push_constants );
+		track( accesses );
+	}
+
+	/// SUBMIT BATCH
+
+	void SubmitBatch::add( const vk::raii::CommandBuffer& buffer )
+	{
+		buffers.emplace_back( *buffer );
+	}
+
+	void SubmitBatch::add( const CommandQueue& queue )
+	{
+		add( queue.buffer );
+	}
+
+	void SubmitBatch::submit( const vk::raii::Queue& queue, const vk::Fence fence )
+	{
+		if( buffers.empty() && !fence )
+			return;
+
+		const vk::SubmitInfo submit_info( nullptr, nullptr, buffers, nullptr );
+		queue.submit( submit_info, fence );
+		buffers.clear();
+	}
+
+}
@@ -1,4 +1,8 @@
+#include <stdexcept>
+#include <utility>
+
 #include <fgl/vulkan/commandqueue.hpp>
+#include <fgl/vulkan/profiler.hpp>
 
 namespace fgl::vulkan
 {
@@ -15,8 +19,145 @@ namespace fgl::vulkan
 			);
 			return std::move( vk::raii::CommandBuffers( device, alloc_info ).front() );
 		}
+
+		vk::CommandPoolCreateInfo reusable_pool_info( const uint32_t queue_family_index )
+		{
+			return vk::CommandPoolCreateInfo(
+				vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+				queue_family_index
+			);
+		}
+
+		// a Pipeline allocates exactly one set, for its single layout
+		vk::DescriptorSet pipeline_set( const fgl::vulkan::Pipeline& pipeline )
+		{
+			return *pipeline.sets.front();
+		}
+
+		// record_dispatch with the pipeline handle and descriptor sets to bind passed separately
+		void record_dispatch(
+			const vk::raii::CommandBuffer& buffer,
+			const fgl::vulkan::Pipeline& pipeline,
+			const vk::Pipeline bound_pipeline,
+			const std::span<const vk::DescriptorSet> sets,
+			const std::span<const uint32_t> dynamic_offsets,
+			const uint32_t groupCountX,
+			const uint32_t groupCountY,
+			const uint32_t groupCountZ,
+			const std::span<const std::byte> push_constants )
+		{
+			buffer.bindPipeline( vk::PipelineBindPoint::eCompute, bound_pipeline );
+
+			constexpr uint32_t first_set { 0 };
+			buffer.bindDescriptorSets(
+				vk::PipelineBindPoint::eCompute,
+				*pipeline.layout,
+				first_set,
+				sets,
+				dynamic_offsets
+			);
+
+			if( !push_constants.empty() )
+			{
+				if( push_constants.size() > pipeline.push_constant_size )
+				{
+					throw std::length_error( "Push constants exceed the pipeline's push constant range." );
+				}
+
+				constexpr uint32_t offset { 0 };
+				buffer.pushConstants<std::byte>(
+					*pipeline.layout,
+					vk::ShaderStageFlagBits::eCompute,
+					offset,
+					vk::ArrayProxy<const std::byte>(
+						static_cast< uint32_t >( push_constants.size() ), push_constants.data()
+					)
+				);
+			}
+
+			buffer.dispatch( groupCountX, groupCountY, groupCountZ );
+		}
 	} // namespace internal
 
+	void record_dispatch(
+		const vk::raii::CommandBuffer& buffer,
+		const fgl::vulkan::Pipeline& pipeline,
+		const uint32_t groupCountX,
+		const uint32_t groupCountY,
+		const uint32_t groupCountZ,
+		const std::span<const std::byte> push_constants )
+	{
+		const vk::DescriptorSet set { internal::pipeline_set( pipeline ) };
+		internal::record_dispatch(
+			buffer, pipeline, *pipeline.pipeline, { &set, 1 }, {}, groupCountX, groupCountY, groupCountZ, push_constants
+		);
+	}
+
+	void record_dispatch(
+		const vk::raii::CommandBuffer& buffer,
+		const fgl::vulkan::Pipeline& pipeline,
+		const fgl::vulkan::Specialization& specialization,
+		const uint32_t groupCountX,
+		const uint32_t groupCountY,
+		const uint32_t groupCountZ,
+		const std::span<const std::byte> push_constants )
+	{
+		const vk::DescriptorSet set { internal::pipeline_set( pipeline ) };
+		internal::record_dispatch(
+			buffer, pipeline, *pipeline.variant( specialization ), { &set, 1 }, {}, groupCountX, groupCountY, groupCountZ, push_constants
+		);
+	}
+
+	void record_dispatch(
+		const vk::raii::CommandBuffer& buffer,
+		const fgl::vulkan::Pipeline& pipeline,
+		const vk::DescriptorSet set,
+		const uint32_t groupCountX,
+		const uint32_t groupCountY,
+		const uint32_t groupCountZ,
+		const std::span<const std::byte> push_constants )
+	{
+		internal::record_dispatch(
+			buffer, pipeline, *pipeline.pipeline, { &set, 1 }, {}, groupCountX, groupCountY, groupCountZ, push_constants
+		);
+	}
+
+	void record_dispatch(
+		const vk::raii::CommandBuffer& buffer,
+		const fgl::vulkan::Pipeline& pipeline,
+		const fgl::vulkan::Specialization& specialization,
+		const vk::DescriptorSet set,
+		const uint32_t groupCountX,
+		const uint32_t groupCountY,
+		const uint32_t groupCountZ,
+		const std::span<const std::byte> push_constants )
+	{
+		internal::record_dispatch(
+			buffer, pipeline, *pipeline.variant( specialization ), { &set, 1 }, {}, groupCountX, groupCountY, groupCountZ, push_constants
+		);
+	}
+
+	void record_dispatch(
+		const vk::raii::CommandBuffer& buffer,
+		const fgl::vulkan::Pipeline& pipeline,
+		const vk::DescriptorSet set,
+		const std::span<const uint32_t> dynamic_offsets,
+		const uint32_t groupCountX,
+		const uint32_t groupCountY,
+		const uint32_t groupCountZ,
+		const std::span<const std::byte> push_constants )
+	{
+		internal::record_dispatch(
+			buffer, pipeline, *pipeline.pipeline, { &set, 1 }, dynamic_offsets, groupCountX, groupCountY, groupCountZ, push_constants
+		);
+	}
+
+	CommandQueue::CommandQueue( const fgl::vulkan::Context& context )
+		:
+		pool( context.device, internal::reusable_pool_info( context.queue_family_index ) ),
+		buffer( internal::create_command_buffer( context.device, pool ) )
+	{}
+
 	CommandQueue::CommandQueue(
 		const fgl::vulkan::Context& context,
 		const fgl::vulkan::Pipeline& pipeline,
@@ -25,31 +166,84 @@ namespace fgl::vulkan
 		const uint32_t groupCountY,
 		const uint32_t groupCountZ )
 		:
-		pool(
-			context.device,
-			vk::CommandPoolCreateInfo( {}, context.queue_family_index )
-		),
-		buffer( internal::create_command_buffer( context.device, pool ) )
+		CommandQueue( context )
 	{
+		record( pipeline, flags, groupCountX, groupCountY, groupCountZ );
+	}
+
+	void CommandQueue::record(
+		const fgl::vulkan::Pipeline& pipeline,
+		const vk::CommandBufferUsageFlags flags,
+		const uint32_t groupCountX,
+		const uint32_t groupCountY,
+		const uint32_t groupCountZ,
+		const std::span<const std::byte> push_constants ) const
+	{
+		// begin() resets the buffer since the pool has eResetCommandBuffer
 		buffer.begin( { flags } );
-		buffer.bindPipeline( vk::PipelineBindPoint::eCompute, *pipeline.pipeline );
-
-		std::vector<vk::DescriptorSet> vec;
-		vec.reserve( std::ranges::size( pipeline.sets ) );
-		for( const auto& layout : pipeline.sets )
-			vec.emplace_back( *layout );
-
-		constexpr uint32_t first_set { 0 };
-		buffer.bindDescriptorSets(
-			vk::PipelineBindPoint::eCompute,
-			*pipeline.layout,
-			first_set,
-			vec,
-			nullptr // dynamic offsets
-		);
+		record_dispatch( buffer, pipeline, groupCountX, groupCountY, groupCountZ, push_constants );
+		buffer.end();
+	}
 
-		buffer.dispatch( groupCountX, groupCountY, groupCountZ );
+	void CommandQueue::record(
+		fgl::vulkan::Profiler& profiler,
+		std::string name,
+		const fgl::vulkan::Pipeline& pipeline,
+		const vk::CommandBufferUsageFlags flags,
+		const uint32_t groupCountX,
+		const uint32_t groupCountY,
+		const uint32_t groupCountZ,
+		const std::span<const std::byte> push_constants ) const
+	{
+		buffer.begin( { flags } );
+		profiler.record_dispatch( buffer, std::move( name ), pipeline, groupCountX, groupCountY, groupCountZ, push_constants );
 		buffer.end();
 	}
 
+	/// COMMAND BUFFER POOL
+
+	CommandBufferPool::CommandBufferPool(
+		const fgl::vulkan::Context& context,
+		const uint32_t queue_family_index,
+		const vk::CommandBufferLevel level_ )
+		:
+		device( context.device ),
+		pool( context.device, internal::reusable_pool_info( queue_family_index ) ),
+		level( level_ )
+	{}
+
+	vk::raii::CommandBuffer CommandBufferPool::acquire()
+	{
+		if( auto returned { returned_buffers.pop() } )
+			return std::move( *returned );
+
+		if( free_buffers.empty() )
+		{
+			const vk::CommandBufferAllocateInfo alloc_info(
+				*pool, level, allocation_batch
+			);
+			for( auto& command_buffer : vk::raii::CommandBuffers( device, alloc_info ) )
+				free_buffers.emplace_back( std::move( command_buffer ) );
+		}
+
+		vk::raii::CommandBuffer command_buffer { std::move( free_buffers.back() ) };
+		free_buffers.pop_back();
+		return command_buffer;
+	}
+
+	void CommandBufferPool::recycle( vk::raii::CommandBuffer&& buffer )
+	{
+		free_buffers.emplace_back( std::move( buffer ) );
+	}
+
+	void CommandBufferPool::recycle_concurrently( vk::raii::CommandBuffer&& buffer )
+	{
+		returned_buffers.push( std::move( buffer ) );
+	}
+
+	void CommandBufferPool::reset() const
+	{
+		pool.reset();
+	}
+
 } // namespace fgl::vulkan
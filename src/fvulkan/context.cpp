@@ -1,6 +1,19 @@
+#include <algorithm>
+#include <cstring> // memcmp
+#include <functional> // greater
+#include <fstream>
+#include <iterator>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
 #include <vulkan/vulkan_raii.hpp>
 
 #include <fgl/vulkan/context.hpp>
+#include <fgl/vulkan/internal/file.hpp>
 
 namespace fgl::vulkan
 {
@@ -28,6 +41,93 @@ namespace fgl::vulkan
 		);
 	}
 
+	uint32_t Context::index_of_transfer_queue_family() const
+	{
+		using enum vk::QueueFlagBits;
+
+		const std::vector<vk::QueueFamilyProperties> props {
+			physical_device.getQueueFamilyProperties()
+		};
+
+		// dedicated transfer families map to the copy engines on discrete GPUs
+		for( uint32_t index { 0 }; index < props.size(); ++index )
+		{
+			const auto flags { props[index].queueFlags };
+			if( ( flags & eTransfer ) && !( flags & ( eCompute | eGraphics ) ) )
+				return index;
+		}
+		return queue_family_index;
+	}
+
+	std::vector<uint32_t> Context::queue_family_indices() const
+	{
+		std::vector<uint32_t> indices;
+		indices.reserve( queue_families.size() );
+		for( const auto& family : queue_families )
+			indices.emplace_back( family.index );
+
+		return indices;
+	}
+
+	uint32_t Context::queue_count( const uint32_t family_index ) const
+	{
+		const auto it { std::ranges::find( queue_families, family_index, &QueueFamily::index ) };
+		return it != queue_families.cend() ? it->queue_count : 0;
+	}
+
+	bool Context::has_device_extension( const std::string_view name ) const
+	{
+		return std::ranges::any_of( device_extensions,
+			[name]( const char* extension ) { return name == extension; }
+		);
+	}
+
+	uint64_t device_score( const vk::raii::PhysicalDevice& physical_device )
+	{
+		const auto families { physical_device.getQueueFamilyProperties() };
+		const bool has_compute {
+			std::ranges::any_of( families,
+				[]( const vk::QueueFamilyProperties& family ) -> bool
+				{
+					return static_cast< bool >( family.queueFlags & vk::QueueFlagBits::eCompute );
+				}
+			)
+		};
+		if( !has_compute )
+			return 0;
+
+		uint64_t type_rank { 1 };
+		switch( physical_device.getProperties().deviceType )
+		{
+			case vk::PhysicalDeviceType::eDiscreteGpu:
+				type_rank = 5;
+				break;
+			case vk::PhysicalDeviceType::eIntegratedGpu:
+				type_rank = 4;
+				break;
+			case vk::PhysicalDeviceType::eVirtualGpu:
+				type_rank = 3;
+				break;
+			case vk::PhysicalDeviceType::eCpu:
+				type_rank = 2;
+				break;
+			case vk::PhysicalDeviceType::eOther:
+			default:
+				break;
+		}
+
+		uint64_t largest_heap { 0 };
+		const auto memory { physical_device.getMemoryProperties() };
+		for( uint32_t index { 0 }; index < memory.memoryHeapCount; ++index )
+		{
+			if( memory.memoryHeaps[index].flags & vk::MemoryHeapFlagBits::eDeviceLocal )
+				largest_heap = std::max( largest_heap, memory.memoryHeaps[index].size );
+		}
+
+		// heaps in MB stay well below 2^40, so the type always decides first
+		return type_rank << 40 | largest_heap >> 20;
+	}
+
 	namespace internal
 	{
 		vk::raii::Instance create_instance(
@@ -45,22 +145,292 @@ namespace fgl::vulkan
 			return vk::raii::Instance( context, ci );
 		}
 
+		std::vector<uint32_t> rank_physical_devices(
+			const vk::raii::Instance& instance,
+			const DeviceSelection& selection )
+		{
+			const vk::raii::PhysicalDevices physical_devices( instance );
+
+			std::vector<std::pair<uint64_t, uint32_t>> scored;
+			for( uint32_t index { 0 }; index < physical_devices.size(); ++index )
+			{
+				const auto& physical_device { physical_devices[index] };
+				const auto type { physical_device.getProperties().deviceType };
+				if( !selection.types.empty() && std::ranges::find( selection.types, type ) == selection.types.cend() )
+					continue;
+
+				if( const uint64_t score { device_score( physical_device ) }; score > 0 )
+					scored.emplace_back( score, index );
+			}
+
+			// stable so equal devices keep their enumeration order
+			std::ranges::stable_sort( scored, std::greater {}, &std::pair<uint64_t, uint32_t>::first );
+
+			std::vector<uint32_t> ranked;
+			ranked.reserve( scored.size() );
+			for( const auto& entry : scored )
+				ranked.emplace_back( entry.second );
+
+			return ranked;
+		}
+
+		vk::raii::PhysicalDevice select_physical_device(
+			const vk::raii::Instance& instance,
+			const DeviceSelection& selection )
+		{
+			vk::raii::PhysicalDevices physical_devices( instance );
+
+			if( selection.index )
+			{
+				if( *selection.index >= physical_devices.size() )
+				{
+					std::stringstream msg;
+					msg << "Physical device " << *selection.index << " requested but only "
+						<< physical_devices.size() << " are present.";
+					throw std::out_of_range( msg.str() );
+				}
+				return std::move( physical_devices[*selection.index] );
+			}
+
+			const std::vector<uint32_t> ranked { rank_physical_devices( instance, selection ) };
+			if( ranked.empty() )
+				throw std::runtime_error( "Vulkan couldn't find a compute capable device matching the selection." );
+
+			return std::move( physical_devices[ranked.front()] );
+		}
+
+		// optional device extensions we take advantage of when the driver has them
+		std::vector<const char*> select_device_extensions(
+			const vk::raii::PhysicalDevice& physical_device,
+			const AppInfo& info )
+		{
+			std::vector<const char*> wanted {};
+
+			// needs vkGetPhysicalDeviceMemoryProperties2 (core in 1.1)
+			if( info.apiVersion >= VK_API_VERSION_1_1 )
+				wanted.emplace_back( VK_EXT_MEMORY_BUDGET_EXTENSION_NAME );
+
+			// importing mapped files as buffers (see ImportedBuffer), needs external memory (core in 1.1)
+			if( info.apiVersion >= VK_API_VERSION_1_1 )
+				wanted.emplace_back( VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME );
+
+			// resetting profiler queries on the host (core in 1.2), its feature is queried through vkGetPhysicalDeviceFeatures2
+			if( info.apiVersion >= VK_API_VERSION_1_1 )
+				wanted.emplace_back( VK_EXT_HOST_QUERY_RESET_EXTENSION_NAME );
+
+			const auto available { physical_device.enumerateDeviceExtensionProperties() };
+
+			std::vector<const char*> extentions {};
+			for( const char* name : wanted )
+			{
+				const auto matches {
+					[name]( const vk::ExtensionProperties& ep )
+					{
+						return std::string_view( name ) == ep.extensionName;
+					}
+				};
+				if( std::ranges::any_of( available, matches ) )
+					extentions.emplace_back( name );
+			}
+			return extentions;
+		}
+
+		DeviceFeatures select_device_features(
+			const vk::raii::PhysicalDevice& physical_device,
+			const AppInfo& info,
+			const std::vector<const char*>& extentions )
+		{
+			DeviceFeatures features {};
+
+			features.pipeline_statistics_query = physical_device.getFeatures().pipelineStatisticsQuery == VK_TRUE;
+
+			const uint32_t device_version { physical_device.getProperties().apiVersion };
+			const bool core_1_2 { info.apiVersion >= VK_API_VERSION_1_2 && device_version >= VK_API_VERSION_1_2 };
+			const bool host_query_reset_extension {
+				std::ranges::any_of( extentions,
+					[]( const char* name ) { return std::string_view( name ) == VK_EXT_HOST_QUERY_RESET_EXTENSION_NAME; }
+				)
+			};
+			if( core_1_2 || host_query_reset_extension )
+			{
+				const auto chain {
+					physical_device.getFeatures2
+					<
+						vk::PhysicalDeviceFeatures2,
+						vk::PhysicalDeviceHostQueryResetFeatures
+					>()
+				};
+				features.host_query_reset =
+					chain.get<vk::PhysicalDeviceHostQueryResetFeatures>().hostQueryReset == VK_TRUE;
+			}
+
+			if( core_1_2 )
+			{
+				const auto chain {
+					physical_device.getFeatures2
+					<
+						vk::PhysicalDeviceFeatures2,
+						vk::PhysicalDeviceTimelineSemaphoreFeatures
+					>()
+				};
+				features.timeline_semaphore =
+					chain.get<vk::PhysicalDeviceTimelineSemaphoreFeatures>().timelineSemaphore == VK_TRUE;
+			}
+			return features;
+		}
+
+		std::vector<QueueFamily> select_queue_families(
+			const vk::raii::PhysicalDevice& physical_device,
+			const uint32_t queue_count )
+		{
+			using enum vk::QueueFlagBits;
+
+			const std::vector<vk::QueueFamilyProperties> props {
+				physical_device.getQueueFamilyProperties()
+			};
+
+			// graphics families are compute capable as well, video/sparse-only ones are skipped
+			std::vector<QueueFamily> families;
+			for( uint32_t index { 0 }; index < props.size(); ++index )
+			{
+				const auto flags { props[index].queueFlags };
+				if( !( flags & ( eCompute | eTransfer ) ) )
+					continue;
+
+				const uint32_t available { props[index].queueCount };
+				families.emplace_back(
+					index, flags, queue_count == 0 ? available : std::min( queue_count, available )
+				);
+			}
+			return families;
+		}
+
 		vk::raii::Device create_device(
 			const vk::raii::PhysicalDevice& physical_device,
-			const uint32_t queue_count,
+			const std::vector<QueueFamily>& queue_families,
 			const float queue_priority,
-			const uint32_t queue_family_index )
+			const std::vector<const char*>& extentions,
+			const DeviceFeatures& features )
 		{
-			const vk::DeviceQueueCreateInfo device_queue_ci(
-				{}, queue_family_index, queue_count, &queue_priority
-			);
+			const auto largest {
+				std::ranges::max( queue_families, {}, &QueueFamily::queue_count ).queue_count
+			};
+
+			// one priority per queue, shared by every family
+			const std::vector<float> priorities( largest, queue_priority );
+
+			std::vector<vk::DeviceQueueCreateInfo> device_queue_ci;
+			device_queue_ci.reserve( queue_families.size() );
+			for( const auto& family : queue_families )
+			{
+				device_queue_ci.emplace_back(
+					vk::DeviceQueueCreateFlags {}, family.index, family.queue_count, priorities.data()
+				);
+			}
 
 			std::vector<const char*> layers;
-			std::vector<const char*> extentions { };
 
-			const vk::DeviceCreateInfo device_ci( {}, device_queue_ci, layers, extentions );
+			vk::PhysicalDeviceFeatures core_features {};
+			core_features.pipelineStatisticsQuery = features.pipeline_statistics_query ? VK_TRUE : VK_FALSE;
+
+			vk::StructureChain<
+				vk::DeviceCreateInfo,
+				vk::PhysicalDeviceTimelineSemaphoreFeatures,
+				vk::PhysicalDeviceHostQueryResetFeatures
+			> device_ci(
+				vk::DeviceCreateInfo( {}, device_queue_ci, layers, extentions, &core_features ),
+				vk::PhysicalDeviceTimelineSemaphoreFeatures( VK_TRUE ),
+				vk::PhysicalDeviceHostQueryResetFeatures( VK_TRUE )
+			);
+
+			if( !features.timeline_semaphore )
+				device_ci.unlink<vk::PhysicalDeviceTimelineSemaphoreFeatures>();
+			if( !features.host_query_reset )
+				device_ci.unlink<vk::PhysicalDeviceHostQueryResetFeatures>();
+
+			return vk::raii::Device( physical_device, device_ci.get<vk::DeviceCreateInfo>() );
+		}
+
+		uint32_t query_subgroup_size( const vk::raii::PhysicalDevice& physical_device )
+		{
+			const auto chain {
+				physical_device.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceSubgroupProperties>()
+			};
+			return chain.get<vk::PhysicalDeviceSubgroupProperties>().subgroupSize;
+		}
+
+		bool query_subgroup_arithmetic( const vk::raii::PhysicalDevice& physical_device )
+		{
+			const auto chain {
+				physical_device.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceSubgroupProperties>()
+			};
+			const auto& subgroup { chain.get<vk::PhysicalDeviceSubgroupProperties>() };
+			constexpr vk::SubgroupFeatureFlags required {
+				vk::SubgroupFeatureFlagBits::eBasic | vk::SubgroupFeatureFlagBits::eArithmetic
+			};
+			return ( subgroup.supportedStages & vk::ShaderStageFlagBits::eCompute )
+				&& ( subgroup.supportedOperations & required ) == required;
+		}
+
+		// the header fields are always little-endian, whatever the host is
+		uint32_t read_le32( const uint8_t* bytes ) noexcept
+		{
+			return static_cast< uint32_t >( bytes[0] )
+				| static_cast< uint32_t >( bytes[1] ) << 8
+				| static_cast< uint32_t >( bytes[2] ) << 16
+				| static_cast< uint32_t >( bytes[3] ) << 24;
+		}
+
+		/* Checks the VkPipelineCacheHeaderVersionOne at the start of a blob.
+			Drivers are supposed to reject foreign data themselves but not all
+			of them do, and a cache from another driver version is useless anyway.*/
+		bool pipeline_cache_matches(
+			const std::vector<uint8_t>& data,
+			const vk::PhysicalDeviceProperties& properties )
+		{
+			constexpr std::size_t header_size { 4 * sizeof( uint32_t ) + VK_UUID_SIZE };
+			if( data.size() < header_size )
+				return false;
+
+			const uint8_t* header { data.data() };
+			return read_le32( header ) >= header_size
+				&& read_le32( header + 4 ) == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+				&& read_le32( header + 8 ) == properties.vendorID
+				&& read_le32( header + 12 ) == properties.deviceID
+				&& std::memcmp( header + 16, properties.pipelineCacheUUID.data(), VK_UUID_SIZE ) == 0;
+		}
+
+		// empty if there is no file or it was written by another device/driver
+		std::vector<uint8_t> read_pipeline_cache(
+			const std::filesystem::path& path,
+			const vk::PhysicalDeviceProperties& properties )
+		{
+			if( path.empty() )
+				return {};
+
+			std::ifstream file( path, std::ios::binary );
+			if( !file )
+				return {};
+
+			std::vector<uint8_t> data(
+				( std::istreambuf_iterator<char>( file ) ),
+				std::istreambuf_iterator<char>()
+			);
 
-			return vk::raii::Device( physical_device, device_ci );
+			if( !pipeline_cache_matches( data, properties ) )
+			{
+				std::cerr << "\n\tIgnoring pipeline cache " << path << " from another device or driver." << std::endl;
+				return {};
+			}
+			return data;
+		}
+
+		vk::raii::PipelineCache create_pipeline_cache(
+			const vk::raii::Device& device,
+			const std::vector<uint8_t>& data )
+		{
+			const vk::PipelineCacheCreateInfo ci( {}, data.size(), data.data() );
+			return vk::raii::PipelineCache( device, ci );
 		}
 	} // namespace internal
 
@@ -68,13 +438,75 @@ namespace fgl::vulkan
 		:
 		context {},
 		instance( internal::create_instance( context, info ) ),
-		physical_device( std::move( vk::raii::PhysicalDevices( instance ).front() ) ),
+		physical_device( internal::select_physical_device( instance, info.device_selection ) ),
 		queue_family_index( index_of_first_queue_family( vk::QueueFlagBits::eCompute ) ),
-		device( internal::create_device( physical_device, info.queue_count, info.queue_priority, queue_family_index ) ),
+		transfer_queue_family_index( index_of_transfer_queue_family() ),
+		queue_families( internal::select_queue_families( physical_device, info.queue_count ) ),
+		device_extensions( internal::select_device_extensions( physical_device, info ) ),
+		features( internal::select_device_features( physical_device, info, device_extensions ) ),
+		device( internal::create_device( physical_device, queue_families, info.queue_priority, device_extensions, features ) ),
 		properties( physical_device.getProperties() ),
-		version_info( context.enumerateInstanceVersion(), info.apiVersion )
+		subgroup_size( internal::query_subgroup_size( physical_device ) ),
+		subgroup_arithmetic( internal::query_subgroup_arithmetic( physical_device ) ),
+		version_info( context.enumerateInstanceVersion(), info.apiVersion ),
+		arena(
+			std::make_unique<MemoryArena>(
+				device,
+				physical_device,
+				has_device_extension( VK_EXT_MEMORY_BUDGET_EXTENSION_NAME )
+			)
+		),
+		pipeline_cache_path( info.pipeline_cache_path ),
+		pipeline_cache(
+			internal::create_pipeline_cache(
+				device,
+				internal::read_pipeline_cache( pipeline_cache_path, properties )
+			)
+		)
 	{}
 
+	std::vector<uint32_t> rank_physical_devices( const AppInfo& info )
+	{
+		const vk::raii::Context context {};
+		const vk::raii::Instance instance { internal::create_instance( context, info ) };
+		return internal::rank_physical_devices( instance, info.device_selection );
+	}
+
+	Context::~Context()
+	{
+		try
+		{
+			save_pipeline_cache();
+		}
+		catch( const std::exception& e )
+		{
+			std::cerr << "\n\tFailed to save the pipeline cache: " << e.what() << std::endl;
+		}
+	}
+
+	void Context::save_pipeline_cache() const
+	{
+		if( pipeline_cache_path.empty() )
+			return;
+
+		const std::vector<uint8_t> on_disk {
+			internal::read_pipeline_cache( pipeline_cache_path, properties )
+		};
+
+		if( on_disk.empty() )
+		{
+			const std::vector<uint8_t> data { pipeline_cache.getData() };
+			internal::write_atomically( pipeline_cache_path, std::as_bytes( std::span( data ) ) );
+			return;
+		}
+
+		// merge into a copy of the file so our own cache is left alone for running pipelines
+		const vk::raii::PipelineCache merged { internal::create_pipeline_cache( device, on_disk ) };
+		merged.merge( *pipeline_cache );
+		const std::vector<uint8_t> data { merged.getData() };
+		internal::write_atomically( pipeline_cache_path, std::as_bytes( std::span( data ) ) );
+	}
+
 	/// INFO PRINTING
 
 	namespace internal::properties_output
@@ -187,15 +619,34 @@ namespace fgl::vulkan
 
 		std::cout
 			<< "\n\tDevice Name: " << properties.deviceName
+			<< "\n\tDevice Type: " << vk::to_string( properties.deviceType )
 			<< "\n\tMinimum required Vulkan API v" << target_version
 			<< "\n\tDetected running Vulkan API v" << loaded_version
 			<< "\n\tHas support for  Vulkan API v" << device_version
 			<< "\n\tMax Compute Shared Memory Size: "
 			<< properties.limits.maxComputeSharedMemorySize / 1024 << " KB"
+			<< "\n\tSubgroup Size: " << subgroup_size
+			<< ( subgroup_arithmetic ? " (arithmetic)" : " (no arithmetic)" )
+			<< "\n\tMax Compute Workgroup Invocations: "
+			<< properties.limits.maxComputeWorkGroupInvocations
 			<< "\n\tCompute Queue Family Index: "
 			<< queue_family_index
+			<< "\n\tTransfer Queue Family Index: "
+			<< transfer_queue_family_index
+			<< "\n\tPipeline Cache: "
+			<< ( pipeline_cache_path.empty() ? std::string( "in memory" ) : pipeline_cache_path.string() )
+			<< " (" << pipeline_cache.getData().size() << " bytes)"
 			<< std::endl;
 
+		for( const auto& family : queue_families )
+		{
+			std::cout
+				<< "\tQueue Family " << family.index
+				<< ": " << family.queue_count << " queue(s), "
+				<< vk::to_string( family.flags )
+				<< std::endl;
+		}
+
 		using namespace internal::properties_output;
 
 		std::vector<vk::ExtensionProperties> extensionProperties {
@@ -256,7 +707,18 @@ namespace fgl::vulkan
 
 		std::cout
 			<< "\n\tMax Compute Inovactions: "
-			<< properties.limits.maxComputeWorkGroupInvocations
-			<< std::endl;
+			<< properties.limits.maxComputeWorkGroupInvocations;
+
+		const auto memory_properties { physical_device.getMemoryProperties() };
+		for( uint32_t index { 0 }; index < memory_properties.memoryHeapCount; ++index )
+		{
+			const auto heap { arena->heap_budget( index ) };
+			std::cout
+				<< "\n\tMemory Heap " << index << ": "
+				<< heap.size / ( 1024 * 1024 ) << " MB"
+				<< " [BUDGET]=" << heap.budget / ( 1024 * 1024 ) << " MB"
+				<< " [USAGE]=" << heap.usage / ( 1024 * 1024 ) << " MB";
+		}
+		std::cout << std::endl;
 	}
 }
@@ -0,0 +1,166 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include <fgl/vulkan/descriptors.hpp>
+
+namespace fgl::vulkan
+{
+
+	vk::DeviceSize dynamic_offset_alignment(
+		const Context& context,
+		const vk::DescriptorType type )
+	{
+		const auto& limits { context.properties.limits };
+		if( type == vk::DescriptorType::eStorageBufferDynamic )
+			return limits.minStorageBufferOffsetAlignment;
+		else if( type == vk::DescriptorType::eUniformBufferDynamic )
+			return limits.minUniformBufferOffsetAlignment;
+
+		throw std::invalid_argument( "Only dynamic buffer descriptors take dynamic offsets." );
+	}
+
+	vk::DeviceSize dynamic_slice_stride(
+		const Context& context,
+		const vk::DescriptorType type,
+		const vk::DeviceSize slice_size )
+	{
+		const auto alignment { dynamic_offset_alignment( context, type ) };
+		return ( slice_size + alignment - 1 ) / alignment * alignment;
+	}
+
+	/// DESCRIPTOR ALLOCATOR
+
+	DescriptorAllocator::DescriptorAllocator(
+		const Context& context,
+		const uint32_t sets_per_pool,
+		const std::span<const PoolRatio> ratios_ )
+		:
+		device( context.device ),
+		ratios( ratios_.begin(), ratios_.end() ),
+		next_pool_sets( std::clamp( sets_per_pool, 1u, max_sets_per_pool ) )
+	{}
+
+	void DescriptorAllocator::add_pool()
+	{
+		std::vector<vk::DescriptorPoolSize> sizes;
+		sizes.reserve( ratios.size() );
+		for( const auto& [type, per_set] : ratios )
+		{
+			const auto count { static_cast< uint32_t >( std::ceil( per_set * static_cast< float >( next_pool_sets ) ) ) };
+			sizes.emplace_back( type, std::max( count, 1u ) );
+		}
+
+		// no eFreeDescriptorSet: sets only ever go back through reset()
+		pools.emplace_back( device, vk::DescriptorPoolCreateInfo( {}, next_pool_sets, sizes ) );
+		current = pools.size() - 1;
+		next_pool_sets = std::min( next_pool_sets * 2, max_sets_per_pool );
+	}
+
+	vk::DescriptorSet DescriptorAllocator::allocate( const vk::DescriptorSetLayout layout )
+	{
+		// try the current pool and any later one left over from before a reset
+		for( ; current < pools.size(); ++current )
+		{
+			try
+			{
+				vk::raii::DescriptorSets allocated(
+					device, vk::DescriptorSetAllocateInfo( *pools[current], layout )
+				);
+				return allocated.front().release(); // owned by the pool from here on
+			}
+			catch( const vk::OutOfPoolMemoryError& )
+			{}
+			catch( const vk::FragmentedPoolError& )
+			{}
+		}
+
+		add_pool();
+		vk::raii::DescriptorSets allocated(
+			device, vk::DescriptorSetAllocateInfo( *pools[current], layout )
+		);
+		return allocated.front().release();
+	}
+
+	void DescriptorAllocator::reset()
+	{
+		for( const auto& pool : pools )
+			pool.reset();
+
+		current = 0;
+	}
+
+	/// DESCRIPTOR SET CACHE
+
+	DescriptorSetCache::DescriptorSetCache(
+		const Context& context,
+		const uint32_t sets_per_pool )
+		:
+		device( context.device ),
+		allocator( context, sets_per_pool )
+	{}
+
+	vk::DescriptorSet DescriptorSetCache::get(
+		const Pipeline& pipeline,
+		const std::span<const BufferBinding> bindings )
+	{
+		Key key { *pipeline.descriptor_set_layouts, std::vector<BufferBinding>( bindings.begin(), bindings.end() ) };
+
+		std::scoped_lock lock( mutex );
+		if( const auto it { sets.find( key ) }; it != sets.cend() )
+			return it->second;
+
+		const vk::DescriptorSet set { allocator.allocate( key.first ) };
+
+		std::vector<vk::DescriptorBufferInfo> buffer_infos;
+		buffer_infos.reserve( bindings.size() );
+		for( const auto& binding : bindings )
+			buffer_infos.emplace_back( binding.buffer, binding.offset, binding.range );
+
+		constexpr uint32_t array_element { 0 };
+		constexpr uint32_t descriptor_count { 1 };
+		std::vector<vk::WriteDescriptorSet> writes;
+		writes.reserve( bindings.size() );
+		for( std::size_t i { 0 }; i < bindings.size(); ++i )
+		{
+			writes.emplace_back(
+				set, bindings[i].binding, array_element, descriptor_count,
+				bindings[i].type, nullptr, &buffer_infos[i]
+			);
+		}
+		device.updateDescriptorSets( writes, nullptr );
+
+		sets.emplace( std::move( key ), set );
+		return set;
+	}
+
+	void DescriptorSetCache::evict( const vk::Buffer buffer )
+	{
+		std::scoped_lock lock( mutex );
+		std::erase_if( sets,
+			[buffer]( const auto& entry )
+			{
+				return std::ranges::any_of( entry.first.second,
+					[buffer]( const BufferBinding& binding ) { return binding.buffer == buffer; }
+				);
+			}
+		);
+	}
+
+	void DescriptorSetCache::clear()
+	{
+		std::scoped_lock lock( mutex );
+		sets.clear();
+		allocator.reset();
+	}
+
+	std::size_t DescriptorSetCache::size()
+	{
+		std::scoped_lock lock( mutex );
+		return sets.size();
+	}
+
+}
@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <functional> // greater
+#include <future>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include <fgl/vulkan/device_group.hpp>
+
+namespace fgl::vulkan
+{
+
+	namespace internal
+	{
+		std::size_t group_size(
+			const AppInfo& info,
+			const uint32_t max_devices,
+			const uint32_t contexts_per_device )
+		{
+			const std::size_t devices { rank_physical_devices( info ).size() };
+			const std::size_t used { max_devices == 0 ? devices : std::min<std::size_t>( devices, max_devices ) };
+			return used * std::max( contexts_per_device, 1u );
+		}
+	} // namespace internal
+
+	DeviceGroup::DeviceGroup(
+		const AppInfo& info,
+		const uint32_t max_devices,
+		const uint32_t contexts_per_device )
+		:
+		pool( std::max<std::size_t>( internal::group_size( info, max_devices, contexts_per_device ), 1 ) )
+	{
+		std::vector<uint32_t> ranked { rank_physical_devices( info ) };
+		if( ranked.empty() )
+			throw std::runtime_error( "DeviceGroup: Vulkan couldn't find a compute capable device matching the selection." );
+
+		if( max_devices != 0 && ranked.size() > max_devices )
+			ranked.resize( max_devices );
+
+		for( const uint32_t index : ranked )
+		{
+			AppInfo device_info { info };
+			device_info.device_selection.index = index;
+
+			for( uint32_t copy { 0 }; copy < std::max( contexts_per_device, 1u ); ++copy )
+			{
+				auto context { std::make_unique<Context>( device_info ) };
+				auto scheduler { std::make_unique<QueueScheduler>( *context ) };
+				members.emplace_back( std::move( context ), std::move( scheduler ) );
+			}
+		}
+	}
+
+	const Context& DeviceGroup::context( const std::size_t device ) const
+	{
+		return *members.at( device ).context;
+	}
+
+	QueueScheduler& DeviceGroup::scheduler( const std::size_t device ) const
+	{
+		return *members.at( device ).scheduler;
+	}
+
+	double DeviceGroup::throughput( const std::size_t device ) const
+	{
+		return members.at( device ).throughput;
+	}
+
+	void DeviceGroup::set_throughput( const std::size_t device, const double units_per_second )
+	{
+		if( !( units_per_second > 0.0 ) )
+		{
+			std::stringstream msg;
+			msg << "DeviceGroup: throughput of device " << device << " must be positive, got " << units_per_second;
+			throw std::invalid_argument( msg.str() );
+		}
+		members.at( device ).throughput = units_per_second;
+	}
+
+	std::vector<double> DeviceGroup::weights() const
+	{
+		double measured_sum { 0.0 };
+		std::size_t measured { 0 };
+		for( const auto& member : members )
+		{
+			if( member.throughput > 0.0 )
+			{
+				measured_sum += member.throughput;
+				++measured;
+			}
+		}
+		const double fallback { measured == 0 ? 1.0 : measured_sum / static_cast< double >( measured ) };
+
+		std::vector<double> result;
+		result.reserve( members.size() );
+		for( const auto& member : members )
+			result.emplace_back( member.throughput > 0.0 ? member.throughput : fallback );
+
+		return result;
+	}
+
+	std::vector<DeviceGroup::Slice> DeviceGroup::partition(
+		const uint32_t extent,
+		const uint32_t granularity ) const
+	{
+		if( granularity == 0 )
+			throw std::invalid_argument( "DeviceGroup: partition granularity must be at least 1." );
+
+		if( extent == 0 )
+			return {};
+
+		// shares are handed out in whole chunks, the last one possibly ragged
+		const uint64_t chunks { ( uint64_t( extent ) + granularity - 1 ) / granularity };
+		const std::vector<double> weight { weights() };
+		const double total { std::accumulate( weight.cbegin(), weight.cend(), 0.0 ) };
+
+		// largest remainder, so the shares add up to chunks exactly
+		std::vector<uint64_t> shares( members.size() );
+		std::vector<std::pair<double, std::size_t>> remainders;
+		uint64_t assigned { 0 };
+		for( std::size_t device { 0 }; device < members.size(); ++device )
+		{
+			const double exact { static_cast< double >( chunks ) * weight[device] / total };
+			shares[device] = static_cast< uint64_t >( std::floor( exact ) );
+			assigned += shares[device];
+			remainders.emplace_back( exact - std::floor( exact ), device );
+		}
+		std::ranges::stable_sort( remainders, std::greater {}, &std::pair<double, std::size_t>::first );
+		for( std::size_t i { 0 }; assigned < chunks; ++i, ++assigned )
+			++shares[remainders[i % remainders.size()].second];
+
+		std::vector<Slice> slices;
+		uint64_t first { 0 };
+		for( std::size_t device { 0 }; device < members.size(); ++device )
+		{
+			if( shares[device] == 0 )
+				continue;
+
+			const uint64_t count { std::min<uint64_t>( shares[device] * granularity, extent - first ) };
+			slices.emplace_back( device, static_cast< uint32_t >( first ), static_cast< uint32_t >( count ) );
+			first += count;
+		}
+		return slices;
+	}
+
+	std::vector<DeviceGroup::Slice> DeviceGroup::run(
+		const uint32_t extent,
+		const SliceJob& job,
+		const uint32_t granularity )
+	{
+		const std::vector<Slice> slices { partition( extent, granularity ) };
+
+		std::vector<std::future<std::chrono::duration<double>>> futures;
+		futures.reserve( slices.size() );
+		for( const Slice& slice : slices )
+		{
+			futures.emplace_back(
+				pool.submit(
+					[this, &job, slice]()
+					{
+						const Member& member { members[slice.device] };
+						const auto start { std::chrono::steady_clock::now() };
+						job( slice, *member.context, *member.scheduler );
+						return std::chrono::duration<double>( std::chrono::steady_clock::now() - start );
+					}
+				)
+			);
+		}
+
+		// every job has to finish before the first error propagates, they reference job and slices
+		std::exception_ptr error {};
+		for( std::size_t i { 0 }; i < futures.size(); ++i )
+		{
+			try
+			{
+				const double seconds { futures[i].get().count() };
+				if( seconds <= 0.0 )
+					continue;
+
+				double& estimate { members[slices[i].device].throughput };
+				const double measured { slices[i].count / seconds };
+				estimate = estimate > 0.0 ? smoothing * measured + ( 1.0 - smoothing ) * estimate : measured;
+			}
+			catch( ... )
+			{
+				if( !error )
+					error = std::current_exception();
+			}
+		}
+		if( error )
+			std::rethrow_exception( error );
+
+		return slices;
+	}
+
+	void DeviceGroup::print_devices() const
+	{
+		for( std::size_t device { 0 }; device < members.size(); ++device )
+		{
+			const Member& member { members[device] };
+			std::cout
+				<< "\tDevice " << device
+				<< ": " << member.context->properties.deviceName
+				<< " (" << vk::to_string( member.context->properties.deviceType ) << ")"
+				<< ", " << member.scheduler->lane_count() << " lane(s), ";
+			if( member.throughput > 0.0 )
+				std::cout << member.throughput << " units/s";
+			else
+				std::cout << "not measured";
+			std::cout << std::endl;
+		}
+	}
+
+}
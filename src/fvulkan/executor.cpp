@@ -0,0 +1,305 @@
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <tuple> // ignore
+#include <utility> // move
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include <fgl/vulkan/executor.hpp>
+
+namespace fgl::vulkan
+{
+
+	namespace internal
+	{
+		// what recording would only find out on the submitter thread, failing the whole batch
+		void check_compute_job( const ComputeJob& job )
+		{
+			if( job.pipeline == nullptr )
+				throw std::invalid_argument( "ComputeJob without a pipeline." );
+
+			if( job.push_constants.size() > job.pipeline->push_constant_size )
+				throw std::length_error( "Push constants exceed the pipeline's push constant range." );
+		}
+	} // namespace internal
+
+	Executor::Executor(
+		const Context& context,
+		const ExecutorOptions& options,
+		const uint32_t queue_index )
+		:
+		max_jobs_per_batch( std::max<std::size_t>( options.max_jobs_per_batch, 1 ) ),
+		max_in_flight( std::max<std::size_t>( options.max_in_flight, 1 ) ),
+		memory_budget( options.memory_budget ),
+		sets( context ),
+		command_buffers( context, context.queue_family_index ),
+		queue( context, context.queue_family_index, queue_index ),
+		submitter( &Executor::submit_loop, this )
+	{}
+
+	Executor::~Executor()
+	{
+		stopping.store( true, std::memory_order_release );
+		signals.fetch_add( 1, std::memory_order_release );
+		signals.notify_one();
+		submitter.join();
+
+		// the AsyncQueue drains itself, completing the last batches
+	}
+
+	bool Executor::try_reserve( const vk::DeviceSize bytes, uint64_t& observed )
+	{
+		if( memory_budget == 0 )
+		{
+			reserved_bytes.fetch_add( bytes, std::memory_order_relaxed );
+			return true;
+		}
+
+		observed = reserved_bytes.load( std::memory_order_relaxed );
+
+		// a job larger than the whole budget gets it to itself
+		while( observed == 0 || ( observed <= memory_budget && bytes <= memory_budget - observed ) )
+		{
+			if( reserved_bytes.compare_exchange_weak( observed, observed + bytes, std::memory_order_acq_rel, std::memory_order_relaxed ) )
+				return true;
+		}
+		return false;
+	}
+
+	void Executor::reserve( const vk::DeviceSize bytes )
+	{
+		for( uint64_t observed { 0 }; !try_reserve( bytes, observed ); )
+			reserved_bytes.wait( observed, std::memory_order_acquire );
+	}
+
+	void Executor::release( const vk::DeviceSize bytes )
+	{
+		if( bytes == 0 )
+			return;
+
+		reserved_bytes.fetch_sub( bytes, std::memory_order_release );
+		reserved_bytes.notify_all();
+	}
+
+	std::future<void> Executor::enqueue( ComputeJob&& job, std::function<void()>&& on_complete )
+	{
+		const vk::DeviceSize bytes { job.memory_bytes };
+		Queued queued { std::move( job ), std::move( on_complete ), {} };
+		auto future { queued.promise.get_future() };
+
+		try
+		{
+			queued_jobs.push( std::move( queued ) );
+		}
+		catch( ... )
+		{
+			release( bytes );
+			throw;
+		}
+		accepted.fetch_add( 1, std::memory_order_relaxed );
+
+		// after the push, so a submitter that saw the old value finds the job
+		signals.fetch_add( 1, std::memory_order_release );
+		signals.notify_one();
+
+		return future;
+	}
+
+	std::future<void> Executor::submit(
+		ComputeJob&& job,
+		std::function<void()> on_complete )
+	{
+		internal::check_compute_job( job );
+		reserve( job.memory_bytes );
+		return enqueue( std::move( job ), std::move( on_complete ) );
+	}
+
+	std::optional<std::future<void>> Executor::try_submit(
+		ComputeJob& job,
+		std::function<void()> on_complete )
+	{
+		internal::check_compute_job( job );
+
+		uint64_t observed { 0 };
+		if( !try_reserve( job.memory_bytes, observed ) )
+		{
+			declined_count.fetch_add( 1, std::memory_order_relaxed );
+			return std::nullopt;
+		}
+		return enqueue( std::move( job ), std::move( on_complete ) );
+	}
+
+	void Executor::wait_idle()
+	{
+		const uint64_t target { accepted.load( std::memory_order_relaxed ) };
+		for( uint64_t done { completed.load( std::memory_order_acquire ) }; done < target; done = completed.load( std::memory_order_acquire ) )
+			completed.wait( done, std::memory_order_acquire );
+	}
+
+	void Executor::evict( const Buffer& buffer )
+	{
+		sets.evict( *buffer.buffer );
+	}
+
+	Executor::Statistics Executor::statistics() const noexcept
+	{
+		return {
+			completed.load( std::memory_order_relaxed ),
+			batch_count.load( std::memory_order_relaxed ),
+			barrier_count.load( std::memory_order_relaxed ),
+			declined_count.load( std::memory_order_relaxed )
+		};
+	}
+
+	void Executor::submit_loop()
+	{
+		std::vector<Queued> batch;
+		while( true )
+		{
+			// read before looking, so a push landing after the last pop() changes it
+			const uint64_t seen { signals.load( std::memory_order_acquire ) };
+
+			// throttled before collecting, so jobs keep coalescing in the queue meanwhile
+			for( uint64_t flying { in_flight.load( std::memory_order_acquire ) }; flying >= max_in_flight; flying = in_flight.load( std::memory_order_acquire ) )
+				in_flight.wait( flying, std::memory_order_acquire );
+
+			while( batch.size() < max_jobs_per_batch )
+			{
+				auto queued { queued_jobs.pop() };
+				if( !queued )
+					break;
+				batch.emplace_back( std::move( *queued ) );
+			}
+
+			if( !batch.empty() )
+			{
+				flush( batch );
+				continue;
+			}
+
+			if( stopping.load( std::memory_order_acquire ) )
+				return;
+
+			signals.wait( seen, std::memory_order_acquire );
+		}
+	}
+
+	void Executor::flush( std::vector<Queued>& batch )
+	{
+		// shared so the completion callback stays copyable for std::function
+		const auto pending { std::make_shared<std::vector<Queued>>( std::move( batch ) ) };
+		const auto buffer { std::make_shared<vk::raii::CommandBuffer>( command_buffers.acquire() ) };
+		batch.clear();
+
+		try
+		{
+			buffer->begin( vk::CommandBufferBeginInfo( vk::CommandBufferUsageFlagBits::eOneTimeSubmit ) );
+
+			// earlier batches may still be writing what this one touches
+			const vk::MemoryBarrier before(
+				vk::AccessFlagBits::eShaderWrite,
+				vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite
+			);
+			buffer->pipelineBarrier(
+				vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, {}, before, nullptr, nullptr
+			);
+
+			DispatchRecorder recorder( *buffer );
+			std::vector<BufferBinding> bindings;
+			for( const Queued& queued : *pending )
+			{
+				const ComputeJob& job { queued.job };
+
+				bindings.clear();
+				for( const auto& [accessed, access] : job.buffers )
+					bindings.push_back( { accessed->binding, accessed->buffer_type, *accessed->buffer } );
+
+				recorder.dispatch(
+					*job.pipeline,
+					sets.get( *job.pipeline, bindings ),
+					job.buffers,
+					job.groups[0],
+					job.groups[1],
+					job.groups[2],
+					job.push_constants
+				);
+			}
+
+			const vk::MemoryBarrier after(
+				vk::AccessFlagBits::eShaderWrite,
+				vk::AccessFlagBits::eHostRead | vk::AccessFlagBits::eTransferRead
+			);
+			buffer->pipelineBarrier(
+				vk::PipelineStageFlagBits::eComputeShader,
+				vk::PipelineStageFlagBits::eHost | vk::PipelineStageFlagBits::eTransfer,
+				{},
+				after,
+				nullptr,
+				nullptr
+			);
+			buffer->end();
+
+			barrier_count.fetch_add( recorder.barriers(), std::memory_order_relaxed );
+			batch_count.fetch_add( 1, std::memory_order_relaxed );
+
+			in_flight.fetch_add( 1, std::memory_order_relaxed );
+			try
+			{
+				// every job has its own promise, so AsyncQueue's future isn't needed
+				std::ignore = queue.submit(
+					*buffer,
+					[this, pending, buffer]
+					{
+						complete( *pending, *buffer, {} );
+						in_flight.fetch_sub( 1, std::memory_order_release );
+						in_flight.notify_one();
+					}
+				);
+			}
+			catch( ... )
+			{
+				in_flight.fetch_sub( 1, std::memory_order_relaxed );
+				throw;
+			}
+		}
+		catch( ... )
+		{
+			complete( *pending, *buffer, std::current_exception() );
+		}
+	}
+
+	void Executor::complete(
+		std::vector<Queued>& finished,
+		vk::raii::CommandBuffer& buffer,
+		const std::exception_ptr& error )
+	{
+		command_buffers.recycle_concurrently( std::move( buffer ) );
+
+		for( Queued& queued : finished )
+		{
+			release( queued.job.memory_bytes );
+
+			if( error )
+			{
+				queued.promise.set_exception( error );
+				continue;
+			}
+
+			try
+			{
+				if( queued.on_complete )
+					queued.on_complete();
+				queued.promise.set_value();
+			}
+			catch( ... )
+			{
+				queued.promise.set_exception( std::current_exception() );
+			}
+		}
+
+		completed.fetch_add( finished.size(), std::memory_order_release );
+		completed.notify_all();
+	}
+
+}
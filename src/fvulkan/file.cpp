@@ -0,0 +1,38 @@
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include <fgl/vulkan/internal/file.hpp>
+
+namespace fgl::vulkan::internal
+{
+
+	void write_atomically( const std::filesystem::path& path, const std::span<const std::byte> data )
+	{
+		if( path.has_parent_path() )
+			std::filesystem::create_directories( path.parent_path() );
+
+		// unique per writer so concurrent processes don't share a temp file
+		std::filesystem::path temporary { path };
+		temporary += "." + std::to_string( std::random_device {}() ) + ".tmp";
+
+		{
+			std::ofstream file( temporary, std::ios::binary | std::ios::trunc );
+			file.write( reinterpret_cast< const char* >( data.data() ), static_cast< std::streamsize >( data.size() ) );
+			file.close();
+
+			if( !file )
+			{
+				std::filesystem::remove( temporary );
+				std::stringstream ss;
+				ss << "Failed to write " << temporary;
+				throw std::runtime_error( ss.str() );
+			}
+		}
+
+		std::filesystem::rename( temporary, path );
+	}
+
+} // namespace fgl::vulkan::internal
@@ -0,0 +1,488 @@
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <tuple> // ignore
+#include <utility> // move
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include <fgl/vulkan/frame_ring.hpp>
+
+namespace fgl::vulkan
+{
+
+	namespace internal
+	{
+		constexpr uint64_t frame_no_timeout { std::numeric_limits<uint64_t>::max() };
+		constexpr std::size_t no_staging { std::numeric_limits<std::size_t>::max() };
+
+		bool frame_uploads( const FrameTransfer transfer )
+		{
+			return transfer == FrameTransfer::eUpload || transfer == FrameTransfer::eUploadDownload;
+		}
+
+		bool frame_downloads( const FrameTransfer transfer )
+		{
+			return transfer == FrameTransfer::eDownload || transfer == FrameTransfer::eUploadDownload;
+		}
+
+		// the frame's descriptor sets bind every buffer whole without offsets, so no dynamic types
+		void check_frame_buffer( const Context& context, const FrameBufferInfo& info )
+		{
+			if( info.bytes == 0 )
+				throw std::invalid_argument( "FrameRing: buffers need at least one byte." );
+
+			vk::DeviceSize range { 0 };
+			if( info.type == vk::DescriptorType::eStorageBuffer )
+				range = context.properties.limits.maxStorageBufferRange;
+			else if( info.type == vk::DescriptorType::eUniformBuffer )
+				range = context.properties.limits.maxUniformBufferRange;
+			else
+				throw std::invalid_argument( "FrameRing: only storage and uniform buffers can be bound to a frame." );
+
+			if( info.bytes > range )
+			{
+				std::stringstream msg;
+				msg << "FrameRing: a buffer of " << info.bytes << " bytes at binding " << info.binding
+					<< " exceeds the device's descriptor range (" << range << " bytes).";
+				throw std::length_error( msg.str() );
+			}
+		}
+
+		vk::BufferUsageFlags frame_buffer_usage( const FrameBufferInfo& info )
+		{
+			vk::BufferUsageFlags usage {
+				info.type == vk::DescriptorType::eUniformBuffer ? vk::BufferUsageFlagBits::eUniformBuffer : vk::BufferUsageFlagBits::eStorageBuffer
+			};
+			if( frame_uploads( info.transfer ) )
+				usage |= vk::BufferUsageFlagBits::eTransferDst;
+			if( frame_downloads( info.transfer ) )
+				usage |= vk::BufferUsageFlagBits::eTransferSrc;
+			return usage;
+		}
+
+		// uploads are only written by the host, readbacks read, flushed and invalidated explicitly
+		Buffer create_frame_staging( const Context& context, const vk::DeviceSize bytes, const bool upload )
+		{
+			return Buffer(
+				context,
+				bytes,
+				upload ? vk::BufferUsageFlagBits::eTransferSrc : vk::BufferUsageFlagBits::eTransferDst,
+				vk::SharingMode::eExclusive,
+				0, // not bound to a descriptor
+				vk::MemoryPropertyFlagBits::eHostVisible,
+				vk::DescriptorType::eStorageBuffer,
+				upload ? vk::MemoryPropertyFlags() : vk::MemoryPropertyFlags( vk::MemoryPropertyFlagBits::eHostCached )
+			);
+		}
+
+		// timeline semaphores when the device has them, binary ones (which ignore the values) otherwise
+		vk::raii::Semaphore create_frame_semaphore( const Context& context )
+		{
+			if( !context.features.timeline_semaphore )
+				return vk::raii::Semaphore( context.device, vk::SemaphoreCreateInfo() );
+
+			constexpr uint64_t initial_value { 0 };
+			const vk::StructureChain<vk::SemaphoreCreateInfo, vk::SemaphoreTypeCreateInfo> ci(
+				vk::SemaphoreCreateInfo(),
+				vk::SemaphoreTypeCreateInfo( vk::SemaphoreType::eTimeline, initial_value )
+			);
+			return vk::raii::Semaphore( context.device, ci.get<vk::SemaphoreCreateInfo>() );
+		}
+
+		/* Releases (from the first family) or acquires (into the second) a
+			frame buffer; the access on the other side of the transfer is
+			ignored, the semaphore between the two submissions orders them.*/
+		vk::BufferMemoryBarrier frame_ownership(
+			const Buffer& buffer,
+			const vk::AccessFlags source_access,
+			const vk::AccessFlags destination_access,
+			const uint32_t source_family,
+			const uint32_t destination_family )
+		{
+			return vk::BufferMemoryBarrier(
+				source_access, destination_access,
+				source_family, destination_family,
+				*buffer.buffer, 0, VK_WHOLE_SIZE
+			);
+		}
+	} // namespace internal
+
+	/// FRAME
+
+	FrameRing::Frame::Frame(
+		const Context& context,
+		const std::span<const FrameBufferInfo> layout,
+		const std::size_t slot_,
+		vk::raii::CommandBuffer&& upload_commands_,
+		vk::raii::CommandBuffer&& command_buffer_,
+		vk::raii::CommandBuffer&& readback_commands_ )
+		:
+		slot( slot_ ),
+		upload_commands( std::move( upload_commands_ ) ),
+		command_buffer( std::move( command_buffer_ ) ),
+		readback_commands( std::move( readback_commands_ ) ),
+		uploaded( internal::create_frame_semaphore( context ) ),
+		computed( internal::create_frame_semaphore( context ) ),
+		fence( context.device, vk::FenceCreateInfo() )
+	{
+		buffers.reserve( layout.size() );
+		upload_index.reserve( layout.size() );
+		readback_index.reserve( layout.size() );
+		for( const FrameBufferInfo& info : layout )
+		{
+			buffers.emplace_back(
+				context,
+				info.bytes,
+				internal::frame_buffer_usage( info ),
+				vk::SharingMode::eExclusive,
+				info.binding,
+				vk::MemoryPropertyFlagBits::eDeviceLocal,
+				info.type
+			);
+
+			upload_index.push_back( internal::frame_uploads( info.transfer ) ? staging.size() : internal::no_staging );
+			if( internal::frame_uploads( info.transfer ) )
+				staging.emplace_back( internal::create_frame_staging( context, info.bytes, true ) );
+
+			readback_index.push_back( internal::frame_downloads( info.transfer ) ? staging.size() : internal::no_staging );
+			if( internal::frame_downloads( info.transfer ) )
+				staging.emplace_back( internal::create_frame_staging( context, info.bytes, false ) );
+		}
+	}
+
+	const Buffer& FrameRing::Frame::staging_for( const std::size_t buffer, const bool upload ) const
+	{
+		const std::vector<std::size_t>& index { upload ? upload_index : readback_index };
+		if( buffer >= index.size() )
+			throw std::out_of_range( "FrameRing: no such buffer in the frame." );
+
+		if( index[buffer] == internal::no_staging )
+			throw std::logic_error( upload ? "FrameRing: the buffer isn't uploaded." : "FrameRing: the buffer isn't downloaded." );
+
+		return staging[index[buffer]];
+	}
+
+	std::span<std::byte> FrameRing::Frame::upload( const std::size_t buffer ) const
+	{
+		return staging_for( buffer, true ).view<std::byte>();
+	}
+
+	std::span<const std::byte> FrameRing::Frame::readback( const std::size_t buffer ) const
+	{
+		return staging_for( buffer, false ).view<const std::byte>();
+	}
+
+	/// FRAME RING
+
+	FrameRing::FrameRing(
+		const Context& context,
+		const std::span<const FrameBufferInfo> layout_,
+		const std::size_t depth,
+		const uint32_t queue_index )
+		:
+		device( context.device ),
+		queue( context.device, context.queue_family_index, queue_index ),
+		transfer_queue( context.device, context.transfer_queue_family_index, 0 ),
+		compute_family( context.queue_family_index ),
+		transfer_family( context.transfer_queue_family_index ),
+		timeline( context.features.timeline_semaphore ),
+		command_buffers( context, context.queue_family_index ),
+		transfer_command_buffers( context, context.transfer_queue_family_index ),
+		sets( context ),
+		layout( layout_.begin(), layout_.end() )
+	{
+		for( const FrameBufferInfo& info : layout )
+			internal::check_frame_buffer( context, info );
+
+		frames.reserve( std::max<std::size_t>( depth, 1 ) );
+		for( std::size_t i { 0 }; i < std::max<std::size_t>( depth, 1 ); ++i )
+		{
+			frames.emplace_back(
+				context, layout, i,
+				transfer_command_buffers.acquire(), command_buffers.acquire(), transfer_command_buffers.acquire()
+			);
+		}
+	}
+
+	FrameRing::~FrameRing()
+	{
+		try
+		{
+			// its dispatches may still be running, and only the readback carries the fence
+			submit_readback();
+		}
+		catch( ... )
+		{
+			// the device is most likely lost, the wait below returns straight away
+		}
+
+		for( Frame& frame : frames )
+		{
+			try
+			{
+				if( frame.in_flight )
+					std::ignore = device.waitForFences( { *frame.fence }, VK_TRUE, internal::frame_no_timeout );
+			}
+			catch( ... )
+			{
+				// the device is most likely lost, nothing left to wait for
+			}
+		}
+	}
+
+	FrameRing::Frame& FrameRing::acquire()
+	{
+		Frame& frame { frames[next] };
+		next = ( next + 1 ) % frames.size();
+		wait( frame );
+		return frame;
+	}
+
+	void FrameRing::submit_stage(
+		const vk::raii::Queue& target,
+		const vk::CommandBuffer buffer,
+		const std::optional<TimelinePoint>& wait,
+		const vk::PipelineStageFlags wait_stage,
+		const std::optional<TimelinePoint>& signal,
+		const vk::Fence fence ) const
+	{
+		const vk::Semaphore wait_semaphore { wait ? wait->semaphore : vk::Semaphore() };
+		const uint64_t wait_value { wait ? wait->value : 0 };
+		const vk::Semaphore signal_semaphore { signal ? signal->semaphore : vk::Semaphore() };
+		const uint64_t signal_value { signal ? signal->value : 0 };
+
+		const vk::TimelineSemaphoreSubmitInfo timeline_info(
+			wait ? vk::ArrayProxyNoTemporaries<const uint64_t>( wait_value ) : nullptr,
+			signal ? vk::ArrayProxyNoTemporaries<const uint64_t>( signal_value ) : nullptr
+		);
+		const vk::SubmitInfo submit_info(
+			wait ? vk::ArrayProxyNoTemporaries<const vk::Semaphore>( wait_semaphore ) : nullptr,
+			wait ? vk::ArrayProxyNoTemporaries<const vk::PipelineStageFlags>( wait_stage ) : nullptr,
+			buffer,
+			signal ? vk::ArrayProxyNoTemporaries<const vk::Semaphore>( signal_semaphore ) : nullptr,
+			timeline ? &timeline_info : nullptr
+		);
+		target.submit( submit_info, fence );
+	}
+
+	void FrameRing::submit_readback()
+	{
+		if( !pending_readback )
+			return;
+
+		Frame& frame { frames[*pending_readback] };
+		submit_stage(
+			transfer_queue, *frame.readback_commands,
+			TimelinePoint { *frame.computed, frame.iteration + 1 }, vk::PipelineStageFlagBits::eTransfer,
+			std::nullopt, *frame.fence
+		);
+		pending_readback.reset();
+	}
+
+	uint64_t FrameRing::submit( Frame& frame, const Recorder& record )
+	{
+		if( frame.in_flight )
+			throw std::logic_error( "FrameRing: the frame is still in flight, acquire() or wait() for it first." );
+
+		const bool uploads { std::ranges::any_of( layout, internal::frame_uploads, &FrameBufferInfo::transfer ) };
+		const bool downloads { std::ranges::any_of( layout, internal::frame_downloads, &FrameBufferInfo::transfer ) };
+
+		// without a transfer only family both sides are one family, and the semaphores order everything
+		const bool transfers_ownership { compute_family != transfer_family };
+
+		std::vector<vk::BufferMemoryBarrier> acquired;
+		std::vector<vk::BufferMemoryBarrier> released;
+		if( transfers_ownership )
+		{
+			for( std::size_t i { 0 }; i < layout.size(); ++i )
+			{
+				if( internal::frame_uploads( layout[i].transfer ) )
+				{
+					acquired.emplace_back( internal::frame_ownership(
+						frame.buffers[i], {}, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eUniformRead,
+						transfer_family, compute_family
+					) );
+				}
+				if( internal::frame_downloads( layout[i].transfer ) )
+				{
+					released.emplace_back( internal::frame_ownership(
+						frame.buffers[i], vk::AccessFlagBits::eShaderWrite, {}, compute_family, transfer_family
+					) );
+				}
+			}
+		}
+
+		// the dispatches first, the only part that can throw before anything was recorded
+		const vk::raii::CommandBuffer& buffer { frame.command_buffer };
+		buffer.begin( vk::CommandBufferBeginInfo( vk::CommandBufferUsageFlagBits::eOneTimeSubmit ) );
+		if( !acquired.empty() )
+		{
+			buffer.pipelineBarrier(
+				vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eComputeShader,
+				{}, nullptr, acquired, nullptr
+			);
+		}
+
+		try
+		{
+			record( buffer, frame );
+		}
+		catch( ... )
+		{
+			// back to the initial state, so the frame can be submitted again
+			buffer.reset();
+			throw;
+		}
+
+		if( !released.empty() )
+		{
+			buffer.pipelineBarrier(
+				vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eBottomOfPipe,
+				{}, nullptr, released, nullptr
+			);
+		}
+		buffer.end();
+
+		if( uploads )
+		{
+			std::vector<vk::BufferMemoryBarrier> uploaded;
+			const vk::raii::CommandBuffer& upload_buffer { frame.upload_commands };
+			upload_buffer.begin( vk::CommandBufferBeginInfo( vk::CommandBufferUsageFlagBits::eOneTimeSubmit ) );
+			for( std::size_t i { 0 }; i < layout.size(); ++i )
+			{
+				if( !internal::frame_uploads( layout[i].transfer ) )
+					continue;
+
+				const Buffer& staging { frame.staging_for( i, true ) };
+				staging.flush();
+				upload_buffer.copyBuffer( *staging.buffer, *frame.buffers[i].buffer, vk::BufferCopy( 0, 0, layout[i].bytes ) );
+				if( transfers_ownership )
+				{
+					uploaded.emplace_back( internal::frame_ownership(
+						frame.buffers[i], vk::AccessFlagBits::eTransferWrite, {}, transfer_family, compute_family
+					) );
+				}
+			}
+			if( !uploaded.empty() )
+			{
+				upload_buffer.pipelineBarrier(
+					vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe,
+					{}, nullptr, uploaded, nullptr
+				);
+			}
+			upload_buffer.end();
+		}
+
+		if( downloads )
+		{
+			std::vector<vk::BufferMemoryBarrier> readable;
+			std::vector<vk::BufferMemoryBarrier> copied;
+			for( std::size_t i { 0 }; i < layout.size(); ++i )
+			{
+				if( !internal::frame_downloads( layout[i].transfer ) )
+					continue;
+
+				if( transfers_ownership )
+				{
+					readable.emplace_back( internal::frame_ownership(
+						frame.buffers[i], {}, vk::AccessFlagBits::eTransferRead, compute_family, transfer_family
+					) );
+				}
+				copied.emplace_back(
+					vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eHostRead,
+					VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+					*frame.staging_for( i, false ).buffer, 0, VK_WHOLE_SIZE
+				);
+			}
+
+			const vk::raii::CommandBuffer& readback_buffer { frame.readback_commands };
+			readback_buffer.begin( vk::CommandBufferBeginInfo( vk::CommandBufferUsageFlagBits::eOneTimeSubmit ) );
+			if( !readable.empty() )
+			{
+				readback_buffer.pipelineBarrier(
+					vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer,
+					{}, nullptr, readable, nullptr
+				);
+			}
+			for( std::size_t i { 0 }; i < layout.size(); ++i )
+			{
+				if( internal::frame_downloads( layout[i].transfer ) )
+					readback_buffer.copyBuffer( *frame.buffers[i].buffer, *frame.staging_for( i, false ).buffer, vk::BufferCopy( 0, 0, layout[i].bytes ) );
+			}
+			readback_buffer.pipelineBarrier(
+				vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost,
+				{}, nullptr, copied, nullptr
+			);
+			readback_buffer.end();
+		}
+
+		const uint64_t value { submitted + 1 }; // the iteration's point on the frame's semaphores
+		if( uploads )
+		{
+			submit_stage(
+				transfer_queue, *frame.upload_commands,
+				std::nullopt, {},
+				TimelinePoint { *frame.uploaded, value }, nullptr
+			);
+		}
+
+		// the previous iteration's readback, behind this upload on the transfer queue
+		submit_readback();
+
+		submit_stage(
+			queue, *buffer,
+			uploads ? std::optional( TimelinePoint { *frame.uploaded, value } ) : std::nullopt, vk::PipelineStageFlagBits::eComputeShader,
+			downloads ? std::optional( TimelinePoint { *frame.computed, value } ) : std::nullopt, downloads ? vk::Fence() : *frame.fence
+		);
+
+		frame.in_flight = true;
+		frame.iteration = submitted;
+		frame.completed.reset();
+		if( downloads )
+			pending_readback = frame.slot;
+		return submitted++;
+	}
+
+	void FrameRing::wait( Frame& frame )
+	{
+		if( !frame.in_flight )
+			return;
+
+		if( pending_readback == frame.slot )
+			submit_readback();
+
+		std::ignore = device.waitForFences( { *frame.fence }, VK_TRUE, internal::frame_no_timeout );
+		device.resetFences( { *frame.fence } );
+		frame.in_flight = false;
+		frame.completed = frame.iteration;
+
+		for( std::size_t i { 0 }; i < layout.size(); ++i )
+		{
+			if( internal::frame_downloads( layout[i].transfer ) )
+				frame.staging_for( i, false ).invalidate();
+		}
+	}
+
+	void FrameRing::drain( const Consumer& consume )
+	{
+		// the oldest iteration sits in the slot acquire() hands out next
+		for( std::size_t i { 0 }; i < frames.size(); ++i )
+		{
+			Frame& frame { frames[( next + i ) % frames.size()] };
+			if( !frame.in_flight )
+				continue;
+
+			wait( frame );
+			if( consume )
+				consume( frame );
+		}
+	}
+
+	vk::DescriptorSet FrameRing::descriptor_set( const Pipeline& pipeline, const Frame& frame )
+	{
+		return sets.get( pipeline, frame.buffers );
+	}
+
+}
@@ -0,0 +1,100 @@
+#include <array>
+#include <string>
+
+#include <fgl/vulkan/kernels.hpp>
+
+namespace fgl::vulkan
+{
+
+	namespace internal
+	{
+		// in Kernel order
+		constexpr std::array<KernelInfo, 8> kernels { {
+			{ "Square", "main", push_constant_size<OuterProductParameters>, { 16, 16, 1 }, { 1, 1, 1 } },
+			{ "OuterProduct", "main", push_constant_size<OuterProductParameters>, { 16, 4, 1 }, { 4, 4, 1 } },
+			{ "Reduce", "main", push_constant_size<ReduceParameters>, { 256, 1, 1 }, { 4, 1, 1 } },
+			{ "ReduceSubgroup", "main", push_constant_size<ReduceParameters>, { 256, 1, 1 }, { 4, 1, 1 } },
+			{ "Scan", "main", push_constant_size<ScanParameters>, { 256, 1, 1 }, { 4, 1, 1 } },
+			{ "ScanSubgroup", "main", push_constant_size<ScanParameters>, { 256, 1, 1 }, { 4, 1, 1 } },
+			{ "RadixSort", "main", push_constant_size<RadixSortParameters>, { 256, 1, 1 }, { 4, 1, 1 } },
+			{ "RadixSortSubgroup", "main", push_constant_size<RadixSortParameters>, { 256, 1, 1 }, { 4, 1, 1 } }
+		} };
+
+		// the specialized value of constant_id, or fallback
+		uint32_t specialized_value(
+			const Specialization& specialization,
+			const uint32_t constant_id,
+			const uint32_t fallback )
+		{
+			const auto& values { specialization.values() };
+			const auto it { values.find( constant_id ) };
+			return it == values.cend() ? fallback : it->second;
+		}
+	} // namespace internal
+
+	const KernelInfo& kernel_info( const Kernel kernel )
+	{
+		return internal::kernels.at( static_cast< std::size_t >( kernel ) );
+	}
+
+	std::filesystem::path kernel_path(
+		const Kernel kernel,
+		const std::filesystem::path& directory )
+	{
+		return directory / ( std::string( kernel_info( kernel ).name ) + ".spv" );
+	}
+
+	Specialization kernel_specialization(
+		const Kernel kernel,
+		const Specialization& specialization )
+	{
+		const KernelInfo& info { kernel_info( kernel ) };
+
+		Specialization result;
+		result.workgroup_size( info.workgroup_size[0], info.workgroup_size[1], info.workgroup_size[2] );
+		if( kernel == Kernel::eOuterProduct )
+			result.set( outer_product_rows_id, info.outputs_per_invocation[1] );
+
+		for( const auto& [constant_id, value] : specialization.values() )
+			result.set( constant_id, value );
+
+		return result;
+	}
+
+	WorkgroupSize kernel_group_count(
+		const Kernel kernel,
+		const WorkgroupSize& problem_size,
+		const WorkgroupSize& workgroup_size )
+	{
+		const WorkgroupSize& outputs { kernel_info( kernel ).outputs_per_invocation };
+		return group_count( problem_size, {
+			workgroup_size[0] * outputs[0],
+			workgroup_size[1] * outputs[1],
+			workgroup_size[2] * outputs[2]
+		} );
+	}
+
+	WorkgroupSize kernel_group_count(
+		const Kernel kernel,
+		const WorkgroupSize& problem_size,
+		const Specialization& specialization )
+	{
+		const Specialization full { kernel_specialization( kernel, specialization ) };
+
+		WorkgroupSize workgroup_size {};
+		for( std::size_t i { 0 }; i < workgroup_size.size(); ++i )
+			workgroup_size[i] = internal::specialized_value( full, Specialization::workgroup_size_ids[i], 1 );
+
+		if( kernel != Kernel::eOuterProduct )
+			return kernel_group_count( kernel, problem_size, workgroup_size );
+
+		// rows per invocation is specializable too
+		const uint32_t rows { internal::specialized_value( full, outer_product_rows_id, 1 ) };
+		return group_count( problem_size, {
+			workgroup_size[0] * kernel_info( kernel ).outputs_per_invocation[0],
+			workgroup_size[1] * rows,
+			workgroup_size[2]
+		} );
+	}
+
+}
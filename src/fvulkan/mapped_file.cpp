@@ -0,0 +1,420 @@
+#include <algorithm>
+#include <cstdint> // uintptr_t
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include <fgl/vulkan/mapped_file.hpp>
+
+namespace fgl::vulkan
+{
+
+	namespace internal
+	{
+		// pieces for memcpy into host visible memory, so a multi-GB copy doesn't fault in the whole file at once
+		constexpr std::size_t file_copy_chunk { 64ull * 1024 * 1024 };
+
+		// errno or GetLastError(), taken before cleanup can overwrite it
+		std::error_code last_error() noexcept
+		{
+#ifdef _WIN32
+			return std::error_code( static_cast< int >( GetLastError() ), std::system_category() );
+#else
+			return std::error_code( errno, std::generic_category() );
+#endif
+		}
+
+		[[noreturn]] void throw_file_error(
+			const std::string& what,
+			const std::filesystem::path& path,
+			const std::error_code error )
+		{
+			std::stringstream msg;
+			msg << "MappedFile: " << what << ' ' << path << ": " << error.message();
+			throw std::system_error( error, msg.str() );
+		}
+
+		// clamps size to what's left of the file after offset
+		std::span<const std::byte> file_range(
+			const MappedFile& file,
+			const std::size_t offset,
+			const std::size_t size )
+		{
+			if( offset > file.size() )
+			{
+				std::stringstream msg;
+				msg << "Offset " << offset << " is past the end of " << file.path << " (" << file.size() << " bytes).";
+				throw std::out_of_range( msg.str() );
+			}
+			return file.bytes().subspan( offset, std::min( size, file.size() - offset ) );
+		}
+
+		vk::PhysicalDeviceExternalMemoryHostPropertiesEXT external_memory_host_properties( const Context& context )
+		{
+			const auto chain {
+				context.physical_device.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceExternalMemoryHostPropertiesEXT>()
+			};
+			return chain.get<vk::PhysicalDeviceExternalMemoryHostPropertiesEXT>();
+		}
+
+		// memory for buffer, which it is bound to at offset 0
+		vk::raii::DeviceMemory import_host_memory(
+			const Context& context,
+			const std::span<const std::byte> host,
+			const vk::raii::Buffer& buffer )
+		{
+			constexpr auto handle_type { vk::ExternalMemoryHandleTypeFlagBits::eHostAllocationEXT };
+
+			const auto requirements { buffer.getMemoryRequirements() };
+			if( requirements.size > host.size() )
+				throw std::runtime_error( "ImportedBuffer: the buffer needs more memory than the imported range." );
+			if( reinterpret_cast< std::uintptr_t >( host.data() ) % requirements.alignment != 0 )
+				throw std::runtime_error( "ImportedBuffer: the host pointer doesn't meet the buffer's alignment." );
+
+			// the pointer is imported as is; const only because the caller may not write through it
+			void* pointer { const_cast< std::byte* >( host.data() ) };
+			const auto host_properties { context.device.getMemoryHostPointerPropertiesEXT( handle_type, pointer ) };
+			const uint32_t type_bits { host_properties.memoryTypeBits & requirements.memoryTypeBits };
+
+			// host visible types only, the import is host memory whatever the bits say
+			const auto memory_properties { context.physical_device.getMemoryProperties() };
+			uint32_t type_index { memory_properties.memoryTypeCount };
+			for( uint32_t index { 0 }; index < memory_properties.memoryTypeCount; ++index )
+			{
+				const bool allowed { ( type_bits & ( 1u << index ) ) != 0 };
+				if( allowed && ( memory_properties.memoryTypes[index].propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible ) )
+				{
+					type_index = index;
+					break;
+				}
+			}
+			if( type_index == memory_properties.memoryTypeCount )
+				throw std::runtime_error( "ImportedBuffer: no host visible memory type accepts both the host pointer and the buffer." );
+
+			const vk::ImportMemoryHostPointerInfoEXT import_info( handle_type, pointer );
+			const vk::MemoryAllocateInfo allocate_info( host.size(), type_index, &import_info );
+			return vk::raii::DeviceMemory( context.device, allocate_info );
+		}
+
+		vk::raii::Buffer create_imported_buffer(
+			const Context& context,
+			const vk::DeviceSize bytesize,
+			const vk::BufferUsageFlags usageflags )
+		{
+			const auto indices { context.queue_family_indices() };
+
+			// concurrent sharing needs more than one family, exclusive ignores the list
+			const vk::SharingMode mode {
+				indices.size() > 1 ? vk::SharingMode::eConcurrent : vk::SharingMode::eExclusive
+			};
+
+			const vk::ExternalMemoryBufferCreateInfo external_info( vk::ExternalMemoryHandleTypeFlagBits::eHostAllocationEXT );
+			const vk::BufferCreateInfo ci( {}, bytesize, usageflags, mode, indices, &external_info );
+			return vk::raii::Buffer( context.device, ci );
+		}
+	} // namespace internal
+
+	MappedFile::MappedFile( const std::filesystem::path& path_, const Mode mode_ )
+		:
+		path( path_ ),
+		mode( mode_ )
+	{
+		map( false, 0 );
+	}
+
+	MappedFile::MappedFile( const std::filesystem::path& path_, const std::size_t size )
+		:
+		path( path_ ),
+		mode( Mode::eReadWrite )
+	{
+		map( true, size );
+	}
+
+	MappedFile::~MappedFile()
+	{
+		unmap();
+	}
+
+#ifdef _WIN32
+	void MappedFile::map( const bool create, const std::size_t create_size )
+	{
+		const bool writable { mode == Mode::eReadWrite };
+		file_handle = CreateFileW(
+			path.c_str(),
+			writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+			FILE_SHARE_READ,
+			nullptr,
+			create ? CREATE_ALWAYS : OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+			nullptr
+		);
+		if( file_handle == INVALID_HANDLE_VALUE )
+		{
+			file_handle = nullptr;
+			internal::throw_file_error( "couldn't open", path, internal::last_error() );
+		}
+
+		LARGE_INTEGER size {};
+		if( create )
+			size.QuadPart = static_cast< LONGLONG >( create_size );
+		else if( !GetFileSizeEx( file_handle, &size ) )
+		{
+			const auto error { internal::last_error() };
+			unmap();
+			internal::throw_file_error( "couldn't get the size of", path, error );
+		}
+		bytesize = static_cast< std::size_t >( size.QuadPart );
+
+		// empty files can't be mapped; they simply have no bytes
+		if( bytesize == 0 )
+			return;
+
+		mapping_handle = CreateFileMappingW(
+			file_handle, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY,
+			static_cast< DWORD >( size.QuadPart >> 32 ), static_cast< DWORD >( size.QuadPart & 0xFFFFFFFF ), nullptr
+		);
+		if( mapping_handle == nullptr )
+		{
+			const auto error { internal::last_error() };
+			unmap();
+			internal::throw_file_error( "couldn't create a mapping of", path, error );
+		}
+
+		data = static_cast< std::byte* >( MapViewOfFile( mapping_handle, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0 ) );
+		if( data == nullptr )
+		{
+			const auto error { internal::last_error() };
+			unmap();
+			internal::throw_file_error( "couldn't map", path, error );
+		}
+	}
+
+	void MappedFile::unmap() noexcept
+	{
+		if( data != nullptr )
+			UnmapViewOfFile( data );
+		if( mapping_handle != nullptr )
+			CloseHandle( mapping_handle );
+		if( file_handle != nullptr )
+			CloseHandle( file_handle );
+
+		data = nullptr;
+		mapping_handle = nullptr;
+		file_handle = nullptr;
+	}
+
+	void MappedFile::advise_sequential() const noexcept
+	{
+		// FILE_FLAG_SEQUENTIAL_SCAN on open already covers it
+	}
+
+	void MappedFile::flush( const std::size_t offset, const std::size_t size ) const
+	{
+		if( data == nullptr || offset >= bytesize )
+			return;
+
+		if( !FlushViewOfFile( data + offset, std::min( size, bytesize - offset ) ) || !FlushFileBuffers( file_handle ) )
+			internal::throw_file_error( "couldn't flush", path, internal::last_error() );
+	}
+#else
+	void MappedFile::map( const bool create, const std::size_t create_size )
+	{
+		const bool writable { mode == Mode::eReadWrite };
+		const int flags { ( writable ? O_RDWR : O_RDONLY ) | ( create ? O_CREAT | O_TRUNC : 0 ) };
+		descriptor = ::open( path.c_str(), flags, 0644 );
+		if( descriptor < 0 )
+			internal::throw_file_error( "couldn't open", path, internal::last_error() );
+
+		if( create )
+		{
+			if( ::ftruncate( descriptor, static_cast< off_t >( create_size ) ) != 0 )
+			{
+				const auto error { internal::last_error() };
+				unmap();
+				internal::throw_file_error( "couldn't resize", path, error );
+			}
+			bytesize = create_size;
+		}
+		else
+		{
+			struct stat status {};
+			if( ::fstat( descriptor, &status ) != 0 )
+			{
+				const auto error { internal::last_error() };
+				unmap();
+				internal::throw_file_error( "couldn't get the size of", path, error );
+			}
+			bytesize = static_cast< std::size_t >( status.st_size );
+		}
+
+		// empty files can't be mapped; they simply have no bytes
+		if( bytesize == 0 )
+			return;
+
+		void* mapped { ::mmap( nullptr, bytesize, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, descriptor, 0 ) };
+		if( mapped == MAP_FAILED )
+		{
+			const auto error { internal::last_error() };
+			unmap();
+			internal::throw_file_error( "couldn't map", path, error );
+		}
+		data = static_cast< std::byte* >( mapped );
+	}
+
+	void MappedFile::unmap() noexcept
+	{
+		if( data != nullptr )
+			::munmap( data, bytesize );
+		if( descriptor >= 0 )
+			::close( descriptor );
+
+		data = nullptr;
+		descriptor = -1;
+	}
+
+	void MappedFile::advise_sequential() const noexcept
+	{
+		if( data != nullptr )
+			::madvise( data, bytesize, MADV_SEQUENTIAL );
+	}
+
+	void MappedFile::flush( const std::size_t offset, const std::size_t size ) const
+	{
+		if( data == nullptr || offset >= bytesize )
+			return;
+
+		// msync wants a page aligned start
+		const auto page { static_cast< std::size_t >( ::sysconf( _SC_PAGESIZE ) ) };
+		const std::size_t start { offset / page * page };
+		const std::size_t end { offset + std::min( size, bytesize - offset ) };
+		if( ::msync( data + start, end - start, MS_SYNC ) != 0 )
+			internal::throw_file_error( "couldn't flush", path, internal::last_error() );
+	}
+#endif
+
+	std::span<std::byte> MappedFile::writable_bytes() const
+	{
+		if( mode != Mode::eReadWrite )
+		{
+			std::stringstream msg;
+			msg << "MappedFile: " << path << " is mapped read only.";
+			throw std::logic_error( msg.str() );
+		}
+		return { data, bytesize };
+	}
+
+	void load_file(
+		TransferEngine& transfer,
+		const MappedFile& file,
+		const Buffer& destination,
+		const vk::DeviceSize destination_offset,
+		const std::size_t file_offset,
+		const std::size_t size )
+	{
+		const auto source { internal::file_range( file, file_offset, size ) };
+		file.advise_sequential();
+
+		if( !destination.memory.host_visible() )
+		{
+			transfer.upload( destination, source, destination_offset );
+			return;
+		}
+
+		if( destination_offset > destination.bytesize || source.size() > destination.bytesize - destination_offset )
+			throw std::out_of_range( "load_file: the file range exceeds the size of the buffer." );
+
+		const auto target { destination.view<std::byte>().subspan( static_cast< std::size_t >( destination_offset ), source.size() ) };
+		for( std::size_t done { 0 }; done < source.size(); done += internal::file_copy_chunk )
+		{
+			const std::size_t chunk { std::min( internal::file_copy_chunk, source.size() - done ) };
+			std::memcpy( target.data() + done, source.data() + done, chunk );
+		}
+		destination.flush( destination_offset, source.size() );
+	}
+
+	void store_file(
+		TransferEngine& transfer,
+		const Buffer& source,
+		const MappedFile& file,
+		const vk::DeviceSize source_offset,
+		const std::size_t file_offset,
+		const std::size_t size )
+	{
+		const auto whole { file.writable_bytes() };
+		const auto range { internal::file_range( file, file_offset, size ) };
+		const auto target { whole.subspan( file_offset, range.size() ) };
+
+		if( !source.memory.host_visible() )
+		{
+			transfer.download( source, target, source_offset );
+			return;
+		}
+
+		if( source_offset > source.bytesize || target.size() > source.bytesize - source_offset )
+			throw std::out_of_range( "store_file: the file range exceeds the size of the buffer." );
+
+		source.invalidate( source_offset, target.size() );
+		const auto bytes { source.view<std::byte>().subspan( static_cast< std::size_t >( source_offset ), target.size() ) };
+		for( std::size_t done { 0 }; done < target.size(); done += internal::file_copy_chunk )
+		{
+			const std::size_t chunk { std::min( internal::file_copy_chunk, target.size() - done ) };
+			std::memcpy( target.data() + done, bytes.data() + done, chunk );
+		}
+	}
+
+	bool ImportedBuffer::can_import( const Context& context, const std::span<const std::byte> host )
+	{
+		if( !context.has_device_extension( VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME ) || host.empty() )
+			return false;
+
+		const vk::DeviceSize alignment { internal::external_memory_host_properties( context ).minImportedHostPointerAlignment };
+		return reinterpret_cast< std::uintptr_t >( host.data() ) % alignment == 0
+			&& host.size() % alignment == 0;
+	}
+
+	ImportedBuffer::ImportedBuffer(
+		const Context& context,
+		const std::span<const std::byte> host,
+		const vk::BufferUsageFlags usageflags,
+		const uint32_t binding_,
+		const vk::DescriptorType type )
+		:
+		binding( binding_ ),
+		buffer_type( type ),
+		bytesize( host.size() ),
+		buffer(
+			[&]()
+			{
+				if( !can_import( context, host ) )
+				{
+					throw std::invalid_argument(
+						"ImportedBuffer: the device lacks VK_EXT_external_memory_host or the range isn't aligned to minImportedHostPointerAlignment."
+					);
+				}
+				return internal::create_imported_buffer( context, bytesize, usageflags );
+			}()
+		),
+		memory( internal::import_host_memory( context, host, buffer ) )
+	{
+		buffer.bindMemory( *memory, 0 );
+	}
+
+}
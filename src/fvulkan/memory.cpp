@@ -1,3 +1,5 @@
+#include <stdexcept>
+
 #include <vulkan/vulkan_raii.hpp>
 
 #include <fgl/vulkan/memory.hpp>
@@ -5,82 +7,49 @@
 
 namespace fgl::vulkan
 {
-	size_t Buffer::bytecount { 0 }; //Static member of Buffer
-
 	namespace internal
 	{
+		// the byte count of [offset, offset + size) within the buffer, VK_WHOLE_SIZE reaching its end
+		vk::DeviceSize buffer_range_size( const vk::DeviceSize bytesize, const vk::DeviceSize offset, const vk::DeviceSize size )
+		{
+			if( offset > bytesize || ( size != VK_WHOLE_SIZE && size > bytesize - offset ) )
+			{
+				throw std::out_of_range( "Buffer range exceeds the size of the buffer." );
+			}
+			return size == VK_WHOLE_SIZE ? bytesize - offset : size;
+		}
+
 		//BUFFER
 		vk::raii::Buffer create_buffer(
 			const Context& vulkan,
 			const vk::DeviceSize size,
-			const vk::BufferUsageFlagBits usageflags,
+			const vk::BufferUsageFlags usageflags,
 			const vk::SharingMode sharingmode )
 		{
-			constexpr uint32_t number_of_family_indexes { 1 };
+			const auto indices { vulkan.queue_family_indices() };
 
-			const auto index { vulkan.index_of_first_queue_family( vk::QueueFlagBits::eCompute ) };
+			// concurrent sharing needs more than one family, exclusive ignores the list
+			const vk::SharingMode mode {
+				indices.size() > 1 ? sharingmode : vk::SharingMode::eExclusive
+			};
 
 			const vk::BufferCreateInfo ci(
 				{},
 				size,
 				usageflags,
-				sharingmode,
-				number_of_family_indexes,
-				&index
+				mode,
+				indices
 			);
 			return vulkan.device.createBuffer( ci );
 		}
 
-		std::pair<uint32_t, vk::DeviceSize> get_memory_type(
-			const vk::PhysicalDeviceMemoryProperties& device_memory_properties,
-			const vk::MemoryPropertyFlags flags )
-		{
-			for(
-				uint32_t current_memory_index = 0;
-				current_memory_index < device_memory_properties.memoryTypeCount;
-				++current_memory_index )
-			{
-				const vk::MemoryType memoryType {
-					device_memory_properties.memoryTypes[current_memory_index]
-				};
-				if( flags & memoryType.propertyFlags )
-				{
-					const vk::DeviceSize memory_heap_size {
-						 device_memory_properties.memoryHeaps[memoryType.heapIndex].size
-					};
-					return std::pair { current_memory_index, memory_heap_size };
-				}
-			}
-			throw std::runtime_error( "Failed to get memory type." );
-		}
-
-		vk::raii::DeviceMemory create_device_memory(
+		Allocation allocate_memory(
 			const Context& context,
 			const vk::raii::Buffer& buffer,
-			const vk::DeviceSize bytesize,
-			const vk::MemoryPropertyFlags flags )
+			const vk::MemoryPropertyFlags flags,
+			const vk::MemoryPropertyFlags preferred_flags )
 		{
-			const auto& [memindex, size] { get_memory_type( context.physical_device.getMemoryProperties(), flags ) };
-
-			auto& bytecount { Buffer::bytecount };
-
-			bytecount += buffer.getMemoryRequirements().size;
-			if( context.physical_device.getMemoryProperties().memoryHeaps[1].size < bytecount )
-			{
-				std::stringstream ss;
-				ss
-					<< "Attempting to allocate too much memory (in Byte)\n"
-					<< "\tMemory allocated: " << bytesize << "\n"
-					<< "\tMaximum Memory: " << context.physical_device.getMemoryProperties().memoryHeaps[1].size << "\n"
-					<< "\tMemory avalilable: " << context.properties.limits.maxMemoryAllocationCount - ( bytecount - bytesize ) << "\n"
-					<< "\tMemory Over: " << bytecount - context.physical_device.getMemoryProperties().memoryHeaps[1].size - ( bytecount - bytesize ) << "\n";
-
-				throw std::runtime_error( ss.str() );
-			}
-
-			const vk::MemoryAllocateInfo memInfo( buffer.getMemoryRequirements().size, memindex );
-
-			return context.device.allocateMemory( memInfo );
+			return context.arena->allocate( buffer.getMemoryRequirements(), flags, preferred_flags );
 		}
 
 	} // namespace internal
@@ -89,29 +58,33 @@ namespace fgl::vulkan
 	Buffer::Buffer(
 		const Context& context,
 		const vk::DeviceSize& size,
-		const vk::BufferUsageFlagBits usageflags,
+		const vk::BufferUsageFlags usageflags,
 		const vk::SharingMode sharingmode,
 		const uint32_t binding_,
 		const vk::MemoryPropertyFlags flags,
-		const vk::DescriptorType type )
+		const vk::DescriptorType type,
+		const vk::MemoryPropertyFlags preferred_flags )
 		:
 		binding( binding_ ),
 		buffer_type( type ),
 		bytesize( size ),
 		buffer( internal::create_buffer( context, size, usageflags, sharingmode ) ),
-		memory( internal::create_device_memory( context, buffer, bytesize, flags ) )
+		memory( internal::allocate_memory( context, buffer, flags, preferred_flags ) )
 	{
-		constexpr vk::DeviceSize offset { 0 };
-		buffer.bindMemory( *memory, offset );
+		buffer.bindMemory( memory.memory(), memory.offset );
 		std::cout
 			<< "\n\tAllocated " << size << " bytes to binding: " << binding_
 			<< std::endl;
 	}
 
-	void* Buffer::get_memory() const
+	void Buffer::flush( const vk::DeviceSize offset, const vk::DeviceSize size ) const
+	{
+		memory.flush( offset, internal::buffer_range_size( bytesize, offset, size ) );
+	}
+
+	void Buffer::invalidate( const vk::DeviceSize offset, const vk::DeviceSize size ) const
 	{
-		constexpr vk::DeviceSize offset { 0 };
-		return memory.mapMemory( offset, bytesize );
+		memory.invalidate( offset, internal::buffer_range_size( bytesize, offset, size ) );
 	}
 
 }
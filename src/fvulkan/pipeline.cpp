@@ -1,60 +1,139 @@
 
-#include <cassert>
-#include <cstdint> // uintptr_t
+#include <algorithm>
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
 
+#include <fgl/vulkan/mapped_file.hpp>
 #include <fgl/vulkan/pipeline.hpp>
 
 #include <vulkan/vulkan_raii.hpp>
 
-#include <fgl/io.hpp>
-
 namespace fgl::vulkan
 {
+	Specialization& Specialization::workgroup_size(
+		const uint32_t x,
+		const uint32_t y,
+		const uint32_t z )
+	{
+		const auto& [x_id, y_id, z_id] { workgroup_size_ids };
+		return set( x_id, x ).set( y_id, y ).set( z_id, z );
+	}
+
+	std::array<uint32_t, 3> preferred_workgroup_size(
+		const Context& context,
+		const uint32_t dimensions )
+	{
+		const auto& limits { context.properties.limits };
+
+		// a few subgroups per workgroup hide latency without hurting occupancy
+		constexpr uint32_t subgroups_per_workgroup { 4 };
+		const uint32_t subgroup { std::max( context.subgroup_size, 1u ) };
+		const uint32_t invocations {
+			std::min( subgroup * subgroups_per_workgroup, limits.maxComputeWorkGroupInvocations )
+		};
+
+		std::array<uint32_t, 3> size { 1, 1, 1 };
+		if( dimensions <= 1 )
+		{
+			size[0] = std::min( invocations, limits.maxComputeWorkGroupSize[0] );
+			return size;
+		}
+
+		size[0] = std::min( { subgroup, invocations, limits.maxComputeWorkGroupSize[0] } );
+		size[1] = std::min( invocations / size[0], limits.maxComputeWorkGroupSize[1] );
+		return size;
+	}
+
 	vk::raii::ShaderModule Pipeline::create_shader_module(
 		const Context& cntx,
 		const std::filesystem::path path ) const
 	{
-		const auto buff { fgl::read_binary_file( path ) };
-
-		/// TODO guarentee alignment
-		// assert vector memory meets allignment requirements of uint32_t
-		assert( reinterpret_cast< uintptr_t >( buff.data() ) % sizeof( uint32_t ) == 0 );
-
-		const vk::ShaderModuleCreateInfo ci(
-			vk::ShaderModuleCreateFlags(),
-			buff.size(),
-			reinterpret_cast< const uint32_t* >( // TODO ASSURE ALIGNMENT
-			reinterpret_cast< const void* >( buff.data() )
-		)
-		);
+		// mapped rather than read into a copy; the mapping is page aligned, so the words are too
+		const MappedFile file( path );
+		if( file.size() == 0 || file.size() % sizeof( uint32_t ) != 0 )
+		{
+			std::stringstream msg;
+			msg << "Shader " << path << " is not SPIR-V: " << file.size() << " bytes is not a whole number of words.";
+			throw std::runtime_error( msg.str() );
+		}
+
+		const auto code { file.view<uint32_t>() };
+		const vk::ShaderModuleCreateInfo ci( vk::ShaderModuleCreateFlags(), file.size(), code.data() );
 		return vk::raii::ShaderModule( cntx.device, ci );
 	}
 
 	vk::raii::PipelineLayout Pipeline::create_pipeline_layout( const Context& cntx ) const
 	{
-		const vk::PipelineLayoutCreateInfo ci( {}, *descriptor_set_layouts );
+		const auto max_size { cntx.properties.limits.maxPushConstantsSize };
+		if( push_constant_size % sizeof( uint32_t ) != 0 || push_constant_size > max_size )
+		{
+			std::stringstream msg;
+			msg << "Push constant size of " << push_constant_size
+				<< " bytes is not a multiple of 4 or exceeds the device limit of " << max_size << " bytes.";
+			throw std::length_error( msg.str() );
+		}
+
+		constexpr uint32_t offset { 0 };
+		const vk::PushConstantRange range(
+			vk::ShaderStageFlagBits::eCompute, offset, push_constant_size
+		);
+		vk::PipelineLayoutCreateInfo ci( {}, *descriptor_set_layouts );
+		if( push_constant_size > 0 )
+			ci.setPushConstantRanges( range );
+
 		return vk::raii::PipelineLayout( cntx.device, ci );
 	}
 
 	vk::raii::Pipeline Pipeline::create_pipeline(
 		const Context& cntx,
-		const std::string init_function_name ) const
+		const std::string& init_function_name,
+		const Specialization& spec ) const
 	{
+		std::vector<vk::SpecializationMapEntry> map_entries;
+		std::vector<uint32_t> data;
+		map_entries.reserve( spec.values().size() );
+		data.reserve( spec.values().size() );
+		for( const auto& [constant_id, value] : spec.values() )
+		{
+			const auto offset { static_cast< uint32_t >( data.size() * sizeof( uint32_t ) ) };
+			map_entries.emplace_back( constant_id, offset, sizeof( uint32_t ) );
+			data.emplace_back( value );
+		}
+
+		const vk::SpecializationInfo specialization_info(
+			static_cast< uint32_t >( map_entries.size() ),
+			map_entries.data(),
+			data.size() * sizeof( uint32_t ),
+			data.data()
+		);
+
 		const vk::PipelineShaderStageCreateInfo shader_stage_info(
 			{},
 			vk::ShaderStageFlagBits::eCompute,
 			*shader_module,
-			init_function_name.c_str()
+			init_function_name.c_str(),
+			spec.empty() ? nullptr : &specialization_info
 		);
 		const vk::ComputePipelineCreateInfo ci(
 			{},
 			shader_stage_info,
 			*layout
 		);
-		return cntx.device.createComputePipeline(
-			cntx.device.createPipelineCache( vk::PipelineCacheCreateInfo() ),
-			ci
-		);
+		return cntx.device.createComputePipeline( cntx.pipeline_cache, ci );
+	}
+
+	const vk::raii::Pipeline& Pipeline::variant( const Specialization& spec ) const
+	{
+		if( spec == specialization )
+			return pipeline;
+
+		std::scoped_lock lock( variants_mutex );
+		auto& compiled { variants[spec] };
+		if( !compiled )
+			compiled = std::make_unique<vk::raii::Pipeline>( create_pipeline( context, entry_point, spec ) );
+
+		return *compiled;
 	}
 
 	vk::raii::DescriptorSets Pipeline::create_descriptor_sets( const Context& cntx ) const
@@ -0,0 +1,572 @@
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include <fgl/vulkan/commandqueue.hpp>
+#include <fgl/vulkan/kernels.hpp>
+#include <fgl/vulkan/primitives.hpp>
+
+namespace fgl::vulkan
+{
+
+	namespace internal
+	{
+		// constant ids in src/kernels/primitives.glsl and scan.glsl
+		constexpr uint32_t operation_id { 3 };
+		constexpr uint32_t items_id { 4 };
+		constexpr uint32_t phase_id { 5 };
+
+		constexpr std::array<BindingSlot, 2> reduce_bindings { {
+			{ 0, vk::DescriptorType::eStorageBuffer },
+			{ 1, vk::DescriptorType::eStorageBuffer }
+		} };
+
+		constexpr std::array<BindingSlot, 3> scan_bindings { {
+			{ 0, vk::DescriptorType::eStorageBuffer },
+			{ 1, vk::DescriptorType::eStorageBuffer },
+			{ 2, vk::DescriptorType::eStorageBuffer }
+		} };
+
+		constexpr std::array<BindingSlot, 5> radix_sort_bindings { {
+			{ 0, vk::DescriptorType::eStorageBuffer },
+			{ 1, vk::DescriptorType::eStorageBuffer },
+			{ 2, vk::DescriptorType::eStorageBuffer },
+			{ 3, vk::DescriptorType::eStorageBuffer },
+			{ 4, vk::DescriptorType::eStorageBuffer }
+		} };
+
+		// constant id of the RadixSort kernels' VALUES
+		constexpr uint32_t values_id { 6 };
+
+		uint32_t blocks( const uint64_t count, const uint32_t block_size ) noexcept
+		{
+			return static_cast< uint32_t >( std::max<uint64_t>( 1, ( count + block_size - 1 ) / block_size ) );
+		}
+
+		/* The largest power of two up to 256 the device allows, so the
+			shared memory trees halve evenly; never below one subgroup.*/
+		uint32_t primitive_workgroup_size( const Context& context )
+		{
+			const auto& limits { context.properties.limits };
+			uint32_t size { 256 };
+			while( size > limits.maxComputeWorkGroupInvocations || size > limits.maxComputeWorkGroupSize[0] )
+				size /= 2;
+
+			return std::max( size, context.subgroup_size );
+		}
+
+		Specialization primitive_specialization(
+			const uint32_t workgroup_size,
+			const ReduceOperation operation,
+			const uint32_t items )
+		{
+			Specialization specialization;
+			specialization.workgroup_size( workgroup_size )
+				.set( operation_id, static_cast< uint32_t >( operation ) )
+				.set( items_id, items );
+			return specialization;
+		}
+
+		void check_count( const uint64_t count, const uint32_t max_elements )
+		{
+			if( count > max_elements )
+			{
+				std::stringstream msg;
+				msg << "Primitive over " << count << " elements exceeds its capacity of " << max_elements << " elements.";
+				throw std::length_error( msg.str() );
+			}
+		}
+
+		Buffer scratch_buffer( const Context& context, const uint64_t elements )
+		{
+			return Buffer(
+				context,
+				std::max<uint64_t>( elements, 1 ) * sizeof( uint32_t ),
+				vk::BufferUsageFlagBits::eStorageBuffer,
+				vk::SharingMode::eConcurrent,
+				0,
+				vk::MemoryPropertyFlagBits::eDeviceLocal,
+				vk::DescriptorType::eStorageBuffer
+			);
+		}
+
+		// shader writes of one pass before the reads and writes of the next
+		void compute_barrier(
+			const vk::raii::CommandBuffer& buffer,
+			const vk::PipelineStageFlags destination_stages = vk::PipelineStageFlagBits::eComputeShader,
+			const vk::AccessFlags destination_access = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite )
+		{
+			const vk::MemoryBarrier barrier( vk::AccessFlagBits::eShaderWrite, destination_access );
+			buffer.pipelineBarrier(
+				vk::PipelineStageFlagBits::eComputeShader, destination_stages, {}, barrier, nullptr, nullptr
+			);
+		}
+	} // namespace internal
+
+	uint32_t identity( const ReduceOperation operation ) noexcept
+	{
+		return operation == ReduceOperation::eMin ? std::numeric_limits<uint32_t>::max() : 0;
+	}
+
+	uint32_t combine( const ReduceOperation operation, const uint32_t a, const uint32_t b ) noexcept
+	{
+		switch( operation )
+		{
+			case ReduceOperation::eSum:
+				return a + b;
+			case ReduceOperation::eMin:
+				return std::min( a, b );
+			case ReduceOperation::eMax:
+				return std::max( a, b );
+			default:
+				return a;
+		}
+	}
+
+	/// REDUCTION
+
+	Reduction::Reduction(
+		const Context& context,
+		const ReduceOperation operation_,
+		const uint32_t max_elements_,
+		const std::filesystem::path& kernel_directory )
+		:
+		operation( operation_ ),
+		max_elements( max_elements_ ),
+		workgroup_size( internal::primitive_workgroup_size( context ) ),
+		block_size( workgroup_size * items_per_invocation ),
+		max_groups( context.properties.limits.maxComputeWorkGroupCount[0] ),
+		scratch(
+			[&]()
+			{
+				// partials of every pass that doesn't write the result directly
+				uint64_t elements { 0 };
+				for( uint64_t count { max_elements }; count > block_size; )
+				{
+					count = internal::blocks( count, block_size );
+					elements += count;
+				}
+				return internal::scratch_buffer( context, elements );
+			}()
+		),
+		result_buffer(
+			context,
+			sizeof( uint32_t ),
+			vk::BufferUsageFlagBits::eStorageBuffer,
+			vk::SharingMode::eConcurrent,
+			1,
+			vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+			vk::DescriptorType::eStorageBuffer
+		),
+		pipeline(
+			make_pipeline(
+				context,
+				context.subgroup_arithmetic ? Kernel::eReduceSubgroup : Kernel::eReduce,
+				internal::reduce_bindings,
+				internal::primitive_specialization( workgroup_size, operation, items_per_invocation ),
+				kernel_directory
+			)
+		),
+		sets( context )
+	{}
+
+	void Reduction::record(
+		const vk::raii::CommandBuffer& buffer,
+		const Buffer& input,
+		const uint32_t count,
+		const uint32_t first )
+	{
+		internal::check_count( count, max_elements );
+
+		vk::Buffer source { *input.buffer };
+		uint64_t source_offset { first };
+		uint32_t level_count { count };
+		uint64_t scratch_offset { 0 };
+		while( true )
+		{
+			const uint32_t groups { internal::blocks( level_count, block_size ) };
+			const bool last { groups == 1 };
+			const vk::Buffer destination { last ? *result_buffer.buffer : *scratch.buffer };
+			const uint64_t destination_offset { last ? 0 : scratch_offset };
+
+			const std::array<BufferBinding, 2> bindings { {
+				{ 0, vk::DescriptorType::eStorageBuffer, source },
+				{ 1, vk::DescriptorType::eStorageBuffer, destination }
+			} };
+			const vk::DescriptorSet set { sets.get( pipeline, bindings ) };
+
+			for( uint32_t group { 0 }; group < groups; group += std::min( max_groups, groups - group ) )
+			{
+				const uint32_t chunk { std::min( max_groups, groups - group ) };
+				const uint64_t skipped { uint64_t( group ) * block_size };
+				const ReduceParameters parameters {
+					static_cast< uint32_t >( level_count - std::min<uint64_t>( skipped, level_count ) ),
+					static_cast< uint32_t >( source_offset + skipped ),
+					static_cast< uint32_t >( destination_offset + group )
+				};
+				record_dispatch( buffer, pipeline, set, chunk, 1, 1, push_constant_bytes( parameters ) );
+			}
+
+			if( last )
+				break;
+
+			internal::compute_barrier( buffer );
+			source = *scratch.buffer;
+			source_offset = destination_offset;
+			level_count = groups;
+			scratch_offset += groups;
+		}
+
+		internal::compute_barrier( buffer, vk::PipelineStageFlagBits::eHost, vk::AccessFlagBits::eHostRead );
+	}
+
+	uint32_t Reduction::result() const
+	{
+		result_buffer.invalidate();
+		return result_buffer.view<uint32_t>().front();
+	}
+
+	uint32_t Reduction::run(
+		QueueScheduler& scheduler,
+		const Buffer& input,
+		const uint32_t count,
+		const uint32_t first )
+	{
+		scheduler.submit(
+			[&]( const vk::raii::CommandBuffer& buffer )
+			{
+				record( buffer, input, count, first );
+			}
+		).wait();
+		return result();
+	}
+
+	void Reduction::evict( const Buffer& buffer )
+	{
+		sets.evict( *buffer.buffer );
+	}
+
+	/// SCAN
+
+	Scan::Scan(
+		const Context& context,
+		const ReduceOperation operation_,
+		const uint32_t max_elements_,
+		const std::filesystem::path& kernel_directory )
+		:
+		operation( operation_ ),
+		max_elements( max_elements_ ),
+		workgroup_size( internal::primitive_workgroup_size( context ) ),
+		block_size( workgroup_size * items_per_invocation ),
+		max_groups( context.properties.limits.maxComputeWorkGroupCount[0] ),
+		scratch(
+			[&]()
+			{
+				// block totals of every level, down to the single block
+				uint64_t elements { 0 };
+				uint64_t count { max_elements };
+				do
+				{
+					count = internal::blocks( count, block_size );
+					elements += count;
+				}
+				while( count > 1 );
+				return internal::scratch_buffer( context, elements );
+			}()
+		),
+		scan_blocks(
+			make_pipeline(
+				context,
+				context.subgroup_arithmetic ? Kernel::eScanSubgroup : Kernel::eScan,
+				internal::scan_bindings,
+				internal::primitive_specialization( workgroup_size, operation, items_per_invocation ).set( internal::phase_id, 0u ),
+				kernel_directory
+			)
+		),
+		add_block_prefix(
+			make_pipeline(
+				context,
+				context.subgroup_arithmetic ? Kernel::eScanSubgroup : Kernel::eScan,
+				internal::scan_bindings,
+				internal::primitive_specialization( workgroup_size, operation, items_per_invocation ).set( internal::phase_id, 1u ),
+				kernel_directory
+			)
+		),
+		sets( context )
+	{}
+
+	void Scan::record(
+		const vk::raii::CommandBuffer& buffer,
+		const Buffer& input,
+		const Buffer& output,
+		const uint32_t count,
+		const bool exclusive )
+	{
+		internal::check_count( count, max_elements );
+
+		struct Level
+		{
+			vk::Buffer source;
+			vk::Buffer destination;
+			uint64_t offset; // of both source and destination
+			uint32_t count;
+			uint32_t groups;
+			uint64_t sums_offset;
+			bool exclusive;
+		};
+
+		// level 0 is the data itself, level n + 1 the block totals of level n
+		std::vector<Level> levels;
+		levels.push_back( { *input.buffer, *output.buffer, 0, count, internal::blocks( count, block_size ), 0, exclusive } );
+		while( levels.back().groups > 1 )
+		{
+			const Level& previous { levels.back() };
+			levels.push_back( {
+				*scratch.buffer, *scratch.buffer, previous.sums_offset,
+				previous.groups, internal::blocks( previous.groups, block_size ),
+				previous.sums_offset + previous.groups, true
+			} );
+		}
+
+		const auto dispatch {
+			[&]( const Pipeline& pipeline, const Level& level )
+			{
+				const std::array<BufferBinding, 3> bindings { {
+					{ 0, vk::DescriptorType::eStorageBuffer, level.source },
+					{ 1, vk::DescriptorType::eStorageBuffer, level.destination },
+					{ 2, vk::DescriptorType::eStorageBuffer, *scratch.buffer }
+				} };
+				const vk::DescriptorSet set { sets.get( pipeline, bindings ) };
+
+				for( uint32_t group { 0 }; group < level.groups; group += std::min( max_groups, level.groups - group ) )
+				{
+					const uint32_t chunk { std::min( max_groups, level.groups - group ) };
+					const uint64_t skipped { uint64_t( group ) * block_size };
+					const ScanParameters parameters {
+						static_cast< uint32_t >( level.count - std::min<uint64_t>( skipped, level.count ) ),
+						static_cast< uint32_t >( level.offset + skipped ),
+						static_cast< uint32_t >( level.offset + skipped ),
+						static_cast< uint32_t >( level.sums_offset + group ),
+						level.exclusive ? 1u : 0u
+					};
+					record_dispatch( buffer, pipeline, set, chunk, 1, 1, push_constant_bytes( parameters ) );
+				}
+			}
+		};
+
+		// scan every block of every level, top down
+		for( std::size_t i { 0 }; i < levels.size(); ++i )
+		{
+			if( i > 0 )
+				internal::compute_barrier( buffer );
+			dispatch( scan_blocks, levels[i] );
+		}
+
+		// then combine each block with its (now scanned) total, bottom up
+		for( std::size_t i { levels.size() - 1 }; i-- > 0; )
+		{
+			internal::compute_barrier( buffer );
+			dispatch( add_block_prefix, levels[i] );
+		}
+
+		internal::compute_barrier(
+			buffer,
+			vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer,
+			vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eTransferRead
+		);
+	}
+
+	void Scan::run(
+		QueueScheduler& scheduler,
+		const Buffer& input,
+		const Buffer& output,
+		const uint32_t count,
+		const bool exclusive )
+	{
+		scheduler.submit(
+			[&]( const vk::raii::CommandBuffer& buffer )
+			{
+				record( buffer, input, output, count, exclusive );
+			}
+		).wait();
+	}
+
+	void Scan::evict( const Buffer& buffer )
+	{
+		sets.evict( *buffer.buffer );
+	}
+
+	/// RADIX SORT
+
+	RadixSort::RadixSort(
+		const Context& context,
+		const uint32_t max_elements_,
+		const bool with_values,
+		const std::filesystem::path& kernel_directory )
+		:
+		max_elements( max_elements_ ),
+		workgroup_size( internal::primitive_workgroup_size( context ) ),
+		block_size( workgroup_size * items_per_invocation ),
+		max_groups( context.properties.limits.maxComputeWorkGroupCount[0] ),
+		scratch_keys( internal::scratch_buffer( context, max_elements ) ),
+		scratch_values(
+			[&]()
+			{
+				std::optional<Buffer> values;
+				if( with_values )
+					values.emplace( internal::scratch_buffer( context, max_elements ) );
+				return values;
+			}()
+		),
+		histogram( internal::scratch_buffer( context, uint64_t( radix ) * internal::blocks( max_elements, block_size ) ) ),
+		count_digits(
+			make_pipeline(
+				context,
+				context.subgroup_arithmetic ? Kernel::eRadixSortSubgroup : Kernel::eRadixSort,
+				internal::radix_sort_bindings,
+				internal::primitive_specialization( workgroup_size, ReduceOperation::eSum, items_per_invocation )
+					.set( internal::phase_id, 0u ),
+				kernel_directory
+			)
+		),
+		scatter_keys(
+			make_pipeline(
+				context,
+				context.subgroup_arithmetic ? Kernel::eRadixSortSubgroup : Kernel::eRadixSort,
+				internal::radix_sort_bindings,
+				internal::primitive_specialization( workgroup_size, ReduceOperation::eSum, items_per_invocation )
+					.set( internal::phase_id, 1u ).set( internal::values_id, false ),
+				kernel_directory
+			)
+		),
+		scatter_pairs(
+			make_pipeline(
+				context,
+				context.subgroup_arithmetic ? Kernel::eRadixSortSubgroup : Kernel::eRadixSort,
+				internal::radix_sort_bindings,
+				internal::primitive_specialization( workgroup_size, ReduceOperation::eSum, items_per_invocation )
+					.set( internal::phase_id, 1u ).set( internal::values_id, true ),
+				kernel_directory
+			)
+		),
+		scan( context, ReduceOperation::eSum, radix * internal::blocks( max_elements, block_size ), kernel_directory ),
+		sets( context )
+	{}
+
+	void RadixSort::record_passes(
+		const vk::raii::CommandBuffer& buffer,
+		const Buffer& keys,
+		const Buffer* values,
+		const uint32_t count )
+	{
+		internal::check_count( count, max_elements );
+		if( count < 2 )
+			return;
+
+		const uint32_t groups { internal::blocks( count, block_size ) };
+		const Pipeline& scatter { values ? scatter_pairs : scatter_keys };
+
+		// keys-only passes bind the keys again in the value slots, which the kernel never touches
+		vk::Buffer keys_in { *keys.buffer };
+		vk::Buffer keys_out { *scratch_keys.buffer };
+		vk::Buffer values_in { values ? *values->buffer : keys_in };
+		vk::Buffer values_out { values ? *scratch_values->buffer : keys_out };
+
+		const auto dispatch {
+			[&]( const Pipeline& pipeline, const uint32_t shift )
+			{
+				const std::array<BufferBinding, 5> bindings { {
+					{ 0, vk::DescriptorType::eStorageBuffer, keys_in },
+					{ 1, vk::DescriptorType::eStorageBuffer, keys_out },
+					{ 2, vk::DescriptorType::eStorageBuffer, *histogram.buffer },
+					{ 3, vk::DescriptorType::eStorageBuffer, values_in },
+					{ 4, vk::DescriptorType::eStorageBuffer, values_out }
+				} };
+				const vk::DescriptorSet set { sets.get( pipeline, bindings ) };
+
+				for( uint32_t group { 0 }; group < groups; group += std::min( max_groups, groups - group ) )
+				{
+					const RadixSortParameters parameters { count, shift, groups, group };
+					record_dispatch( buffer, pipeline, set, std::min( max_groups, groups - group ), 1, 1, push_constant_bytes( parameters ) );
+				}
+			}
+		};
+
+		for( uint32_t shift { 0 }; shift < 32; shift += radix_bits )
+		{
+			if( shift > 0 )
+				internal::compute_barrier( buffer );
+
+			dispatch( count_digits, shift );
+			internal::compute_barrier( buffer );
+
+			// digit major, so the exclusive scan gives every (digit, block) its first output slot
+			scan.record( buffer, histogram, histogram, radix * groups, true );
+
+			dispatch( scatter, shift );
+
+			std::swap( keys_in, keys_out );
+			std::swap( values_in, values_out );
+		}
+
+		internal::compute_barrier(
+			buffer,
+			vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer,
+			vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eTransferRead
+		);
+	}
+
+	void RadixSort::record(
+		const vk::raii::CommandBuffer& buffer,
+		const Buffer& keys,
+		const uint32_t count )
+	{
+		record_passes( buffer, keys, nullptr, count );
+	}
+
+	void RadixSort::record(
+		const vk::raii::CommandBuffer& buffer,
+		const Buffer& keys,
+		const Buffer& values,
+		const uint32_t count )
+	{
+		if( !scratch_values )
+		{
+			throw std::invalid_argument( "RadixSort was created without with_values and can't sort key/value pairs." );
+		}
+		record_passes( buffer, keys, &values, count );
+	}
+
+	void RadixSort::run( QueueScheduler& scheduler, const Buffer& keys, const uint32_t count )
+	{
+		scheduler.submit(
+			[&]( const vk::raii::CommandBuffer& buffer )
+			{
+				record( buffer, keys, count );
+			}
+		).wait();
+	}
+
+	void RadixSort::run( QueueScheduler& scheduler, const Buffer& keys, const Buffer& values, const uint32_t count )
+	{
+		scheduler.submit(
+			[&]( const vk::raii::CommandBuffer& buffer )
+			{
+				record( buffer, keys, values, count );
+			}
+		).wait();
+	}
+
+	void RadixSort::evict( const Buffer& buffer )
+	{
+		sets.evict( *buffer.buffer );
+	}
+
+}
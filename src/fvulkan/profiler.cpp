@@ -0,0 +1,411 @@
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <tuple> // ignore
+#include <utility>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include <fgl/vulkan/commandqueue.hpp>
+#include <fgl/vulkan/profiler.hpp>
+#include <fgl/vulkan/internal/file.hpp>
+
+namespace fgl::vulkan
+{
+	namespace internal
+	{
+		std::vector<uint32_t> timestamp_valid_bits( const vk::raii::PhysicalDevice& physical_device )
+		{
+			std::vector<uint32_t> bits;
+			for( const auto& family : physical_device.getQueueFamilyProperties() )
+				bits.emplace_back( family.timestampValidBits );
+
+			return bits;
+		}
+
+		std::vector<vk::QueueFlags> queue_family_flags( const vk::raii::PhysicalDevice& physical_device )
+		{
+			std::vector<vk::QueueFlags> flags;
+			for( const auto& family : physical_device.getQueueFamilyProperties() )
+				flags.emplace_back( family.queueFlags );
+
+			return flags;
+		}
+
+		std::optional<vk::raii::QueryPool> create_statistics_pool(
+			const Context& context,
+			const uint32_t capacity,
+			const bool enabled )
+		{
+			if( !enabled || !context.features.pipeline_statistics_query )
+				return std::nullopt;
+
+			return vk::raii::QueryPool(
+				context.device,
+				vk::QueryPoolCreateInfo(
+					{}, vk::QueryType::ePipelineStatistics, capacity,
+					vk::QueryPipelineStatisticFlagBits::eComputeShaderInvocations
+				)
+			);
+		}
+
+		uint64_t timestamp_mask( const uint32_t valid_bits )
+		{
+			return valid_bits >= 64 ? ~uint64_t { 0 } : ( uint64_t { 1 } << valid_bits ) - 1;
+		}
+
+		std::string json_escape( const std::string_view text )
+		{
+			std::string escaped;
+			escaped.reserve( text.size() );
+			for( const char c : text )
+			{
+				switch( c )
+				{
+					case '"': escaped += "\\\""; break;
+					case '\\': escaped += "\\\\"; break;
+					case '\n': escaped += "\\n"; break;
+					case '\t': escaped += "\\t"; break;
+					default: escaped += c;
+				}
+			}
+			return escaped;
+		}
+
+		// nearest-rank percentile of sorted samples
+		double percentile( const std::vector<double>& sorted, const double fraction )
+		{
+			const auto rank { static_cast< std::size_t >( std::ceil( fraction * static_cast< double >( sorted.size() ) ) ) };
+			return sorted[std::clamp<std::size_t>( rank, 1, sorted.size() ) - 1];
+		}
+	} // namespace internal
+
+	Profiler::Profiler(
+		const Context& context_,
+		const uint32_t capacity_,
+		const bool pipeline_statistics )
+		:
+		context( context_ ),
+		timestamp_valid_bits( internal::timestamp_valid_bits( context.physical_device ) ),
+		queue_flags( internal::queue_family_flags( context.physical_device ) ),
+		host_reset( context.features.host_query_reset ),
+		timestamp_period( static_cast< double >( context.properties.limits.timestampPeriod ) ),
+		timestamps( context.device, vk::QueryPoolCreateInfo( {}, vk::QueryType::eTimestamp, 2 * capacity_ ) ),
+		statistics( internal::create_statistics_pool( context, capacity_, pipeline_statistics ) ),
+		origin( clock::now() ),
+		slots( capacity_ ),
+		resolved_ticks( capacity_ ),
+		capacity( capacity_ )
+	{
+		free_slots.reserve( capacity );
+		for( uint32_t slot { capacity }; slot > 0; --slot )
+			free_slots.emplace_back( slot - 1 );
+
+		if( host_reset )
+		{
+			timestamps.reset( 0, 2 * capacity );
+			if( statistics )
+				statistics->reset( 0, capacity );
+		}
+
+		if( supports( context.queue_family_index ) )
+			calibrate();
+	}
+
+	bool Profiler::supports( const uint32_t queue_family_index ) const
+	{
+		if( queue_family_index >= timestamp_valid_bits.size() || timestamp_valid_bits[queue_family_index] == 0 )
+			return false;
+
+		// vkCmdResetQueryPool is for graphics and compute queues only
+		return host_reset || ( queue_flags[queue_family_index] & ( vk::QueueFlagBits::eCompute | vk::QueueFlagBits::eGraphics ) );
+	}
+
+	void Profiler::calibrate()
+	{
+		const vk::raii::Queue queue( context.device, context.queue_family_index, 0 );
+		const vk::raii::CommandPool pool(
+			context.device,
+			vk::CommandPoolCreateInfo( vk::CommandPoolCreateFlagBits::eTransient, context.queue_family_index )
+		);
+		const vk::raii::CommandBuffers buffers(
+			context.device,
+			vk::CommandBufferAllocateInfo( *pool, vk::CommandBufferLevel::ePrimary, 1 )
+		);
+		const vk::raii::CommandBuffer& buffer { buffers.front() };
+		const vk::raii::Fence fence( context.device, vk::FenceCreateInfo() );
+
+		buffer.begin( vk::CommandBufferBeginInfo( vk::CommandBufferUsageFlagBits::eOneTimeSubmit ) );
+		if( !host_reset )
+		{
+			// every query starts out reset, so resolve() never reads one that was never written
+			buffer.resetQueryPool( *timestamps, 0, 2 * capacity );
+			if( statistics )
+				buffer.resetQueryPool( **statistics, 0, capacity );
+		}
+		buffer.writeTimestamp( vk::PipelineStageFlagBits::eBottomOfPipe, *timestamps, 0 );
+		buffer.end();
+
+		const vk::CommandBuffer handle { *buffer };
+		const auto before { clock::now() };
+		queue.submit( vk::SubmitInfo( nullptr, nullptr, handle ), *fence );
+		std::ignore = context.device.waitForFences( { *fence }, VK_TRUE, std::numeric_limits<uint64_t>::max() );
+		const auto after { clock::now() };
+
+		const auto [result, ticks] {
+			timestamps.getResults<uint64_t>(
+				0, 1, sizeof( uint64_t ), sizeof( uint64_t ),
+				vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait
+			)
+		};
+
+		// the timestamp landed somewhere between submit and the fence; assume the middle
+		calibration_time = before + ( after - before ) / 2;
+		calibration_tick = ticks.front();
+
+		// without host_reset slot 0's end query stays unavailable until its first span resets it
+		if( host_reset )
+			timestamps.reset( 0, 1 );
+	}
+
+	double Profiler::host_microseconds( const uint64_t tick ) const
+	{
+		const std::chrono::duration<double, std::micro> calibrated { calibration_time - origin };
+		const auto delta { static_cast< int64_t >( tick - calibration_tick ) };
+		return calibrated.count() + static_cast< double >( delta ) * timestamp_period / 1000.0;
+	}
+
+	uint32_t Profiler::begin(
+		const vk::raii::CommandBuffer& buffer,
+		std::string name,
+		const bool compute,
+		const std::optional<uint32_t> queue_family_index )
+	{
+		const uint32_t family { queue_family_index.value_or( context.queue_family_index ) };
+		if( !supports( family ) )
+			throw std::invalid_argument( "Profiler: spans can't be recorded for this queue family." );
+
+		const bool with_statistics { compute && statistics.has_value() };
+
+		uint32_t slot {};
+		{
+			std::scoped_lock lock( mutex );
+			if( free_slots.empty() )
+				throw std::length_error( "Profiler: every span is waiting for resolve()." );
+
+			slot = free_slots.back();
+			free_slots.pop_back();
+			slots[slot] = Span { std::move( name ), with_statistics, family };
+		}
+
+		/* With host_reset the slot was reset when it was freed. Otherwise
+			the reset runs with the span, and until then resolve() tells the
+			slot's old results apart by resolved_ticks.*/
+		if( !host_reset )
+		{
+			buffer.resetQueryPool( *timestamps, 2 * slot, 2 );
+			if( with_statistics )
+				buffer.resetQueryPool( **statistics, slot, 1 );
+		}
+
+		buffer.writeTimestamp( vk::PipelineStageFlagBits::eTopOfPipe, *timestamps, 2 * slot );
+		if( with_statistics )
+			buffer.beginQuery( **statistics, slot, {} );
+
+		return slot;
+	}
+
+	void Profiler::end( const vk::raii::CommandBuffer& buffer, const uint32_t span )
+	{
+		bool with_statistics {};
+		{
+			std::scoped_lock lock( mutex );
+			with_statistics = slots.at( span ).value().statistics;
+		}
+
+		if( with_statistics )
+			buffer.endQuery( **statistics, span );
+
+		buffer.writeTimestamp( vk::PipelineStageFlagBits::eBottomOfPipe, *timestamps, 2 * span + 1 );
+	}
+
+	void Profiler::discard( const uint32_t span )
+	{
+		std::scoped_lock lock( mutex );
+		if( slots.at( span ).has_value() )
+			release( span );
+	}
+
+	void Profiler::release( const uint32_t slot )
+	{
+		if( host_reset )
+		{
+			timestamps.reset( 2 * slot, 2 );
+			if( statistics )
+				statistics->reset( slot, 1 );
+		}
+
+		slots[slot].reset();
+		free_slots.emplace_back( slot );
+	}
+
+	void Profiler::record_dispatch(
+		const vk::raii::CommandBuffer& buffer,
+		std::string name,
+		const Pipeline& pipeline,
+		const uint32_t groupCountX,
+		const uint32_t groupCountY,
+		const uint32_t groupCountZ,
+		const std::span<const std::byte> push_constants )
+	{
+		const uint32_t span { begin( buffer, std::move( name ) ) };
+		fgl::vulkan::record_dispatch( buffer, pipeline, groupCountX, groupCountY, groupCountZ, push_constants );
+		end( buffer, span );
+	}
+
+	std::size_t Profiler::resolve()
+	{
+		using enum vk::QueryResultFlagBits;
+
+		std::scoped_lock lock( mutex );
+
+		std::size_t resolved { 0 };
+		for( uint32_t slot { 0 }; slot < capacity; ++slot )
+		{
+			if( !slots[slot] )
+				continue;
+
+			// value/availability pairs: begin, end
+			const auto [time_result, stamps] {
+				timestamps.getResults<uint64_t>(
+					2 * slot, 2, 4 * sizeof( uint64_t ), 2 * sizeof( uint64_t ), e64 | eWithAvailability
+				)
+			};
+			if( stamps[1] == 0 || stamps[3] == 0 )
+				continue;
+
+			// still what the slot's previous span wrote, its reset hasn't executed yet
+			if( !host_reset && resolved_ticks[slot] == std::array { stamps[0], stamps[2] } )
+				continue;
+
+			std::optional<uint64_t> invocations {};
+			if( slots[slot]->statistics )
+			{
+				const auto [statistics_result, counts] {
+					statistics->getResults<uint64_t>(
+						slot, 1, 2 * sizeof( uint64_t ), 2 * sizeof( uint64_t ), e64 | eWithAvailability
+					)
+				};
+				if( counts[1] == 0 )
+					continue;
+
+				invocations = counts[0];
+			}
+
+			const uint64_t mask { internal::timestamp_mask( timestamp_valid_bits[slots[slot]->queue_family_index] ) };
+			const uint64_t ticks { ( stamps[2] - stamps[0] ) & mask };
+			const double milliseconds { static_cast< double >( ticks ) * timestamp_period / 1e6 };
+
+			Samples& kernel { samples[slots[slot]->name] };
+			kernel.milliseconds.emplace_back( milliseconds );
+			if( invocations )
+				kernel.invocations.emplace_back( *invocations );
+
+			events.push_back( { std::move( slots[slot]->name ), true, host_microseconds( stamps[0] ), milliseconds * 1000.0 } );
+
+			resolved_ticks[slot] = { stamps[0], stamps[2] };
+			release( slot );
+			++resolved;
+		}
+		return resolved;
+	}
+
+	void Profiler::add_cpu_span( std::string name, const clock::time_point start, const clock::time_point stop )
+	{
+		const std::chrono::duration<double, std::micro> offset { start - origin };
+		const std::chrono::duration<double, std::micro> duration { stop - start };
+
+		std::scoped_lock lock( mutex );
+		events.push_back( { std::move( name ), false, offset.count(), duration.count() } );
+	}
+
+	std::map<std::string, Profiler::KernelStatistics> Profiler::kernel_statistics() const
+	{
+		std::scoped_lock lock( mutex );
+
+		std::map<std::string, KernelStatistics> result;
+		for( const auto& [name, kernel] : samples )
+		{
+			std::vector<double> sorted { kernel.milliseconds };
+			std::ranges::sort( sorted );
+
+			KernelStatistics& stats { result[name] };
+			stats.runs = sorted.size();
+			stats.min_ms = sorted.front();
+			stats.median_ms = internal::percentile( sorted, 0.5 );
+			stats.p99_ms = internal::percentile( sorted, 0.99 );
+
+			if( !kernel.invocations.empty() )
+			{
+				const auto total { std::accumulate( kernel.invocations.cbegin(), kernel.invocations.cend(), uint64_t { 0 } ) };
+				stats.invocations = static_cast< double >( total ) / static_cast< double >( kernel.invocations.size() );
+			}
+		}
+		return result;
+	}
+
+	void Profiler::print_statistics() const
+	{
+		std::cout << "\n\tGPU spans (ms):";
+		for( const auto& [name, stats] : kernel_statistics() )
+		{
+			std::cout
+				<< "\n\t\t" << std::left << std::setw( 24 ) << name << std::right
+				<< " runs " << std::setw( 6 ) << stats.runs
+				<< "  min " << std::setw( 10 ) << stats.min_ms
+				<< "  median " << std::setw( 10 ) << stats.median_ms
+				<< "  p99 " << std::setw( 10 ) << stats.p99_ms;
+
+			if( stats.invocations )
+				std::cout << "  invocations " << *stats.invocations;
+		}
+		std::cout << std::endl;
+	}
+
+	void Profiler::write_chrome_trace( const std::filesystem::path& path ) const
+	{
+		constexpr int cpu_track { 1 };
+		constexpr int gpu_track { 2 };
+
+		std::stringstream json;
+		json << std::fixed << std::setprecision( 3 );
+		json
+			<< "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+			<< "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << cpu_track << ",\"args\":{\"name\":\"CPU\"}},\n"
+			<< "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << gpu_track << ",\"args\":{\"name\":\"GPU\"}}";
+
+		{
+			std::scoped_lock lock( mutex );
+			for( const auto& event : events )
+			{
+				json
+					<< ",\n{\"name\":\"" << internal::json_escape( event.name ) << '"'
+					<< ",\"cat\":\"" << ( event.gpu ? "gpu" : "cpu" ) << '"'
+					<< ",\"ph\":\"X\",\"pid\":1,\"tid\":" << ( event.gpu ? gpu_track : cpu_track )
+					<< ",\"ts\":" << event.start_us
+					<< ",\"dur\":" << event.duration_us << '}';
+			}
+		}
+		json << "\n]}\n";
+
+		const std::string text { json.str() };
+		internal::write_atomically( path, std::as_bytes( std::span( text ) ) );
+	}
+
+}
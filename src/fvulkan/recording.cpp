@@ -0,0 +1,309 @@
+#include <algorithm>
+#include <tuple> // ignore
+#include <utility> // exchange, move
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include <fgl/vulkan/recording.hpp>
+
+namespace fgl::vulkan
+{
+
+	/// SECONDARY COMMANDS
+
+	SecondaryCommands::SecondaryCommands( CommandBufferPool& pool_, vk::raii::CommandBuffer&& buffer_ )
+		:
+		pool( &pool_ ),
+		command_buffer( std::move( buffer_ ) )
+	{}
+
+	SecondaryCommands::SecondaryCommands( SecondaryCommands&& other ) noexcept
+		:
+		pool( std::exchange( other.pool, nullptr ) ),
+		command_buffer( std::move( other.command_buffer ) )
+	{}
+
+	SecondaryCommands::~SecondaryCommands()
+	{
+		// freeing it here would need the pool, which another thread may be recording from
+		if( pool != nullptr )
+			pool->recycle_concurrently( std::move( command_buffer ) );
+	}
+
+	/// LEASE
+
+	ParallelRecorder::Lease::Lease( ParallelRecorder& recorder_ )
+		:
+		recorder( &recorder_ ),
+		pool( &recorder_.take_pool() )
+	{}
+
+	ParallelRecorder::Lease::Lease( Lease&& other ) noexcept
+		:
+		recorder( std::exchange( other.recorder, nullptr ) ),
+		pool( std::exchange( other.pool, nullptr ) )
+	{}
+
+	ParallelRecorder::Lease::~Lease()
+	{
+		if( recorder != nullptr )
+			recorder->return_pool( *pool );
+	}
+
+	SecondaryCommands ParallelRecorder::Lease::record( const Recorder& record ) const
+	{
+		// back to the pool (and reset on its next begin()) if record throws
+		SecondaryCommands commands( *pool, pool->acquire() );
+
+		// compute only, so there's no render pass to inherit
+		const vk::CommandBufferInheritanceInfo inheritance {};
+		commands.buffer().begin( vk::CommandBufferBeginInfo( vk::CommandBufferUsageFlagBits::eOneTimeSubmit, &inheritance ) );
+		record( commands.buffer() );
+		commands.buffer().end();
+
+		return commands;
+	}
+
+	/// PARALLEL RECORDER
+
+	ParallelRecorder::ParallelRecorder(
+		const Context& context_,
+		const std::size_t thread_count,
+		const uint32_t queue_index )
+		:
+		context( context_ ),
+		primaries( context, context.queue_family_index ),
+		queue( context, context.queue_family_index, queue_index ),
+		workers( thread_count )
+	{
+		// pools for the recording threads up front, so record_parallel() never creates one
+		for( std::size_t i { 0 }; i < workers.size(); ++i )
+		{
+			pools.emplace_back( std::make_unique<CommandBufferPool>( context, context.queue_family_index, vk::CommandBufferLevel::eSecondary ) );
+			idle_pools.emplace_back( pools.back().get() );
+		}
+
+		submitter = std::thread( &ParallelRecorder::submit_loop, this );
+	}
+
+	ParallelRecorder::~ParallelRecorder()
+	{
+		stopping.store( true, std::memory_order_release );
+		signals.fetch_add( 1, std::memory_order_release );
+		signals.notify_one();
+		submitter.join();
+
+		// the AsyncQueue drains itself, giving the buffers back while the pools still exist
+	}
+
+	CommandBufferPool& ParallelRecorder::take_pool()
+	{
+		std::scoped_lock lock( pools_mutex );
+		if( idle_pools.empty() )
+		{
+			// more threads leasing at once than ever before
+			pools.emplace_back( std::make_unique<CommandBufferPool>( context, context.queue_family_index, vk::CommandBufferLevel::eSecondary ) );
+			return *pools.back();
+		}
+
+		CommandBufferPool& pool { *idle_pools.back() };
+		idle_pools.pop_back();
+		return pool;
+	}
+
+	void ParallelRecorder::return_pool( CommandBufferPool& pool )
+	{
+		std::scoped_lock lock( pools_mutex );
+		idle_pools.emplace_back( &pool );
+	}
+
+	std::size_t ParallelRecorder::pool_count()
+	{
+		std::scoped_lock lock( pools_mutex );
+		return pools.size();
+	}
+
+	std::future<void> ParallelRecorder::submit(
+		std::vector<SecondaryCommands>&& commands,
+		std::function<void()> on_complete )
+	{
+		Submission submission { std::move( commands ), std::move( on_complete ), {} };
+		auto future { submission.promise.get_future() };
+
+		queued.fetch_add( 1, std::memory_order_relaxed );
+		submissions.push( std::move( submission ) );
+
+		// after the push, so a submitter that saw the old value finds the submission
+		signals.fetch_add( 1, std::memory_order_release );
+		signals.notify_one();
+
+		return future;
+	}
+
+	std::future<void> ParallelRecorder::record_parallel(
+		const std::span<const Recorder> jobs,
+		std::function<void()> on_complete )
+	{
+		const std::size_t runs { std::min( workers.size(), jobs.size() ) };
+
+		std::vector<std::future<std::vector<SecondaryCommands>>> recorded;
+		recorded.reserve( runs );
+		for( std::size_t run { 0 }; run < runs; ++run )
+		{
+			const std::size_t first { jobs.size() * run / runs };
+			const std::size_t last { jobs.size() * ( run + 1 ) / runs };
+			recorded.emplace_back(
+				workers.submit(
+					[this, part = jobs.subspan( first, last - first )]
+					{
+						const Lease leased( *this );
+						std::vector<SecondaryCommands> commands;
+						commands.reserve( part.size() );
+						for( const auto& job : part )
+							commands.emplace_back( leased.record( job ) );
+
+						return commands;
+					}
+				)
+			);
+		}
+
+		// every run is waited for before rethrowing, since they use this
+		std::vector<SecondaryCommands> commands;
+		commands.reserve( jobs.size() );
+		std::exception_ptr error {};
+		for( auto& run : recorded )
+		{
+			try
+			{
+				for( auto& part : run.get() )
+					commands.emplace_back( std::move( part ) );
+			}
+			catch( ... )
+			{
+				if( !error )
+					error = std::current_exception();
+			}
+		}
+
+		if( error )
+			std::rethrow_exception( error );
+
+		return submit( std::move( commands ), std::move( on_complete ) );
+	}
+
+	void ParallelRecorder::wait_idle()
+	{
+		const uint64_t target { queued.load( std::memory_order_relaxed ) };
+		for( uint64_t done { completed.load( std::memory_order_acquire ) }; done < target; done = completed.load( std::memory_order_acquire ) )
+			completed.wait( done, std::memory_order_acquire );
+	}
+
+	void ParallelRecorder::submit_loop()
+	{
+		std::vector<Submission> batch;
+		while( true )
+		{
+			// read before looking, so a push landing after the last pop() changes it
+			const uint64_t seen { signals.load( std::memory_order_acquire ) };
+
+			while( batch.size() < max_batch )
+			{
+				auto submission { submissions.pop() };
+				if( !submission )
+					break;
+				batch.emplace_back( std::move( *submission ) );
+			}
+
+			if( !batch.empty() )
+			{
+				flush( batch );
+				continue;
+			}
+
+			if( stopping.load( std::memory_order_acquire ) )
+				return;
+
+			signals.wait( seen, std::memory_order_acquire );
+		}
+	}
+
+	void ParallelRecorder::flush( std::vector<Submission>& batch )
+	{
+		// shared so the completion callback stays copyable for std::function
+		const auto pending { std::make_shared<std::vector<Submission>>( std::move( batch ) ) };
+		const auto used_primaries { std::make_shared<std::vector<vk::raii::CommandBuffer>>() };
+		batch.clear();
+
+		try
+		{
+			used_primaries->reserve( pending->size() );
+			std::vector<vk::CommandBuffer> handles;
+			handles.reserve( pending->size() );
+			std::vector<vk::CommandBuffer> secondaries;
+			for( const auto& submission : *pending )
+			{
+				const vk::raii::CommandBuffer& primary { used_primaries->emplace_back( primaries.acquire() ) };
+				primary.begin( vk::CommandBufferBeginInfo( vk::CommandBufferUsageFlagBits::eOneTimeSubmit ) );
+
+				secondaries.clear();
+				for( const auto& commands : submission.commands )
+					secondaries.emplace_back( *commands.buffer() );
+				if( !secondaries.empty() )
+					primary.executeCommands( secondaries );
+
+				primary.end();
+				handles.emplace_back( *primary );
+			}
+
+			queue_submits.fetch_add( 1, std::memory_order_relaxed );
+			// each submission has its own promise, so AsyncQueue's future isn't needed
+			std::ignore = queue.submit(
+				handles,
+				[this, pending, used_primaries]
+				{
+					complete( *pending, *used_primaries, {} );
+				}
+			);
+		}
+		catch( ... )
+		{
+			complete( *pending, *used_primaries, std::current_exception() );
+		}
+	}
+
+	void ParallelRecorder::complete(
+		std::vector<Submission>& finished,
+		std::vector<vk::raii::CommandBuffer>& used_primaries,
+		const std::exception_ptr& error )
+	{
+		for( auto& primary : used_primaries )
+			primaries.recycle_concurrently( std::move( primary ) );
+
+		for( auto& submission : finished )
+		{
+			submission.commands.clear(); // back to their pools
+
+			if( error )
+			{
+				submission.promise.set_exception( error );
+				continue;
+			}
+
+			try
+			{
+				if( submission.on_complete )
+					submission.on_complete();
+				submission.promise.set_value();
+			}
+			catch( ... )
+			{
+				submission.promise.set_exception( std::current_exception() );
+			}
+		}
+
+		completed.fetch_add( finished.size(), std::memory_order_release );
+		completed.notify_all();
+	}
+
+}
@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <future>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <tuple> // ignore
+#include <utility>
+
+#include <fgl/vulkan/registry.hpp>
+
+namespace fgl::vulkan
+{
+
+	PipelineRegistry::Entry::Entry( std::function<std::unique_ptr<Pipeline>()>&& build_ )
+		:
+		build( std::move( build_ ) )
+	{}
+
+	PipelineRegistry::PipelineRegistry( const std::size_t thread_count )
+		:
+		pool( thread_count )
+	{}
+
+	void PipelineRegistry::add( std::string&& name, std::function<std::unique_ptr<Pipeline>()>&& build )
+	{
+		std::scoped_lock lock( mutex );
+		const auto [it, inserted] {
+			entries.try_emplace( std::move( name ), std::make_unique<Entry>( std::move( build ) ) )
+		};
+
+		if( !inserted )
+		{
+			std::stringstream ss;
+			ss << "PipelineRegistry: a pipeline named \"" << it->first << "\" already exists";
+			throw std::runtime_error( ss.str() );
+		}
+	}
+
+	bool PipelineRegistry::contains( const std::string_view name ) const
+	{
+		std::scoped_lock lock( mutex );
+		return entries.contains( name );
+	}
+
+	PipelineRegistry::Entry& PipelineRegistry::find( const std::string_view name ) const
+	{
+		std::scoped_lock lock( mutex );
+		if( const auto it { entries.find( name ) }; it != entries.cend() )
+			return *it->second;
+
+		std::stringstream ss;
+		ss << "PipelineRegistry: no pipeline named \"" << name << '"';
+		throw std::out_of_range( ss.str() );
+	}
+
+	std::vector<PipelineRegistry::Entry*> PipelineRegistry::lookup( const std::span<const std::string> names ) const
+	{
+		std::vector<Entry*> found;
+		found.reserve( names.size() );
+		for( const auto& name : names )
+			found.emplace_back( &find( name ) );
+
+		return found;
+	}
+
+	void PipelineRegistry::compile( Entry& entry )
+	{
+		// call_once lets a later caller retry when a build threw
+		std::call_once( entry.once,
+			[this, &entry]
+			{
+				const auto start { std::chrono::steady_clock::now() };
+				auto pipeline { entry.build() };
+				const auto duration { std::chrono::steady_clock::now() - start };
+
+				std::scoped_lock lock( mutex );
+				entry.pipeline = std::move( pipeline );
+				entry.compile_time = std::chrono::duration_cast<std::chrono::nanoseconds>( duration );
+			}
+		);
+	}
+
+	void PipelineRegistry::compile( const std::span<const std::string> names )
+	{
+		std::vector<std::future<void>> pending;
+		pending.reserve( names.size() );
+		for( Entry* entry : lookup( names ) )
+			pending.emplace_back( pool.submit( [this, entry] { compile( *entry ); } ) );
+
+		// wait for all of them before rethrowing so nothing outlives this call
+		std::exception_ptr error {};
+		for( auto& future : pending )
+		{
+			try
+			{
+				future.get();
+			}
+			catch( ... )
+			{
+				if( !error )
+					error = std::current_exception();
+			}
+		}
+
+		if( error )
+			std::rethrow_exception( error );
+	}
+
+	void PipelineRegistry::compile_all()
+	{
+		std::vector<std::string> names;
+		{
+			std::scoped_lock lock( mutex );
+			names.reserve( entries.size() );
+			for( const auto& [name, entry] : entries )
+				names.emplace_back( name );
+		}
+		compile( names );
+	}
+
+	void PipelineRegistry::warm_up( const std::span<const std::string> names )
+	{
+		for( Entry* entry : lookup( names ) )
+		{
+			// nobody waits on these; get() builds (and throws) again if the warm-up failed
+			std::ignore = pool.submit(
+				[this, entry]
+				{
+					try
+					{
+						compile( *entry );
+					}
+					catch( ... )
+					{}
+				}
+			);
+		}
+	}
+
+	const Pipeline& PipelineRegistry::get( const std::string_view name )
+	{
+		Entry& entry { find( name ) };
+		compile( entry );
+		return *entry.pipeline;
+	}
+
+	std::vector<PipelineRegistry::CompileTime> PipelineRegistry::compile_times() const
+	{
+		std::vector<CompileTime> times;
+		{
+			std::scoped_lock lock( mutex );
+			for( const auto& [name, entry] : entries )
+			{
+				if( entry->pipeline )
+					times.emplace_back( name, entry->compile_time );
+			}
+		}
+
+		std::ranges::sort( times, std::ranges::greater {}, &CompileTime::duration );
+		return times;
+	}
+
+	void PipelineRegistry::print_compile_times() const
+	{
+		using std::chrono::duration_cast, std::chrono::microseconds;
+
+		const auto times { compile_times() };
+		std::cout << "\n\tCompiled " << times.size() << " pipeline(s) on " << pool.size() << " thread(s):";
+		for( const auto& [name, duration] : times )
+		{
+			std::cout << "\n\t\t" << name << ": " << duration_cast<microseconds>( duration ).count() << " us";
+		}
+		std::cout << std::endl;
+	}
+
+}
@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include <fgl/vulkan/scheduler.hpp>
+
+namespace fgl::vulkan
+{
+
+	QueueScheduler::Lane::Lane(
+		const Context& context,
+		const QueueFamily& family,
+		const uint32_t queue_index_ )
+		:
+		family_index( family.index ),
+		queue_index( queue_index_ ),
+		flags( family.flags ),
+		pool( context, family.index ),
+		queue( context, family.index, queue_index_ )
+	{}
+
+	QueueScheduler::QueueScheduler(
+		const Context& context,
+		const Policy policy_,
+		const vk::QueueFlags required,
+		const uint32_t max_queues_per_family )
+		:
+		policy( policy_ )
+	{
+		for( const auto& family : context.queue_families )
+		{
+			if( ( family.flags & required ) != required )
+				continue;
+
+			const uint32_t count {
+				max_queues_per_family == 0
+					? family.queue_count
+					: std::min( family.queue_count, max_queues_per_family )
+			};
+
+			for( uint32_t queue_index { 0 }; queue_index < count; ++queue_index )
+				lanes.emplace_back( std::make_unique<Lane>( context, family, queue_index ) );
+		}
+
+		if( lanes.empty() )
+		{
+			std::stringstream ss;
+			ss << "QueueScheduler: no queue family with " << vk::to_string( required );
+			throw std::runtime_error( ss.str() );
+		}
+	}
+
+	QueueScheduler::Lane& QueueScheduler::select( const vk::QueueFlags required )
+	{
+		// the cursor rotates the starting lane so ties don't all land on lane 0
+		const std::size_t start { cursor.fetch_add( 1, std::memory_order_relaxed ) };
+
+		Lane* best { nullptr };
+		std::size_t best_load { std::numeric_limits<std::size_t>::max() };
+
+		for( std::size_t i { 0 }; i < lanes.size(); ++i )
+		{
+			Lane& lane { *lanes[( start + i ) % lanes.size()] };
+			if( ( lane.flags & required ) != required )
+				continue;
+
+			if( policy == Policy::eRoundRobin )
+				return lane;
+
+			if( const auto load { lane.in_flight.load( std::memory_order_relaxed ) };
+				load < best_load )
+			{
+				best = &lane;
+				best_load = load;
+			}
+		}
+
+		if( best == nullptr )
+		{
+			std::stringstream ss;
+			ss << "QueueScheduler: no lane with " << vk::to_string( required );
+			throw std::runtime_error( ss.str() );
+		}
+		return *best;
+	}
+
+	std::future<void> QueueScheduler::submit(
+		const Recorder& record,
+		std::function<void()> on_complete,
+		const vk::QueueFlags required )
+	{
+		Lane& lane { select( required ) };
+
+		// std::function needs a copyable callable, so the buffer rides in a shared_ptr
+		std::shared_ptr<vk::raii::CommandBuffer> buffer;
+		{
+			std::scoped_lock lock( lane.pool_mutex );
+			buffer = std::make_shared<vk::raii::CommandBuffer>( lane.pool.acquire() );
+
+			try
+			{
+				buffer->begin( vk::CommandBufferBeginInfo( vk::CommandBufferUsageFlagBits::eOneTimeSubmit ) );
+				record( *buffer );
+				buffer->end();
+			}
+			catch( ... )
+			{
+				lane.pool.recycle( std::move( *buffer ) );
+				throw;
+			}
+		}
+
+		const auto release {
+			[&lane, buffer]
+			{
+				lane.in_flight.fetch_sub( 1, std::memory_order_relaxed );
+				std::scoped_lock lock( lane.pool_mutex );
+				lane.pool.recycle( std::move( *buffer ) );
+			}
+		};
+
+		lane.in_flight.fetch_add( 1, std::memory_order_relaxed );
+		lane.submitted.fetch_add( 1, std::memory_order_relaxed );
+
+		try
+		{
+			return lane.queue.submit(
+				*buffer,
+				[release, on_complete = std::move( on_complete )]
+				{
+					release();
+					if( on_complete )
+						on_complete();
+				}
+			);
+		}
+		catch( ... )
+		{
+			release();
+			throw;
+		}
+	}
+
+	std::future<void> QueueScheduler::dispatch(
+		const Pipeline& pipeline,
+		const uint32_t groupCountX,
+		const uint32_t groupCountY,
+		const uint32_t groupCountZ,
+		const std::span<const std::byte> push_constants )
+	{
+		return submit(
+			[&]( const vk::raii::CommandBuffer& buffer )
+			{
+				record_dispatch( buffer, pipeline, groupCountX, groupCountY, groupCountZ, push_constants );
+			}
+		);
+	}
+
+	void QueueScheduler::wait_idle()
+	{
+		for( auto& lane : lanes )
+			lane->queue.wait_idle();
+	}
+
+	std::vector<std::size_t> QueueScheduler::submissions() const
+	{
+		std::vector<std::size_t> counts;
+		counts.reserve( lanes.size() );
+		for( const auto& lane : lanes )
+			counts.emplace_back( lane->submitted.load( std::memory_order_relaxed ) );
+
+		return counts;
+	}
+
+	void QueueScheduler::print_lanes() const
+	{
+		for( std::size_t i { 0 }; i < lanes.size(); ++i )
+		{
+			const Lane& lane { *lanes[i] };
+			std::cout
+				<< "\tLane " << i
+				<< ": family " << lane.family_index
+				<< " queue " << lane.queue_index
+				<< ", " << lane.submitted.load( std::memory_order_relaxed ) << " job(s) submitted"
+				<< std::endl;
+		}
+	}
+
+}
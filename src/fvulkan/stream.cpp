@@ -0,0 +1,255 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include <fgl/vulkan/stream.hpp>
+
+namespace fgl::vulkan
+{
+
+	namespace internal
+	{
+		void check_tile_size( const Context& context, const vk::DeviceSize bytes )
+		{
+			if( bytes == 0 )
+				throw std::invalid_argument( "TileStream: tiles need at least one byte of output." );
+
+			if( bytes > context.properties.limits.maxStorageBufferRange )
+			{
+				std::stringstream msg;
+				msg << "TileStream: a tile of " << bytes << " bytes exceeds maxStorageBufferRange ("
+					<< context.properties.limits.maxStorageBufferRange << " bytes).";
+				throw std::length_error( msg.str() );
+			}
+		}
+
+		void write_tile( std::ostream& stream, const std::span<const std::byte> data )
+		{
+			stream.write( reinterpret_cast< const char* >( data.data() ), static_cast< std::streamsize >( data.size() ) );
+			if( !stream )
+				throw std::runtime_error( "TileStream: writing a tile to the stream failed." );
+		}
+
+		double seconds_since( const std::chrono::steady_clock::time_point start )
+		{
+			return std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+		}
+	} // namespace internal
+
+	TileStream::Slot::Slot( const Context& context, const vk::DeviceSize bytes )
+		:
+		output(
+			context,
+			bytes,
+			vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferSrc,
+			vk::SharingMode::eConcurrent,
+			0,
+			vk::MemoryPropertyFlagBits::eDeviceLocal,
+			vk::DescriptorType::eStorageBuffer
+		),
+		readback(
+			context,
+			bytes,
+			vk::BufferUsageFlagBits::eTransferDst,
+			vk::SharingMode::eConcurrent,
+			0, // not bound to a descriptor
+			vk::MemoryPropertyFlagBits::eHostVisible,
+			vk::DescriptorType::eStorageBuffer,
+			vk::MemoryPropertyFlagBits::eHostCached
+		)
+	{}
+
+	TileStream::TileStream(
+		const Context& context,
+		QueueScheduler& scheduler_,
+		const uint32_t units_per_tile_,
+		const vk::DeviceSize bytes_per_unit_,
+		const std::size_t depth )
+		:
+		scheduler( scheduler_ ),
+		units_per_tile( units_per_tile_ ),
+		bytes_per_unit( bytes_per_unit_ )
+	{
+		internal::check_tile_size( context, vk::DeviceSize( units_per_tile ) * bytes_per_unit );
+
+		slots.reserve( std::max<std::size_t>( depth, 1 ) );
+		for( std::size_t i { 0 }; i < std::max<std::size_t>( depth, 1 ); ++i )
+			slots.emplace_back( context, vk::DeviceSize( units_per_tile ) * bytes_per_unit );
+	}
+
+	TileStream::~TileStream()
+	{
+		for( auto& slot : slots )
+		{
+			try
+			{
+				if( slot.done.valid() )
+					slot.done.get();
+			}
+			catch( ... )
+			{
+				// the device is most likely lost, nothing to hand to a sink anyway
+			}
+		}
+	}
+
+	void TileStream::drain( Slot& slot, const Sink& sink, Statistics& statistics )
+	{
+		if( !slot.tile )
+			return;
+
+		const auto wait_start { std::chrono::steady_clock::now() };
+		const Tile tile { *slot.tile };
+		slot.tile.reset();
+		slot.done.get();
+		statistics.wait_seconds += internal::seconds_since( wait_start );
+
+		const auto sink_start { std::chrono::steady_clock::now() };
+		slot.readback.invalidate( 0, tile.bytes );
+		sink( tile, std::span<const std::byte>( slot.readback.view<std::byte>().first( tile.bytes ) ) );
+		statistics.sink_seconds += internal::seconds_since( sink_start );
+
+		++statistics.tiles;
+		statistics.bytes += tile.bytes;
+	}
+
+	TileStream::Statistics TileStream::run(
+		const uint64_t extent,
+		const Recorder& record,
+		const Sink& sink )
+	{
+		Statistics statistics {};
+		const auto start { std::chrono::steady_clock::now() };
+
+		try
+		{
+			uint64_t index { 0 };
+			for( uint64_t first { 0 }; first < extent; first += units_per_tile, ++index )
+			{
+				Slot& slot { slots[index % slots.size()] };
+				drain( slot, sink, statistics );
+
+				const uint32_t count { static_cast< uint32_t >( std::min<uint64_t>( units_per_tile, extent - first ) ) };
+				const Tile tile { index, first, count, vk::DeviceSize( count ) * bytes_per_unit };
+
+				slot.done = scheduler.submit(
+					[&]( const vk::raii::CommandBuffer& buffer )
+					{
+						record( buffer, tile, slot.output );
+
+						const vk::MemoryBarrier written(
+							vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eTransferRead
+						);
+						buffer.pipelineBarrier(
+							vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eTransfer,
+							{}, written, nullptr, nullptr
+						);
+
+						buffer.copyBuffer( *slot.output.buffer, *slot.readback.buffer, vk::BufferCopy( 0, 0, tile.bytes ) );
+
+						const vk::MemoryBarrier copied(
+							vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eHostRead
+						);
+						buffer.pipelineBarrier(
+							vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost,
+							{}, copied, nullptr, nullptr
+						);
+					}
+				);
+				slot.tile = tile;
+			}
+
+			// the oldest tile sits in the slot after the last one used
+			for( std::size_t i { 0 }; i < slots.size(); ++i )
+				drain( slots[( index + i ) % slots.size()], sink, statistics );
+		}
+		catch( ... )
+		{
+			// the slots' buffers have to stay put until the device is done with them
+			for( auto& slot : slots )
+			{
+				slot.tile.reset();
+				try
+				{
+					if( slot.done.valid() )
+						slot.done.get();
+				}
+				catch( ... )
+				{
+				}
+			}
+			throw;
+		}
+
+		statistics.seconds = internal::seconds_since( start );
+		return statistics;
+	}
+
+	uint32_t fit_tile_units(
+		const Context& context,
+		const vk::DeviceSize bytes_per_unit,
+		const vk::DeviceSize budget_bytes,
+		const uint32_t granularity,
+		const std::size_t depth )
+	{
+		if( bytes_per_unit == 0 || granularity == 0 )
+			throw std::invalid_argument( "fit_tile_units: bytes_per_unit and granularity must be positive." );
+
+		// every slot holds a device local and a readback copy of its tile
+		const vk::DeviceSize per_tile { budget_bytes / ( 2 * std::max<std::size_t>( depth, 1 ) ) };
+		const vk::DeviceSize tile_bytes { std::min<vk::DeviceSize>( per_tile, context.properties.limits.maxStorageBufferRange ) };
+
+		const vk::DeviceSize units { std::min<vk::DeviceSize>( tile_bytes / bytes_per_unit, std::numeric_limits<uint32_t>::max() ) };
+		return std::max( granularity, static_cast< uint32_t >( units / granularity * granularity ) );
+	}
+
+	TileStream::Sink ostream_sink( std::ostream& stream )
+	{
+		return [&stream]( const TileStream::Tile&, const std::span<const std::byte> data )
+		{
+			internal::write_tile( stream, data );
+		};
+	}
+
+	TileStream::Sink file_sink( const std::filesystem::path& path )
+	{
+		// shared so the sink stays copyable as std::function requires
+		auto file { std::make_shared<std::ofstream>( path, std::ios::binary | std::ios::trunc ) };
+		if( !*file )
+		{
+			std::stringstream msg;
+			msg << "TileStream: couldn't open " << path << " for writing.";
+			throw std::runtime_error( msg.str() );
+		}
+
+		return [file]( const TileStream::Tile&, const std::span<const std::byte> data )
+		{
+			internal::write_tile( *file, data );
+		};
+	}
+
+	TileStream::Sink mapped_file_sink( const MappedFile& file, const std::size_t offset )
+	{
+		const std::span<std::byte> bytes { file.writable_bytes() };
+		return [bytes, offset]( const TileStream::Tile& tile, const std::span<const std::byte> data )
+		{
+			// tiles hold whole units, so the size of one follows from any tile
+			const std::size_t position { offset + static_cast< std::size_t >( tile.first * ( tile.bytes / tile.count ) ) };
+			if( position > bytes.size() || data.size() > bytes.size() - position )
+				throw std::out_of_range( "TileStream: tile past the end of the mapped file." );
+
+			std::memcpy( bytes.data() + position, data.data(), data.size() );
+		};
+	}
+
+}
@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <tuple> // ignore
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include <fgl/vulkan/task.hpp>
+
+namespace fgl::vulkan
+{
+
+	EventLoop::EventLoop(
+		const Context& context_,
+		const uint32_t queue_family_index,
+		const uint32_t queue_index )
+		:
+		context( context_ ),
+		queue( context.device, queue_family_index, queue_index ),
+		fences( context )
+	{}
+
+	EventLoop::~EventLoop()
+	{
+		if( in_flight.empty() )
+			return;
+
+		std::vector<vk::Fence> handles {};
+		for( const auto& operation : in_flight )
+			handles.emplace_back( *operation.fence );
+
+		constexpr uint64_t timeout { std::numeric_limits<uint64_t>::max() };
+		std::ignore = context.device.waitForFences( handles, VK_TRUE, timeout );
+	}
+
+	EventLoop::Operation EventLoop::submit( const std::span<const vk::CommandBuffer> buffers )
+	{
+		auto fence { fences.acquire() };
+
+		const vk::ArrayProxyNoTemporaries<const vk::CommandBuffer> command_buffers(
+			static_cast< uint32_t >( buffers.size() ), buffers.data()
+		);
+		const vk::SubmitInfo submit_info( nullptr, nullptr, command_buffers, nullptr );
+		queue.submit( submit_info, *fence );
+
+		auto completion { std::make_shared<Completion>() };
+		in_flight.emplace_back( std::move( fence ), completion );
+		return Operation( std::move( completion ) );
+	}
+
+	EventLoop::Operation EventLoop::submit( const vk::raii::CommandBuffer& buffer )
+	{
+		const vk::CommandBuffer handle { *buffer };
+		return submit( std::span<const vk::CommandBuffer>( &handle, 1 ) );
+	}
+
+	EventLoop::Operation EventLoop::dispatch( const CommandQueue& command )
+	{
+		return submit( command.buffer );
+	}
+
+	EventLoop::Operation EventLoop::dispatch(
+		const CommandQueue& command,
+		const Pipeline& pipeline,
+		const uint32_t groupCountX,
+		const uint32_t groupCountY,
+		const uint32_t groupCountZ,
+		const std::span<const std::byte> push_constants )
+	{
+		command.record(
+			pipeline,
+			vk::CommandBufferUsageFlagBits::eOneTimeSubmit,
+			groupCountX,
+			groupCountY,
+			groupCountZ,
+			push_constants
+		);
+		return submit( command.buffer );
+	}
+
+	void EventLoop::spawn( Task<void>&& task )
+	{
+		ready.emplace_back( task.handle );
+		tasks.emplace_back( std::move( task ) );
+	}
+
+	void EventLoop::poll( const uint64_t timeout )
+	{
+		if( in_flight.empty() )
+			return;
+
+		std::vector<vk::Fence> handles {};
+		handles.reserve( in_flight.size() );
+		for( const auto& operation : in_flight )
+			handles.emplace_back( *operation.fence );
+
+		// wait for any one of them
+		if( context.device.waitForFences( handles, VK_FALSE, timeout ) == vk::Result::eTimeout )
+			return;
+
+		// swap-and-pop, so the order of what stays in flight changes
+		for( std::size_t i { 0 }; i < in_flight.size(); )
+		{
+			InFlight& operation { in_flight[i] };
+
+			constexpr uint64_t no_wait { 0 };
+			if( context.device.waitForFences( { *operation.fence }, VK_TRUE, no_wait ) != vk::Result::eSuccess )
+			{
+				++i;
+				continue;
+			}
+
+			operation.completion->done = true;
+			ready.insert( ready.end(), operation.completion->waiters.begin(), operation.completion->waiters.end() );
+			operation.completion->waiters.clear();
+
+			fences.release( std::move( operation.fence ) );
+			if( i + 1 != in_flight.size() )
+				operation = std::move( in_flight.back() );
+			in_flight.pop_back();
+		}
+	}
+
+	void EventLoop::resume_ready()
+	{
+		while( !ready.empty() )
+		{
+			const auto handle { ready.front() };
+			ready.pop_front();
+			handle.resume();
+		}
+	}
+
+	void EventLoop::run()
+	{
+		constexpr uint64_t timeout { std::numeric_limits<uint64_t>::max() };
+
+		while( true )
+		{
+			resume_ready();
+
+			// collect finished top level tasks
+			for( auto& task : tasks )
+			{
+				if( task.done() )
+					task.handle.promise().result(); // rethrows
+			}
+			std::erase_if( tasks, []( const Task<void>& task ) { return task.done(); } );
+
+			if( tasks.empty() )
+				return;
+
+			if( in_flight.empty() )
+				throw std::logic_error( "EventLoop has suspended tasks but nothing in flight." );
+
+			poll( timeout );
+		}
+	}
+
+}
@@ -0,0 +1,61 @@
+#include <algorithm>
+#include <utility> // move
+
+#include <fgl/vulkan/internal/thread_pool.hpp>
+
+namespace fgl::vulkan::internal
+{
+
+	ThreadPool::ThreadPool( const std::size_t thread_count )
+	{
+		const std::size_t count {
+			thread_count > 0
+				? thread_count
+				: std::max<std::size_t>( std::thread::hardware_concurrency(), 1 )
+		};
+
+		workers.reserve( count );
+		for( std::size_t i { 0 }; i < count; ++i )
+			workers.emplace_back( &ThreadPool::worker_loop, this );
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::scoped_lock lock( mutex );
+			stopping = true;
+		}
+		cv.notify_all();
+
+		for( auto& worker : workers )
+			worker.join();
+	}
+
+	void ThreadPool::enqueue( std::function<void()>&& job )
+	{
+		{
+			std::scoped_lock lock( mutex );
+			jobs.emplace_back( std::move( job ) );
+		}
+		cv.notify_one();
+	}
+
+	void ThreadPool::worker_loop()
+	{
+		std::unique_lock lock( mutex );
+		while( true )
+		{
+			cv.wait( lock, [this] { return stopping || !jobs.empty(); } );
+			if( jobs.empty() )
+				return; // stopping and drained
+
+			std::function<void()> job { std::move( jobs.front() ) };
+			jobs.pop_front();
+
+			lock.unlock();
+			job(); // exceptions end up in the job's future
+			lock.lock();
+		}
+	}
+
+} // namespace fgl::vulkan::internal
@@ -0,0 +1,404 @@
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <tuple> // ignore
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include <fgl/vulkan/profiler.hpp>
+#include <fgl/vulkan/transfer.hpp>
+
+namespace fgl::vulkan
+{
+	namespace internal
+	{
+		// keeps every copy region on a 16 byte boundary inside the staging buffer
+		constexpr vk::DeviceSize staging_alignment { 16 };
+
+		vk::raii::CommandBuffers create_transfer_command_buffers(
+			const vk::raii::Device& device,
+			const vk::raii::CommandPool& command_pool,
+			const uint32_t buffer_count )
+		{
+			const vk::CommandBufferAllocateInfo alloc_info(
+				*command_pool, vk::CommandBufferLevel::ePrimary, buffer_count
+			);
+			return vk::raii::CommandBuffers( device, alloc_info );
+		}
+
+		void check_range(
+			const Buffer& buffer,
+			const vk::DeviceSize offset,
+			const std::size_t bytesize )
+		{
+			if( offset > buffer.bytesize || bytesize > buffer.bytesize - offset )
+			{
+				throw std::out_of_range( "Transfer exceeds the size of the buffer." );
+			}
+		}
+	} // namespace internal
+
+	TransferEngine::Slot::Slot(
+		const Context& context,
+		const vk::DeviceSize staging_size,
+		vk::raii::CommandBuffer&& command_buffer_ )
+		:
+		staging(
+			context,
+			staging_size,
+			vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst,
+			vk::SharingMode::eExclusive,
+			0, // not bound to a descriptor
+			vk::MemoryPropertyFlagBits::eHostVisible,
+			vk::DescriptorType::eStorageBuffer,
+			vk::MemoryPropertyFlagBits::eHostCached
+		),
+		command_buffer( std::move( command_buffer_ ) ),
+		fence( context.device, vk::FenceCreateInfo() )
+	{}
+
+	TransferEngine::TransferEngine(
+		const Context& context_,
+		const vk::DeviceSize staging_size_,
+		const std::size_t ring_depth )
+		:
+		context( context_ ),
+		queue( context.device, context.transfer_queue_family_index, 0 ),
+		pool(
+			context.device,
+			vk::CommandPoolCreateInfo(
+				vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+				context.transfer_queue_family_index
+			)
+		),
+		staging_size( staging_size_ )
+	{
+		auto command_buffers {
+			internal::create_transfer_command_buffers(
+				context.device, pool, static_cast< uint32_t >( ring_depth )
+			)
+		};
+
+		slots.reserve( ring_depth );
+		for( auto& command_buffer : command_buffers )
+			slots.emplace_back( context, staging_size, std::move( command_buffer ) );
+	}
+
+	TransferEngine::~TransferEngine()
+	{
+		try
+		{
+			wait();
+		}
+		catch( ... )
+		{
+			// nothing sensible left to do; the device is most likely lost
+		}
+	}
+
+	void TransferEngine::prepare( Slot& slot )
+	{
+		if( slot.in_flight )
+		{
+			constexpr uint64_t timeout { std::numeric_limits<uint64_t>::max() };
+			std::ignore = context.device.waitForFences( { *slot.fence }, VK_TRUE, timeout );
+			complete( slot );
+		}
+
+		context.device.resetFences( { *slot.fence } );
+		slot.command_buffer.reset();
+		slot.command_buffer.begin( { vk::CommandBufferUsageFlagBits::eOneTimeSubmit } );
+		if( profiler != nullptr )
+			slot.span = profiler->begin( slot.command_buffer, "transfer", false, context.transfer_queue_family_index );
+		slot.used = 0;
+		slot.has_downloads = false;
+		slot.downloading = false;
+		slot.recording = true;
+	}
+
+	void TransferEngine::complete( Slot& slot )
+	{
+		const auto staging_bytes { slot.staging.view<std::byte>() };
+		for( const auto& [destination, staging_offset] : slot.downloads )
+		{
+			slot.staging.invalidate( staging_offset, destination.size() );
+			std::memcpy( destination.data(), staging_bytes.data() + staging_offset, destination.size() );
+		}
+		slot.downloads.clear();
+		slot.in_flight = false;
+	}
+
+	void TransferEngine::check_timeline() const
+	{
+		if( !context.features.timeline_semaphore )
+			throw std::logic_error( "TransferEngine: waiting on and signaling semaphores needs timeline semaphores." );
+	}
+
+	void TransferEngine::queue_submit(
+		const vk::CommandBuffer buffer,
+		const vk::Fence fence,
+		const std::optional<TimelinePoint>& signal )
+	{
+		if( waits.empty() && !signal )
+		{
+			const vk::SubmitInfo submit_info( nullptr, nullptr, buffer, nullptr );
+			queue.submit( submit_info, fence );
+			return;
+		}
+
+		std::vector<vk::Semaphore> wait_semaphores;
+		std::vector<uint64_t> wait_values;
+		for( const auto& [semaphore, value] : waits )
+		{
+			wait_semaphores.emplace_back( semaphore );
+			wait_values.emplace_back( value );
+		}
+		const std::vector<vk::PipelineStageFlags> wait_stages( waits.size(), vk::PipelineStageFlagBits::eTransfer );
+
+		const vk::Semaphore signal_semaphore { signal ? signal->semaphore : vk::Semaphore() };
+		const uint64_t signal_value { signal ? signal->value : 0 };
+
+		const vk::TimelineSemaphoreSubmitInfo timeline_info(
+			wait_values,
+			signal ? vk::ArrayProxyNoTemporaries<const uint64_t>( signal_value ) : nullptr
+		);
+		const vk::SubmitInfo submit_info(
+			wait_semaphores,
+			wait_stages,
+			buffer ? vk::ArrayProxyNoTemporaries<const vk::CommandBuffer>( buffer ) : nullptr,
+			signal ? vk::ArrayProxyNoTemporaries<const vk::Semaphore>( signal_semaphore ) : nullptr,
+			&timeline_info
+		);
+		queue.submit( submit_info, fence );
+	}
+
+	void TransferEngine::submit( Slot& slot, const std::optional<TimelinePoint>& signal )
+	{
+		if( !slot.recording )
+			return;
+
+		if( slot.used > 0 )
+		{
+			/* make the copies visible to whatever runs next on the device
+				and to the host once the fence signals (transfer-only queues
+				can't name compute stages, hence eAllCommands)*/
+			const vk::MemoryBarrier barrier(
+				vk::AccessFlagBits::eTransferWrite,
+				vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eHostRead
+			);
+			slot.command_buffer.pipelineBarrier(
+				vk::PipelineStageFlagBits::eTransfer,
+				vk::PipelineStageFlagBits::eAllCommands | vk::PipelineStageFlagBits::eHost,
+				{},
+				barrier,
+				nullptr,
+				nullptr
+			);
+		}
+
+		if( slot.span )
+			profiler->end( slot.command_buffer, *slot.span );
+
+		slot.command_buffer.end();
+		slot.recording = false;
+
+		if( slot.used == 0 )
+		{
+			if( slot.span )
+				profiler->discard( *slot.span );
+			slot.span.reset();
+
+			// still signaled, after whatever was submitted before
+			if( signal )
+				queue_submit( nullptr, nullptr, signal );
+			return;
+		}
+		slot.span.reset();
+
+		queue_submit( *slot.command_buffer, *slot.fence, signal );
+		slot.in_flight = true;
+	}
+
+	TransferEngine::Slot& TransferEngine::acquire()
+	{
+		if( auto& slot { slots[current] }; !slot.recording )
+			prepare( slot );
+
+		if( auto& slot { slots[current] }; slot.used < staging_size )
+			return slot;
+
+		submit( slots[current] );
+		current = ( current + 1 ) % slots.size();
+
+		auto& next { slots[current] };
+		prepare( next );
+		return next;
+	}
+
+	void TransferEngine::upload(
+		const Buffer& destination,
+		const std::span<const std::byte> data,
+		const vk::DeviceSize destination_offset )
+	{
+		internal::check_range( destination, destination_offset, data.size() );
+
+		auto remaining { data };
+		vk::DeviceSize offset { destination_offset };
+
+		while( !remaining.empty() )
+		{
+			auto& slot { acquire() };
+			const std::size_t chunk {
+				static_cast< std::size_t >( std::min<vk::DeviceSize>( remaining.size(), staging_size - slot.used ) )
+			};
+
+			std::memcpy( slot.staging.view<std::byte>().data() + slot.used, remaining.data(), chunk );
+			slot.staging.flush( slot.used, chunk );
+
+			if( slot.downloading )
+			{
+				/* the batch's copies may overlap, so one reading a buffer must
+					finish before this one writes it (a write after read, which
+					only needs the execution dependency)*/
+				slot.command_buffer.pipelineBarrier(
+					vk::PipelineStageFlagBits::eTransfer,
+					vk::PipelineStageFlagBits::eTransfer,
+					{},
+					nullptr,
+					nullptr,
+					nullptr
+				);
+				slot.downloading = false;
+			}
+
+			slot.command_buffer.copyBuffer(
+				*slot.staging.buffer,
+				*destination.buffer,
+				vk::BufferCopy( slot.used, offset, chunk )
+			);
+
+			slot.used = std::min( ( slot.used + chunk + internal::staging_alignment - 1 )
+				/ internal::staging_alignment * internal::staging_alignment, staging_size );
+			offset += chunk;
+			remaining = remaining.subspan( chunk );
+		}
+	}
+
+	void TransferEngine::download(
+		const Buffer& source,
+		const std::span<std::byte> data,
+		const vk::DeviceSize source_offset )
+	{
+		internal::check_range( source, source_offset, data.size() );
+
+		auto remaining { data };
+		vk::DeviceSize offset { source_offset };
+
+		while( !remaining.empty() )
+		{
+			auto& slot { acquire() };
+			const std::size_t chunk {
+				static_cast< std::size_t >( std::min<vk::DeviceSize>( remaining.size(), staging_size - slot.used ) )
+			};
+
+			if( !slot.has_downloads )
+			{
+				// earlier shader or copy writes to the source must land before we read it
+				const vk::MemoryBarrier barrier(
+					vk::AccessFlagBits::eMemoryWrite,
+					vk::AccessFlagBits::eTransferRead
+				);
+				slot.command_buffer.pipelineBarrier(
+					vk::PipelineStageFlagBits::eAllCommands,
+					vk::PipelineStageFlagBits::eTransfer,
+					{},
+					barrier,
+					nullptr,
+					nullptr
+				);
+				slot.has_downloads = true;
+			}
+			else if( !slot.downloading )
+			{
+				// uploads recorded since the last download must land before it reads them
+				const vk::MemoryBarrier barrier(
+					vk::AccessFlagBits::eTransferWrite,
+					vk::AccessFlagBits::eTransferRead
+				);
+				slot.command_buffer.pipelineBarrier(
+					vk::PipelineStageFlagBits::eTransfer,
+					vk::PipelineStageFlagBits::eTransfer,
+					{},
+					barrier,
+					nullptr,
+					nullptr
+				);
+			}
+			slot.downloading = true;
+
+			slot.command_buffer.copyBuffer(
+				*source.buffer,
+				*slot.staging.buffer,
+				vk::BufferCopy( offset, slot.used, chunk )
+			);
+			slot.downloads.emplace_back( remaining.first( chunk ), slot.used );
+
+			slot.used = std::min( ( slot.used + chunk + internal::staging_alignment - 1 )
+				/ internal::staging_alignment * internal::staging_alignment, staging_size );
+			offset += chunk;
+			remaining = remaining.subspan( chunk );
+		}
+	}
+
+	void TransferEngine::wait_for( const TimelinePoint& point )
+	{
+		check_timeline();
+		waits.emplace_back( point );
+	}
+
+	void TransferEngine::flush( const std::optional<TimelinePoint>& signal )
+	{
+		if( signal )
+			check_timeline();
+
+		auto& slot { slots[current] };
+		if( slot.recording )
+		{
+			submit( slot, signal );
+			if( slot.in_flight )
+				current = ( current + 1 ) % slots.size();
+		}
+		else if( signal )
+		{
+			// a signal submitted alone still comes after every earlier copy on the queue
+			queue_submit( nullptr, nullptr, signal );
+		}
+		waits.clear();
+	}
+
+	void TransferEngine::wait()
+	{
+		flush();
+
+		constexpr uint64_t timeout { std::numeric_limits<uint64_t>::max() };
+		for( auto& slot : slots )
+		{
+			if( !slot.in_flight )
+				continue;
+
+			std::ignore = context.device.waitForFences( { *slot.fence }, VK_TRUE, timeout );
+			complete( slot );
+		}
+	}
+
+	void TransferEngine::set_profiler( Profiler* profiler_ )
+	{
+		// the recording slot's span belongs to the previous profiler
+		flush();
+
+		const bool usable { profiler_ != nullptr && profiler_->supports( context.transfer_queue_family_index ) };
+		profiler = usable ? profiler_ : nullptr;
+	}
+
+}
@@ -0,0 +1,165 @@
+// Common to the Reduce and Scan kernels: the operation and workgroup wide
+// reduce/scan, through GL_KHR_shader_subgroup_arithmetic when SUBGROUP is
+// defined and through shared memory trees otherwise. Both expect a power
+// of two workgroup size that fills whole subgroups.
+
+// 256 invocations unless specialized (constant id 0)
+layout(local_size_x = 256) in;
+layout(local_size_x_id = 0) in;
+
+// fgl::vulkan::ReduceOperation: 0 sum, 1 min, 2 max
+layout(constant_id = 3) const uint OPERATION = 0;
+// elements per invocation
+layout(constant_id = 4) const uint ITEMS = 4;
+
+const uint OPERATION_SUM = 0;
+const uint OPERATION_MIN = 1;
+
+uint identity()
+{
+    return OPERATION == OPERATION_MIN ? 0xFFFFFFFFu : 0u;
+}
+
+uint combine(uint a, uint b)
+{
+    if(OPERATION == OPERATION_SUM)
+    {
+        return a + b;
+    }
+    return OPERATION == OPERATION_MIN ? min(a, b) : max(a, b);
+}
+
+// one slot per invocation (or per subgroup) plus the workgroup total
+shared uint partials[gl_WorkGroupSize.x + 1];
+
+#ifdef SUBGROUP
+
+uint subgroupCombine(uint value)
+{
+    if(OPERATION == OPERATION_SUM)
+    {
+        return subgroupAdd(value);
+    }
+    return OPERATION == OPERATION_MIN ? subgroupMin(value) : subgroupMax(value);
+}
+
+uint subgroupExclusiveCombine(uint value)
+{
+    if(OPERATION == OPERATION_SUM)
+    {
+        return subgroupExclusiveAdd(value);
+    }
+    return OPERATION == OPERATION_MIN ? subgroupExclusiveMin(value) : subgroupExclusiveMax(value);
+}
+
+uint workgroupReduce(uint value)
+{
+    value = subgroupCombine(value);
+    if(subgroupElect())
+    {
+        partials[gl_SubgroupID] = value;
+    }
+    barrier();
+
+    if(gl_SubgroupID == 0)
+    {
+        uint total = identity();
+        for(uint i = gl_SubgroupInvocationID; i < gl_NumSubgroups; i += gl_SubgroupSize)
+        {
+            total = combine(total, partials[i]);
+        }
+        total = subgroupCombine(total);
+        if(subgroupElect())
+        {
+            partials[gl_WorkGroupSize.x] = total;
+        }
+    }
+    barrier();
+
+    const uint result = partials[gl_WorkGroupSize.x];
+    barrier();
+    return result;
+}
+
+// value combined over every lower invocation of the workgroup; total over all of them
+uint workgroupExclusiveScan(uint value, out uint total)
+{
+    const uint exclusive = subgroupExclusiveCombine(value);
+    if(gl_SubgroupInvocationID == gl_SubgroupSize - 1)
+    {
+        partials[gl_SubgroupID] = combine(exclusive, value);
+    }
+    barrier();
+
+    // exclusive scan of the subgroup totals, a subgroup sized chunk at a time
+    if(gl_SubgroupID == 0)
+    {
+        uint carry = identity();
+        for(uint first = 0; first < gl_NumSubgroups; first += gl_SubgroupSize)
+        {
+            const uint i = first + gl_SubgroupInvocationID;
+            const uint subgroupTotal = i < gl_NumSubgroups ? partials[i] : identity();
+            const uint prefix = combine(carry, subgroupExclusiveCombine(subgroupTotal));
+            carry = combine(carry, subgroupCombine(subgroupTotal));
+            if(i < gl_NumSubgroups)
+            {
+                partials[i] = prefix;
+            }
+        }
+        if(subgroupElect())
+        {
+            partials[gl_WorkGroupSize.x] = carry;
+        }
+    }
+    barrier();
+
+    const uint result = combine(partials[gl_SubgroupID], exclusive);
+    total = partials[gl_WorkGroupSize.x];
+    barrier();
+    return result;
+}
+
+#else
+
+uint workgroupReduce(uint value)
+{
+    const uint local = gl_LocalInvocationIndex;
+    partials[local] = value;
+    barrier();
+
+    for(uint stride = gl_WorkGroupSize.x / 2; stride > 0; stride /= 2)
+    {
+        if(local < stride)
+        {
+            partials[local] = combine(partials[local], partials[local + stride]);
+        }
+        barrier();
+    }
+
+    const uint result = partials[0];
+    barrier();
+    return result;
+}
+
+// Hillis-Steele: log2(workgroup size) steps over shared memory
+uint workgroupExclusiveScan(uint value, out uint total)
+{
+    const uint local = gl_LocalInvocationIndex;
+    partials[local] = value;
+    barrier();
+
+    for(uint offset = 1; offset < gl_WorkGroupSize.x; offset *= 2)
+    {
+        const uint lower = local >= offset ? partials[local - offset] : identity();
+        barrier();
+        partials[local] = combine(lower, partials[local]);
+        barrier();
+    }
+
+    const uint result = local > 0 ? partials[local - 1] : identity();
+    total = partials[gl_WorkGroupSize.x - 1];
+    barrier();
+    return result;
+}
+
+#endif
@@ -0,0 +1,140 @@
+// One pass of a stable LSD radix sort over 4 bit digits (see
+// fgl::vulkan::RadixSort).
+// PHASE 0 counts the digits of each block into
+// histogram[digit * blockCount + block]. Once the histogram is scanned
+// (exclusive), PHASE 1 moves every key to its digit's offset for the block
+// plus its rank among the block's keys with that digit, in input order.
+
+#include "primitives.glsl"
+
+layout(constant_id = 5) const uint PHASE = 0;
+// move a value along with every key
+layout(constant_id = 6) const bool VALUES = false;
+
+const uint RADIX = 16;
+
+// fgl::vulkan::RadixSortParameters
+layout(push_constant) uniform Parameters
+{
+    uint count;
+    uint shift;
+    uint blockCount;
+    uint firstBlock;
+} parameters;
+
+layout(binding = 0) readonly buffer KeysIn
+{
+    uint keysIn[];
+};
+
+layout(binding = 1) writeonly buffer KeysOut
+{
+    uint keysOut[];
+};
+
+layout(binding = 2) buffer Histogram
+{
+    uint histogram[];
+};
+
+layout(binding = 3) readonly buffer ValuesIn
+{
+    uint valuesIn[];
+};
+
+layout(binding = 4) writeonly buffer ValuesOut
+{
+    uint valuesOut[];
+};
+
+shared uint digitCounts[RADIX];
+
+uint digitOf(uint key)
+{
+    return (key >> parameters.shift) & (RADIX - 1);
+}
+
+void countDigits()
+{
+    const uint block = parameters.firstBlock + gl_WorkGroupID.x;
+    if(gl_LocalInvocationIndex < RADIX)
+    {
+        digitCounts[gl_LocalInvocationIndex] = 0;
+    }
+    barrier();
+
+    // order doesn't matter for counting, so neighbouring invocations read neighbouring keys
+    const uint first = block * gl_WorkGroupSize.x * ITEMS + gl_LocalInvocationIndex;
+    for(uint item = 0; item < ITEMS; ++item)
+    {
+        const uint index = first + item * gl_WorkGroupSize.x;
+        if(index < parameters.count)
+        {
+            atomicAdd(digitCounts[digitOf(keysIn[index])], 1);
+        }
+    }
+    barrier();
+
+    if(gl_LocalInvocationIndex < RADIX)
+    {
+        histogram[gl_LocalInvocationIndex * parameters.blockCount + block] = digitCounts[gl_LocalInvocationIndex];
+    }
+}
+
+void scatter()
+{
+    const uint block = parameters.firstBlock + gl_WorkGroupID.x;
+    // ITEMS consecutive keys per invocation keep the ranks in input order
+    const uint first = block * gl_WorkGroupSize.x * ITEMS + gl_LocalInvocationIndex * ITEMS;
+
+    uint keys[ITEMS];
+    uint counts[RADIX];
+    for(uint digit = 0; digit < RADIX; ++digit)
+    {
+        counts[digit] = 0;
+    }
+    for(uint item = 0; item < ITEMS; ++item)
+    {
+        const uint index = first + item;
+        if(index < parameters.count)
+        {
+            keys[item] = keysIn[index];
+            ++counts[digitOf(keys[item])];
+        }
+    }
+
+    // where this invocation's first key of each digit goes
+    uint destinations[RADIX];
+    for(uint digit = 0; digit < RADIX; ++digit)
+    {
+        uint total;
+        const uint lower = workgroupExclusiveScan(counts[digit], total);
+        destinations[digit] = histogram[digit * parameters.blockCount + block] + lower;
+    }
+
+    for(uint item = 0; item < ITEMS; ++item)
+    {
+        const uint index = first + item;
+        if(index < parameters.count)
+        {
+            const uint destination = destinations[digitOf(keys[item])]++;
+            keysOut[destination] = keys[item];
+            if(VALUES)
+            {
+                valuesOut[destination] = valuesIn[index];
+            }
+        }
+    }
+}
+
+void main(void)
+{
+    if(PHASE == 0)
+    {
+        countDigits();
+    }
+    else
+    {
+        scatter();
+    }
+}
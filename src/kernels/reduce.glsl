@@ -0,0 +1,47 @@
+// Reduces each block of ITEMS * workgroup size elements of inData to one
+// element of outData. Repeated over the partials until one is left
+// (see fgl::vulkan::Reduction).
+
+#include "primitives.glsl"
+
+// fgl::vulkan::ReduceParameters, offsets in elements
+layout(push_constant) uniform Parameters
+{
+    uint count;
+    uint inputOffset;
+    uint outputOffset;
+} parameters;
+
+layout(binding = 0) readonly buffer InputBuffer
+{
+    uint inData[];
+};
+
+layout(binding = 1) writeonly buffer OutputBuffer
+{
+    uint outData[];
+};
+
+void main(void)
+{
+    const uint blockSize = gl_WorkGroupSize.x * ITEMS;
+    const uint first = gl_WorkGroupID.x * blockSize + gl_LocalInvocationID.x;
+
+    // neighbouring invocations read neighbouring elements
+    uint value = identity();
+    for(uint item = 0; item < ITEMS; ++item)
+    {
+        const uint index = first + item * gl_WorkGroupSize.x;
+        if(index < parameters.count)
+        {
+            value = combine(value, inData[parameters.inputOffset + index]);
+        }
+    }
+
+    value = workgroupReduce(value);
+
+    if(gl_LocalInvocationIndex == 0)
+    {
+        outData[parameters.outputOffset + gl_WorkGroupID.x] = value;
+    }
+}
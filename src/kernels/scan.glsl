@@ -0,0 +1,97 @@
+// Multi-pass prefix scan (see fgl::vulkan::Scan).
+// PHASE 0 scans each block of ITEMS * workgroup size elements from inData
+// into outData and writes the block's total to sums. Once the sums are
+// scanned (exclusively, by the same kernel), PHASE 1 combines every
+// element of a block with its block's prefix.
+
+#include "primitives.glsl"
+
+layout(constant_id = 5) const uint PHASE = 0;
+
+// fgl::vulkan::ScanParameters, offsets in elements
+layout(push_constant) uniform Parameters
+{
+    uint count;
+    uint inputOffset;
+    uint outputOffset;
+    uint sumsOffset;
+    uint exclusive;
+} parameters;
+
+// inData and outData may be the same elements; each invocation reads its own before writing them
+layout(binding = 0) readonly buffer InputBuffer
+{
+    uint inData[];
+};
+
+layout(binding = 1) buffer OutputBuffer
+{
+    uint outData[];
+};
+
+layout(binding = 2) buffer SumsBuffer
+{
+    uint sums[];
+};
+
+void scanBlock()
+{
+    const uint blockSize = gl_WorkGroupSize.x * ITEMS;
+    const uint first = gl_WorkGroupID.x * blockSize + gl_LocalInvocationID.x * ITEMS;
+
+    // ITEMS consecutive elements per invocation, scanned serially
+    uint scanned[ITEMS];
+    uint running = identity();
+    for(uint item = 0; item < ITEMS; ++item)
+    {
+        const uint index = first + item;
+        const uint value = index < parameters.count ? inData[parameters.inputOffset + index] : identity();
+        scanned[item] = parameters.exclusive != 0 ? running : combine(running, value);
+        running = combine(running, value);
+    }
+
+    uint total;
+    const uint prefix = workgroupExclusiveScan(running, total);
+
+    for(uint item = 0; item < ITEMS; ++item)
+    {
+        const uint index = first + item;
+        if(index < parameters.count)
+        {
+            outData[parameters.outputOffset + index] = combine(prefix, scanned[item]);
+        }
+    }
+
+    if(gl_LocalInvocationIndex == 0)
+    {
+        sums[parameters.sumsOffset + gl_WorkGroupID.x] = total;
+    }
+}
+
+void addBlockPrefix()
+{
+    const uint blockSize = gl_WorkGroupSize.x * ITEMS;
+    const uint first = gl_WorkGroupID.x * blockSize + gl_LocalInvocationID.x;
+    const uint prefix = sums[parameters.sumsOffset + gl_WorkGroupID.x];
+
+    for(uint item = 0; item < ITEMS; ++item)
+    {
+        const uint index = first + item * gl_WorkGroupSize.x;
+        if(index < parameters.count)
+        {
+            outData[parameters.outputOffset + index] = combine(prefix, outData[parameters.outputOffset + index]);
+        }
+    }
+}
+
+void main(void)
+{
+    if(PHASE == 0)
+    {
+        scanBlock();
+    }
+    else
+    {
+        addBlockPrefix();
+    }
+}
@@ -7,6 +7,8 @@
 #include <filesystem>
 #include <fstream>
 #include <bitset>
+#include <span>
+#include <vector>
 
 #include <string_view>
 #include <iostream> // cout, cerr, endl
@@ -17,23 +19,11 @@
 
 #include <fgl/vulkan.hpp>
 
-#include <fgl/types/range_wrapper.hpp>
-
-// could use StructureChain, but it would be more verbose?
-// https://github.com/KhronosGroup/Vulkan-Hpp/search?q=StructureChain
-
-auto create_waitable_fence(
-	const vk::raii::Device& device,
-	const vk::raii::CommandBuffer& command_buffer,
-	const uint32_t queue_family_index,
-	const uint32_t queue_index = 0 )
+// Square.comp's push constant block
+struct SquareParameters
 {
-	vk::raii::Fence fence { device.createFence( {} ) };
-	const vk::raii::Queue queue { device.getQueue( queue_family_index, queue_index ) };
-	const vk::SubmitInfo submit_info( nullptr, nullptr, *command_buffer, nullptr );
-	queue.submit( submit_info, *fence );
-	return fence;
-}
+	uint32_t matrixsize;
+};
 
 int main() try
 {
@@ -44,36 +34,25 @@ int main() try
 		VK_API_VERSION_1_1,
 		{ "VK_LAYER_KHRONOS_validation" },
 		{},
-		1,
-		0.0
+		0, // every queue of every compute/transfer family
+		0.0,
+		"pipeline.cache"
 	);
 
 	fgl::vulkan::Context inst( info );
 	inst.print_debug_info();
 
 	constexpr size_t elements = 512;
-	constexpr vk::DeviceSize insize = elements * sizeof( uint32_t ) + sizeof( uint32_t );
+	constexpr vk::DeviceSize insize = elements * sizeof( uint32_t );
 	constexpr vk::DeviceSize outsize = ( elements * elements ) * sizeof( uint32_t );
-	constexpr size_t invocationsPerDispatch = 2;
-	constexpr size_t dispatchNum = elements / invocationsPerDispatch;
-
-	//TODO: Add some security checks to ensure we are not dispatching too many calls and allocating too much memory
-
-	//assert( invocationsPerDispatch * invocationsPerDispatch < inst.properties.limits.maxComputeWorkGroupInvocations ); //Too many invocationsPerDispatch
-
-	if( invocationsPerDispatch * invocationsPerDispatch >= inst.properties.limits.maxComputeWorkGroupInvocations )
-	{
-		throw std::runtime_error( "Too many invocations per dispatch. Lower the elements count" );
-	}
 
-	//assert( totalsize < inst.properties.limits.maxMemoryAllocationCount ); //Too many elements allocated
+	// starting workgroup size for Square.comp; the autotuner below picks the final one
+	const auto workgroup { fgl::vulkan::preferred_workgroup_size( inst, 2 ) };
 
-	if( dispatchNum >= inst.properties.limits.maxComputeWorkGroupCount.front() )
-	{
-		throw std::runtime_error( "dispatch number is too high for supported GPU. Lower the elements count" );
-	}
+	fgl::vulkan::Specialization specialization;
+	specialization.workgroup_size( workgroup[0], workgroup[1] );
 
-	//assert( dispatchNum < inst.properties.limits.maxComputeWorkGroupCount.front() );
+	//TODO: Add some security checks to ensure we are not allocating too much memory
 
 	//Allocate a single memory segment for the buffers being passed in
 	/*
@@ -101,62 +80,135 @@ int main() try
 	*/
 
 
-	constexpr vk::MemoryPropertyFlags flags = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent;
+	//The kernel runs out of VRAM; data is streamed in and out through the TransferEngine's staging ring.
+	constexpr vk::MemoryPropertyFlags flags = vk::MemoryPropertyFlagBits::eDeviceLocal;
 
 	std::vector<fgl::vulkan::Buffer> buffers;
 	buffers.reserve( 2 );
 
 	//binding : set
 
-	buffers.emplace_back( inst, insize, vk::BufferUsageFlagBits::eStorageBuffer, vk::SharingMode::eExclusive, 0, flags, vk::DescriptorType::eStorageBuffer );
-	buffers.emplace_back( inst, outsize, vk::BufferUsageFlagBits::eStorageBuffer, vk::SharingMode::eExclusive, 1, flags, vk::DescriptorType::eStorageBuffer );
+	//Concurrent so the transfer queue family can copy without ownership transfers
+	buffers.emplace_back( inst, insize, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst, vk::SharingMode::eConcurrent, 0, flags, vk::DescriptorType::eStorageBuffer );
+	buffers.emplace_back( inst, outsize, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferSrc, vk::SharingMode::eConcurrent, 1, flags, vk::DescriptorType::eStorageBuffer );
 
+	// declared before the transfer engine, which records into it until destroyed
+	fgl::vulkan::Profiler profiler( inst );
 
-	fgl::vulkan::Pipeline vpipeline( inst, std::filesystem::path( "Square.spv" ), std::string( "main" ), buffers );
+	fgl::vulkan::TransferEngine transfer( inst );
+	transfer.set_profiler( &profiler );
 
-	{
-		auto& fglbuffer { buffers.at( 0 ) };
 
-		uint32_t* const in_buffer_data {
-				reinterpret_cast< uint32_t* > ( fglbuffer.get_memory() )
-		};
+	fgl::vulkan::PipelineRegistry registry;
+	registry.add( "square", inst, std::filesystem::path( "Square.spv" ), std::string( "main" ), buffers, fgl::vulkan::push_constant_size<SquareParameters>, specialization );
+	registry.compile_all();
+	registry.print_compile_times();
 
-		in_buffer_data[0] = elements; // matrix size
+	const fgl::vulkan::Pipeline& vpipeline { registry.get( "square" ) };
+	mainwatch.lap(); // setup
 
-		auto matrix { fgl::make_range( &in_buffer_data[1], elements ) };
+	{
+		std::vector<uint32_t> in_buffer_data( elements );
 
-		for( uint32_t i { 0 }; auto & element : matrix )
+		for( uint32_t i { 0 }; auto & element : in_buffer_data )
 		{
 			element = i++;
 		}
 
 		/*
 		std::cout << "Input Buffer:" << std::endl;
-		for(auto element : matrix)
+		for(auto element : in_buffer_data)
 		{
 			std::cout << std::setw( 5 ) << element << " ";
 		}
 		std::cout << std::endl;
 		//*/
 
-		fglbuffer.memory.unmapMemory();
+		transfer.upload( buffers.at( 0 ), std::span<const uint32_t>( in_buffer_data ) );
+		transfer.wait();
 	}
+	mainwatch.lap(); // upload
 
-	const fgl::vulkan::CommandQueue command(
-		inst,
-		vpipeline,
-		vk::CommandBufferUsageFlagBits::eOneTimeSubmit,
-		dispatchNum,
-		dispatchNum
-	);
+	// pushed with every dispatch, so the input buffer holds nothing but the matrix
+	const SquareParameters parameters { elements };
+	const auto push_constants { fgl::vulkan::push_constant_bytes( parameters ) };
 
-	const auto fence { create_waitable_fence( inst.device, command.buffer, inst.queue_family_index ) };
-	constexpr uint64_t timeout { 5 };
-	while( vk::Result::eTimeout == inst.device.waitForFences( { *fence }, VK_TRUE, timeout ) );
+	// the kernel only writes the output buffer, so tuning on the real buffers is harmless
+	fgl::vulkan::Autotuner tuner( inst, "tuning.db" );
+	const auto tuned { tuner.tune( "square", vpipeline, { elements, elements, 1 }, push_constants ) };
+	const auto groups { fgl::vulkan::group_count( { elements, elements, 1 }, tuned ) };
+
+	fgl::vulkan::Specialization tuned_specialization { vpipeline.specialization };
+	tuned_specialization.workgroup_size( tuned[0], tuned[1], tuned[2] );
+	mainwatch.lap(); // tuning
+
+	fgl::vulkan::QueueScheduler scheduler( inst );
+	scheduler.submit(
+		[&]( const vk::raii::CommandBuffer& buffer )
+		{
+			const uint32_t span { profiler.begin( buffer, "square" ) };
+			fgl::vulkan::record_dispatch( buffer, vpipeline, tuned_specialization, groups[0], groups[1], groups[2], push_constants );
+			profiler.end( buffer, span );
+		}
+	).wait();
+	scheduler.print_lanes();
+	mainwatch.lap(); // compute
+
+	std::vector<uint32_t> out_buffer_data( elements * elements );
+	transfer.download( buffers.at( 1 ), std::span( out_buffer_data ) );
+	transfer.wait();
+	mainwatch.lap(); // download
+
+	/// ITERATIONS
+	{
+		// input i + k for iteration k, uploaded and read back through a triple buffered ring
+		constexpr uint32_t iterations { 16 };
+		const std::array<fgl::vulkan::FrameBufferInfo, 2> layout { {
+			{ 0, insize, fgl::vulkan::FrameTransfer::eUpload },
+			{ 1, outsize, fgl::vulkan::FrameTransfer::eDownload }
+		} };
+		fgl::vulkan::FrameRing ring( inst, layout );
+
+		bool matches { true };
+		const auto check {
+			[&]( const fgl::vulkan::FrameRing::Frame& frame )
+			{
+				const auto k { static_cast< uint32_t >( *frame.completed_iteration() ) };
+				const auto out { frame.readback_view<uint32_t>( 1 ) };
+				const uint32_t last { static_cast< uint32_t >( elements ) - 1 + k };
+				matches = matches && out.front() == k * k && out.back() == last * last;
+			}
+		};
+
+		for( uint32_t k { 0 }; k < iterations; ++k )
+		{
+			// iteration k - depth, done while k - depth + 1 and on are still running
+			auto& frame { ring.acquire() };
+			if( frame.completed_iteration() )
+				check( frame );
+
+			for( uint32_t i { 0 }; auto& element : frame.upload_view<uint32_t>( 0 ) )
+				element = i++ + k;
+
+			ring.submit(
+				frame,
+				[&]( const vk::raii::CommandBuffer& buffer, const fgl::vulkan::FrameRing::Frame& current )
+				{
+					const uint32_t span { profiler.begin( buffer, "square (ring)" ) };
+					fgl::vulkan::record_dispatch( buffer, vpipeline, tuned_specialization, ring.descriptor_set( vpipeline, current ), groups[0], groups[1], groups[2], push_constants );
+					profiler.end( buffer, span );
+				}
+			);
+		}
+		ring.drain( check );
+
+		std::cout << '\n' << iterations << " iterations over " << ring.depth() << " frames " << ( matches ? "match" : "DO NOT MATCH" ) << std::endl;
+	}
+	mainwatch.lap(); // iterations
 
 	/// PRINT
 	/*
-	auto out_buffer_ptr = reinterpret_cast< uint32_t* >( buffers.at( 1 ).get_memory() );
+	const auto& out_buffer_ptr { out_buffer_data };
 	std::cout << "Output Buffer:" << std::endl;
 	for( size_t y = 0; y < elements; ++y )// spammy...
 	{
@@ -167,11 +219,15 @@ int main() try
 		}
 		std::cout << "\n\n" << std::endl;
 	}
-	buffers.at( 1 ).memory.unmapMemory();
 	//*/
 
 	mainwatch.stop();
 	std::cout << '\n' << mainwatch << std::endl;
+
+	profiler.resolve();
+	profiler.add_stopwatch( mainwatch );
+	profiler.print_statistics();
+	profiler.write_chrome_trace( "trace.json" );
 }
 catch( const vk::SystemError& e )
 {
@@ -82,6 +82,18 @@ public:
 	std::string_view getName() const
 	{ return m_name; }
 
+	[[nodiscard]]
+	std::chrono::time_point<clock> getStart() const noexcept
+	{ return m_start; }
+
+	[[nodiscard]]
+	std::chrono::time_point<clock> getStop() const noexcept
+	{ return m_stop; }
+
+	[[nodiscard]]
+	const std::vector<std::chrono::time_point<clock>>& getLaps() const noexcept
+	{ return m_laps; }
+
 	void lap()
 	{
 		if (m_start == m_unset)